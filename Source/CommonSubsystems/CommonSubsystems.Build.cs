@@ -21,6 +21,7 @@ public class CommonSubsystems : ModuleRules
 				"CoreUObject",
 				"Engine",
 				"EngineSettings",
+				"Json",
 			}
 		);
 
@@ -2,4 +2,8 @@
 
 #include "CommonSubsystems.h"
 
+#include "CommonSubsystemsStats.h"
+
+CSV_DEFINE_CATEGORY(CommonSubsystems, true);
+
 IMPLEMENT_MODULE(FDefaultModuleImpl, CommonSubsystems)
@@ -0,0 +1,11 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CommonSubsystems.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("CommonSubsystems"), STATGROUP_CommonSubsystems, STATCAT_Advanced);
+
+CSV_DECLARE_CATEGORY_EXTERN(CommonSubsystems);
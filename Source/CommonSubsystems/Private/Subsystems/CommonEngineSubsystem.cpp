@@ -1,3 +1,25 @@
 // Author: Antonio Sidenko (Tonetfal), July 2023
 
 #include "Subsystems/CommonEngineSubsystem.h"
+
+void UCommonEngineSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCommonSubsystemCache::Get().Register(*this, UCommonEngineSubsystem::StaticClass());
+}
+
+void UCommonEngineSubsystem::Deinitialize()
+{
+	// Overrides that tear down anything borrowers might use have closed it already
+	CloseLifetime();
+
+	Super::Deinitialize();
+
+	FCommonSubsystemCache::Get().Unregister(*this);
+}
+
+void UCommonEngineSubsystem::CloseLifetime()
+{
+	FCommonSubsystemCache::Get().CloseLifetime(*this);
+}
@@ -1,3 +1,54 @@
 // Author: Antonio Sidenko (Tonetfal), July 2023
 
 #include "Subsystems/CommonGameInstanceSubsystem.h"
+
+void UCommonGameInstanceSubsystem::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	// Subclass' own containers aren't visible to the property based count
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetAllocatedSize());
+}
+
+void UCommonGameInstanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCommonSubsystemCache::Get().Register(*this, UCommonGameInstanceSubsystem::StaticClass());
+}
+
+void UCommonGameInstanceSubsystem::Deinitialize()
+{
+	// Overrides that tear down anything borrowers might use have closed it already
+	CloseLifetime();
+
+	Super::Deinitialize();
+
+	FCommonSubsystemCache::Get().Unregister(*this);
+}
+
+bool UCommonGameInstanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// The game instance's manager creates it on first use instead
+	if (bCreateOnFirstUse && !FCommonLazySubsystemSet::IsEvaluating())
+	{
+		return false;
+	}
+
+	return Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UCommonGameInstanceSubsystem::IsCreatedOnFirstUse() const
+{
+	return bCreateOnFirstUse;
+}
+
+void UCommonGameInstanceSubsystem::CloseLifetime()
+{
+	FCommonSubsystemCache::Get().CloseLifetime(*this);
+}
+
+SIZE_T UCommonGameInstanceSubsystem::GetAllocatedSize() const
+{
+	return 0;
+}
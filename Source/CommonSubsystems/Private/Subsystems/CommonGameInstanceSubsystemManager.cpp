@@ -0,0 +1,82 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonGameInstanceSubsystemManager.h"
+
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Subsystems/CommonGameInstanceSubsystem.h"
+
+UCommonGameInstanceSubsystemManager* UCommonGameInstanceSubsystemManager::Get(const UObject* ContextObject)
+{
+	if (!IsValid(ContextObject))
+	{
+		return nullptr;
+	}
+
+	const UWorld* World = ContextObject->GetWorld();
+	if (!IsValid(World))
+	{
+		return nullptr;
+	}
+
+	const UGameInstance* GameInstance = World->GetGameInstance();
+	if (!IsValid(GameInstance))
+	{
+		return nullptr;
+	}
+
+	auto* Manager = GameInstance->GetSubsystem<UCommonGameInstanceSubsystemManager>();
+	return Manager;
+}
+
+void UCommonGameInstanceSubsystemManager::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	auto* This = CastChecked<ThisClass>(InThis);
+	This->LazySubsystems.AddReferencedObjects(Collector);
+}
+
+void UCommonGameInstanceSubsystemManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	EventBus = MakeUnique<FCommonEventBus>();
+
+	UGameInstance* GameInstance = GetGameInstance();
+	check(IsValid(GameInstance));
+
+	LazySubsystems.Initialize(*GameInstance, Collection, UCommonGameInstanceSubsystem::StaticClass(),
+		[](const USubsystem& DefaultObject)
+		{
+			const bool bIsCreatedOnFirstUse =
+				CastChecked<UCommonGameInstanceSubsystem>(&DefaultObject)->IsCreatedOnFirstUse();
+			return bIsCreatedOnFirstUse;
+		});
+}
+
+void UCommonGameInstanceSubsystemManager::Deinitialize()
+{
+	Super::Deinitialize();
+
+	LazySubsystems.Deinitialize();
+
+	EventBus.Reset();
+}
+
+bool UCommonGameInstanceSubsystemManager::CanCreateLazySubsystem(const UClass* Class) const
+{
+	return LazySubsystems.CanCreate(Class);
+}
+
+UCommonGameInstanceSubsystem* UCommonGameInstanceSubsystemManager::FindOrCreateLazySubsystem(const UClass* Class)
+{
+	bool bWasCreated = false;
+	auto* Subsystem = Cast<UCommonGameInstanceSubsystem>(LazySubsystems.FindOrCreate(Class, OUT bWasCreated));
+	return Subsystem;
+}
+
+FCommonEventBus* UCommonGameInstanceSubsystemManager::GetEventBus() const
+{
+	return EventBus.Get();
+}
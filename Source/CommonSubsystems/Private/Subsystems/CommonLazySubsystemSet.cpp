@@ -0,0 +1,133 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonLazySubsystemSet.h"
+
+#include "Subsystems/CommonSubsystemMemory.h"
+#include "UObject/UObjectHash.h"
+
+static bool GIsEvaluatingLazySubsystems = false;
+
+bool FCommonLazySubsystemSet::IsEvaluating()
+{
+	return GIsEvaluatingLazySubsystems;
+}
+
+void FCommonLazySubsystemSet::Initialize(UObject& InOwner, FSubsystemCollectionBase& InCollection,
+	const UClass* BaseClass, TFunctionRef<bool(const USubsystem& DefaultObject)> IsCreatedOnFirstUse)
+{
+	check(IsInGameThread());
+	check(!bIsInitialized);
+
+	Owner = &InOwner;
+	Collection = &InCollection;
+	bIsInitialized = true;
+
+	TArray<UClass*> DerivedClasses;
+	GetDerivedClasses(BaseClass, DerivedClasses);
+
+	TGuardValue<bool> EvaluatingGuard(GIsEvaluatingLazySubsystems, true);
+
+	for (UClass* Class : DerivedClasses)
+	{
+		if (Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists))
+		{
+			continue;
+		}
+
+		const auto* DefaultObject = CastChecked<USubsystem>(Class->GetDefaultObject());
+		if (IsCreatedOnFirstUse(*DefaultObject) && DefaultObject->ShouldCreateSubsystem(Owner))
+		{
+			PendingClasses.Add(Class);
+		}
+	}
+}
+
+void FCommonLazySubsystemSet::Deinitialize()
+{
+	check(IsInGameThread());
+
+	bIsInitialized = false;
+	PendingClasses.Reset();
+
+	// Dependencies are created first, so they're deinitialized last
+	while (!Subsystems.IsEmpty())
+	{
+		USubsystem* Subsystem = Subsystems.Pop();
+		Subsystem->Deinitialize();
+	}
+
+	Owner = nullptr;
+	Collection = nullptr;
+}
+
+bool FCommonLazySubsystemSet::CanCreate(const UClass* Class) const
+{
+	for (const UClass* PendingClass : PendingClasses)
+	{
+		if (PendingClass->IsChildOf(Class))
+		{
+			return true;
+		}
+	}
+
+	for (const USubsystem* Subsystem : Subsystems)
+	{
+		if (Subsystem->IsA(Class))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+USubsystem* FCommonLazySubsystemSet::FindOrCreate(const UClass* Class, bool& bOutWasCreated)
+{
+	check(IsInGameThread());
+
+	bOutWasCreated = false;
+
+	if (!bIsInitialized)
+	{
+		return nullptr;
+	}
+
+	for (USubsystem* Subsystem : Subsystems)
+	{
+		if (Subsystem->IsA(Class))
+		{
+			return Subsystem;
+		}
+	}
+
+	const int32 PendingIndex = PendingClasses.IndexOfByPredicate([Class](const UClass* PendingClass)
+	{
+		return PendingClass->IsChildOf(Class);
+	});
+
+	if (PendingIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	UClass* SubsystemClass = PendingClasses[PendingIndex];
+	PendingClasses.RemoveAtSwap(PendingIndex);
+
+	// Memory the subsystem allocates on creation belongs to it rather than to whoever has used it first
+	COMMON_SUBSYSTEMS_LLM_SCOPE("LazyCreation", SubsystemClass->GetFName());
+
+	// Register before initializing, so that subsystems initializing this one on their first use find it
+	auto* Subsystem = NewObject<USubsystem>(Owner, SubsystemClass);
+	Subsystems.Add(Subsystem);
+
+	Subsystem->Initialize(*Collection);
+
+	bOutWasCreated = true;
+	return Subsystem;
+}
+
+void FCommonLazySubsystemSet::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(PendingClasses);
+	Collector.AddReferencedObjects(Subsystems);
+}
@@ -2,6 +2,157 @@
 
 #include "Subsystems/CommonLocalPlayerSubsystem.h"
 
+#include "Subsystems/Components/CommonTickComponent.h"
+
+namespace CommonLocalPlayerSubsystem
+{
+	using FInstanceKey = TPair<const UGameInstance*, const UClass*>;
+
+	/**
+	 * Ticks all the instances of a subsystem class in a game instance through a single callback.
+	 */
+	struct FAllInstancesTicker
+		: public FCommonTickComponent
+	{
+	public:
+		FAllInstancesTicker(const UClass& InClass, float InTickInterval)
+			: Class(&InClass)
+		{
+			bStartWithTickEnabled = true;
+			TickInterval = InTickInterval;
+
+			Tick_Initialize(FTickSignature::CreateRaw(this, &FAllInstancesTicker::Tick));
+		}
+
+		//~FCommonTickComponent Interface
+		virtual FString GetTickDebugName() const override
+		{
+			const FString Result = FString::Printf(TEXT("%s (All Local Players)"), *GetNameSafe(Class));
+			return Result;
+		}
+		//~End of FCommonTickComponent Interface
+
+	private:
+		void Tick(float DeltaSeconds)
+		{
+			if (Instances.IsEmpty())
+			{
+				return;
+			}
+
+			UCommonLocalPlayerSubsystem* FirstInstance = Instances[0];
+			FirstInstance->TickAllInstances(DeltaSeconds, Instances);
+		}
+
+	public:
+		/** Class whose instances are ticked. */
+		const UClass* Class = nullptr;
+
+		/** Instances of the class, ordered by local player index. */
+		TArray<UCommonLocalPlayerSubsystem*> Instances;
+	};
+
+	/** Instances of each class, and of each of its super classes, per game instance. */
+	static TMap<FInstanceKey, TArray<UCommonLocalPlayerSubsystem*>> InstanceLists;
+
+	/** Tickers of the classes whose instances tick together, per game instance. */
+	static TMap<FInstanceKey, TUniquePtr<FAllInstancesTicker>> Tickers;
+
+	/**
+	 * Insert a subsystem in a list, keeping it ordered by local player index.
+	 * @param	List list to insert the subsystem in.
+	 * @param	Subsystem subsystem to insert.
+	 */
+	static void InsertSorted(TArray<UCommonLocalPlayerSubsystem*>& List, UCommonLocalPlayerSubsystem& Subsystem)
+	{
+		List.Add(&Subsystem);
+		List.Sort([](const UCommonLocalPlayerSubsystem& Lhs, const UCommonLocalPlayerSubsystem& Rhs)
+		{
+			return Lhs.GetLocalPlayerIndex() < Rhs.GetLocalPlayerIndex();
+		});
+	}
+}
+
+void UCommonLocalPlayerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCommonSubsystemCache::Get().Register(*this, UCommonLocalPlayerSubsystem::StaticClass());
+
+	const auto* LocalPlayer = GetLocalPlayer<ULocalPlayer>();
+	check(IsValid(LocalPlayer));
+
+	RegisteredGameInstance = LocalPlayer->GetGameInstance();
+	if (!IsValid(RegisteredGameInstance))
+	{
+		return;
+	}
+
+	using namespace CommonLocalPlayerSubsystem;
+
+	for (const UClass* Class = GetClass(); Class != UCommonLocalPlayerSubsystem::StaticClass();
+		Class = Class->GetSuperClass())
+	{
+		auto& List = InstanceLists.FindOrAdd(FInstanceKey(RegisteredGameInstance, Class));
+		InsertSorted(List, *this);
+	}
+
+	if (bTickAllInstancesTogether)
+	{
+		auto& Ticker = Tickers.FindOrAdd(FInstanceKey(RegisteredGameInstance, GetClass()));
+		if (!Ticker.IsValid())
+		{
+			Ticker = MakeUnique<FAllInstancesTicker>(*GetClass(), AllInstancesTickInterval);
+		}
+
+		InsertSorted(Ticker->Instances, *this);
+	}
+}
+
+void UCommonLocalPlayerSubsystem::Deinitialize()
+{
+	// Overrides that tear down anything borrowers might use have closed it already
+	CloseLifetime();
+
+	Super::Deinitialize();
+
+	FCommonSubsystemCache::Get().Unregister(*this);
+
+	if (!RegisteredGameInstance)
+	{
+		return;
+	}
+
+	using namespace CommonLocalPlayerSubsystem;
+
+	for (const UClass* Class = GetClass(); Class != UCommonLocalPlayerSubsystem::StaticClass();
+		Class = Class->GetSuperClass())
+	{
+		const FInstanceKey Key(RegisteredGameInstance, Class);
+		if (auto* List = InstanceLists.Find(Key))
+		{
+			// Keep the order, the list is sorted by local player index
+			List->Remove(this);
+			if (List->IsEmpty())
+			{
+				InstanceLists.Remove(Key);
+			}
+		}
+	}
+
+	const FInstanceKey TickerKey(RegisteredGameInstance, GetClass());
+	if (const auto* Ticker = Tickers.Find(TickerKey))
+	{
+		(*Ticker)->Instances.Remove(this);
+		if ((*Ticker)->Instances.IsEmpty())
+		{
+			Tickers.Remove(TickerKey);
+		}
+	}
+
+	RegisteredGameInstance = nullptr;
+}
+
 int32 UCommonLocalPlayerSubsystem::GetLocalPlayerIndex() const
 {
 	const auto* LocalPlayer = GetLocalPlayer<ULocalPlayer>();
@@ -10,3 +161,29 @@ int32 UCommonLocalPlayerSubsystem::GetLocalPlayerIndex() const
 	const int32 Index = LocalPlayer->GetLocalPlayerIndex();
 	return Index;
 }
+
+TConstArrayView<UCommonLocalPlayerSubsystem*> UCommonLocalPlayerSubsystem::GetInstancesOfClass(
+	const UGameInstance* GameInstance, const UClass* Class)
+{
+	check(IsInGameThread());
+
+	const auto* List = CommonLocalPlayerSubsystem::InstanceLists.Find(
+		CommonLocalPlayerSubsystem::FInstanceKey(GameInstance, Class));
+	if (!List)
+	{
+		return {};
+	}
+
+	return *List;
+}
+
+void UCommonLocalPlayerSubsystem::CloseLifetime()
+{
+	FCommonSubsystemCache::Get().CloseLifetime(*this);
+}
+
+void UCommonLocalPlayerSubsystem::TickAllInstances(float DeltaSeconds,
+	TConstArrayView<UCommonLocalPlayerSubsystem*> Instances)
+{
+	// Empty
+}
@@ -0,0 +1,395 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonStartupProfiler.h"
+
+#if COMMON_SUBSYSTEMS_WITH_STARTUP_PROFILER
+
+#include "Algo/Sort.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "LogCategories.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+static bool GCommonStartupProfilerEnabled = false;
+static FAutoConsoleVariableRef CVarCommonStartupProfilerEnabled(
+	TEXT("CommonSubsystems.Startup.Profile"),
+	GCommonStartupProfilerEnabled,
+	TEXT("If true, time and memory world subsystems spend in ShouldCreateSubsystem, Initialize, PostInitWorld and ")
+	TEXT("OnWorldInitialized are recorded per world. Memory stats are queried on every phase, which is slow on some ")
+	TEXT("platforms, so it's off by default."));
+
+static bool GCommonStartupProfilerDumpOnMapLoad = false;
+static FAutoConsoleVariableRef CVarCommonStartupProfilerDumpOnMapLoad(
+	TEXT("CommonSubsystems.Startup.DumpOnMapLoad"),
+	GCommonStartupProfilerDumpOnMapLoad,
+	TEXT("If true, the startup report of each loaded map is written as CSV to the profiling directory."));
+
+static int32 GCommonStartupProfilerMaxReports = 8;
+static FAutoConsoleVariableRef CVarCommonStartupProfilerMaxReports(
+	TEXT("CommonSubsystems.Startup.MaxReports"),
+	GCommonStartupProfilerMaxReports,
+	TEXT("Number of world startup reports to keep. The oldest ones are discarded first."));
+
+static const TCHAR* GetPhaseName(ECommonStartupPhase Phase)
+{
+	switch (Phase)
+	{
+	case ECommonStartupPhase::ShouldCreateSubsystem:
+		return TEXT("ShouldCreateSubsystem");
+	case ECommonStartupPhase::Initialize:
+		return TEXT("Initialize");
+	case ECommonStartupPhase::PostInitWorld:
+		return TEXT("PostInitWorld");
+	case ECommonStartupPhase::OnWorldInitialized:
+		return TEXT("OnWorldInitialized");
+	default:
+		checkNoEntry();
+		return TEXT("");
+	}
+}
+
+static constexpr int32 NumPhases = static_cast<int32>(ECommonStartupPhase::MAX);
+
+double FCommonStartupProfiler::FRecord::GetTotalSeconds() const
+{
+	double TotalSeconds = 0.0;
+	for (const double PhaseSeconds : Seconds)
+	{
+		TotalSeconds += PhaseSeconds;
+	}
+
+	return TotalSeconds;
+}
+
+int64 FCommonStartupProfiler::FRecord::GetTotalMemoryBytes() const
+{
+	int64 TotalMemoryBytes = 0;
+	for (const int64 PhaseMemoryBytes : MemoryBytes)
+	{
+		TotalMemoryBytes += PhaseMemoryBytes;
+	}
+
+	return TotalMemoryBytes;
+}
+
+FCommonStartupProfiler::FScope::FScope(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase)
+{
+	FCommonStartupProfiler& Profiler = FCommonStartupProfiler::Get();
+	Profiler.EndOpenPhase();
+	bIsRecording = Profiler.PushPhase(Subsystem, World, Phase);
+}
+
+FCommonStartupProfiler::FScope::~FScope()
+{
+	if (bIsRecording)
+	{
+		FCommonStartupProfiler& Profiler = FCommonStartupProfiler::Get();
+		Profiler.EndOpenPhase();
+		Profiler.PopPhase();
+	}
+}
+
+FCommonStartupProfiler& FCommonStartupProfiler::Get()
+{
+	static FCommonStartupProfiler Instance;
+	return Instance;
+}
+
+FCommonStartupProfiler::FCommonStartupProfiler()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FCommonStartupProfiler::OnPostLoadMapWithWorld);
+
+	// All world subsystems are initialized by then, so make sure the last open phase doesn't last any longer
+	FWorldDelegates::OnPostWorldInitialization.AddLambda([this](UWorld*, const UWorld::InitializationValues)
+	{
+		EndOpenPhase();
+	});
+}
+
+void FCommonStartupProfiler::PrintReports(FOutputDevice& Ar, bool bAllReports) const
+{
+	if (Reports.IsEmpty())
+	{
+		Ar.Log(TEXT("No world startup reports have been recorded."));
+		return;
+	}
+
+	if (!bAllReports)
+	{
+		PrintReport(Reports.Last(), Ar);
+		return;
+	}
+
+	for (const FReport& Report : Reports)
+	{
+		PrintReport(Report, Ar);
+	}
+}
+
+FString FCommonStartupProfiler::DumpReport(const UWorld* World) const
+{
+	const FReport* Report = FindReport(World);
+	if (!Report)
+	{
+		return FString();
+	}
+
+	FString Csv = TEXT("Class");
+	for (int32 PhaseIndex = 0; PhaseIndex < NumPhases; PhaseIndex++)
+	{
+		const TCHAR* PhaseName = GetPhaseName(static_cast<ECommonStartupPhase>(PhaseIndex));
+		Csv += FString::Printf(TEXT(",%sMs,%sKiB"), PhaseName, PhaseName);
+	}
+	Csv += TEXT(",TotalMs,TotalKiB\n");
+
+	for (const FRecord* Record : GetSortedRecords(*Report))
+	{
+		Csv += Record->ClassName.ToString();
+		for (int32 PhaseIndex = 0; PhaseIndex < NumPhases; PhaseIndex++)
+		{
+			Csv += FString::Printf(TEXT(",%f,%f"), Record->Seconds[PhaseIndex] * 1000.0,
+				static_cast<double>(Record->MemoryBytes[PhaseIndex]) / 1024.0);
+		}
+		Csv += FString::Printf(TEXT(",%f,%f\n"), Record->GetTotalSeconds() * 1000.0,
+			static_cast<double>(Record->GetTotalMemoryBytes()) / 1024.0);
+	}
+
+	const FString FileName = FPaths::ProfilingDir() / TEXT("CommonSubsystems") /
+		FString::Printf(TEXT("Startup-%s-%s.csv"), *Report->MapName, *Report->StartTime.ToString());
+
+	if (!FFileHelper::SaveStringToFile(Csv, *FileName))
+	{
+		UE_LOG(LogCommonSubsystems, Warning, TEXT("Failed to write startup report to [%s]."), *FileName);
+		return FString();
+	}
+
+	UE_LOG(LogCommonSubsystems, Display, TEXT("Startup report of [%s] has been written to [%s]."), *Report->MapName,
+		*FileName);
+
+	return FileName;
+}
+
+void FCommonStartupProfiler::BeginOpenPhase(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase)
+{
+	EndOpenPhase();
+	bHasOpenPhase = PushPhase(Subsystem, World, Phase);
+}
+
+void FCommonStartupProfiler::EndOpenPhase()
+{
+	if (bHasOpenPhase)
+	{
+		bHasOpenPhase = false;
+		PopPhase();
+	}
+}
+
+bool FCommonStartupProfiler::PushPhase(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase)
+{
+	if (!GCommonStartupProfilerEnabled || !IsInGameThread() || !IsValid(World))
+	{
+		return false;
+	}
+
+	FScopeFrame& Frame = ScopeStack.AddDefaulted_GetRef();
+	Frame.ClassName = Subsystem.GetClass()->GetFName();
+	Frame.World = World;
+	Frame.Phase = Phase;
+
+	// Query memory first, so that the query itself isn't accounted as the subsystem's time
+	Frame.StartMemory = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+	Frame.StartTime = FPlatformTime::Seconds();
+	return true;
+}
+
+void FCommonStartupProfiler::PopPhase()
+{
+	const double EndTime = FPlatformTime::Seconds();
+	const int64 EndMemory = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+
+	check(!ScopeStack.IsEmpty());
+	const FScopeFrame Frame = ScopeStack.Pop(/*bAllowShrinking*/ false);
+
+	const double InclusiveSeconds = EndTime - Frame.StartTime;
+	const int64 InclusiveMemoryBytes = EndMemory - Frame.StartMemory;
+
+	if (!ScopeStack.IsEmpty())
+	{
+		FScopeFrame& ParentFrame = ScopeStack.Last();
+		ParentFrame.ChildSeconds += InclusiveSeconds;
+		ParentFrame.ChildMemoryBytes += InclusiveMemoryBytes;
+	}
+
+	// The world might have been destroyed in the meantime
+	const UWorld* World = Frame.World.Get();
+	if (!IsValid(World))
+	{
+		return;
+	}
+
+	FReport& Report = FindOrAddReport(*World);
+
+	FRecord* Record = Report.Records.FindByPredicate([&Frame](const FRecord& Item)
+	{
+		return Item.ClassName == Frame.ClassName;
+	});
+
+	if (!Record)
+	{
+		Record = &Report.Records.AddDefaulted_GetRef();
+		Record->ClassName = Frame.ClassName;
+	}
+
+	const int32 PhaseIndex = static_cast<int32>(Frame.Phase);
+	Record->Seconds[PhaseIndex] += InclusiveSeconds - Frame.ChildSeconds;
+	Record->MemoryBytes[PhaseIndex] += InclusiveMemoryBytes - Frame.ChildMemoryBytes;
+}
+
+FCommonStartupProfiler::FReport& FCommonStartupProfiler::FindOrAddReport(const UWorld& World)
+{
+	const TObjectKey<UWorld> WorldKey(&World);
+
+	// Most of the time, the world being loaded is the latest one
+	for (int32 ReportIndex = Reports.Num() - 1; ReportIndex >= 0; ReportIndex--)
+	{
+		if (Reports[ReportIndex].World == WorldKey)
+		{
+			return Reports[ReportIndex];
+		}
+	}
+
+	const int32 MaxReports = FMath::Max(GCommonStartupProfilerMaxReports, 1);
+	if (Reports.Num() >= MaxReports)
+	{
+		Reports.RemoveAt(0, Reports.Num() - MaxReports + 1);
+	}
+
+	FReport& Report = Reports.AddDefaulted_GetRef();
+	Report.World = WorldKey;
+	Report.MapName = World.GetMapName();
+	Report.StartTime = FDateTime::Now();
+	return Report;
+}
+
+const FCommonStartupProfiler::FReport* FCommonStartupProfiler::FindReport(const UWorld* World) const
+{
+	if (Reports.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	if (!World)
+	{
+		return &Reports.Last();
+	}
+
+	const TObjectKey<UWorld> WorldKey(World);
+	const FReport* Report = Reports.FindByPredicate([&WorldKey](const FReport& Item)
+	{
+		return Item.World == WorldKey;
+	});
+
+	return Report;
+}
+
+void FCommonStartupProfiler::PrintReport(const FReport& Report, FOutputDevice& Ar)
+{
+	const TArray<const FRecord*> SortedRecords = GetSortedRecords(Report);
+
+	double TotalSeconds = 0.0;
+	int64 TotalMemoryBytes = 0;
+	for (const FRecord* Record : SortedRecords)
+	{
+		TotalSeconds += Record->GetTotalSeconds();
+		TotalMemoryBytes += Record->GetTotalMemoryBytes();
+	}
+
+	Ar.Logf(TEXT("Startup report of [%s] (%s): [%d] subsystems, [%.2f] ms, [%.1f] KiB."), *Report.MapName,
+		*Report.StartTime.ToString(), SortedRecords.Num(), TotalSeconds * 1000.0,
+		static_cast<double>(TotalMemoryBytes) / 1024.0);
+
+	FString Header = FString::Printf(TEXT("  %-48s %10s %10s"), TEXT("Class"), TEXT("TotalMs"), TEXT("TotalKiB"));
+	for (int32 PhaseIndex = 0; PhaseIndex < NumPhases; PhaseIndex++)
+	{
+		Header += FString::Printf(TEXT(" %22s"), GetPhaseName(static_cast<ECommonStartupPhase>(PhaseIndex)));
+	}
+	Ar.Log(Header);
+
+	for (const FRecord* Record : SortedRecords)
+	{
+		FString Line = FString::Printf(TEXT("  %-48s %10.3f %10.1f"), *Record->ClassName.ToString(),
+			Record->GetTotalSeconds() * 1000.0, static_cast<double>(Record->GetTotalMemoryBytes()) / 1024.0);
+
+		for (int32 PhaseIndex = 0; PhaseIndex < NumPhases; PhaseIndex++)
+		{
+			Line += FString::Printf(TEXT(" %12.3f ms %6.0f K"), Record->Seconds[PhaseIndex] * 1000.0,
+				static_cast<double>(Record->MemoryBytes[PhaseIndex]) / 1024.0);
+		}
+		Ar.Log(Line);
+	}
+}
+
+TArray<const FCommonStartupProfiler::FRecord*> FCommonStartupProfiler::GetSortedRecords(const FReport& Report)
+{
+	TArray<const FRecord*> SortedRecords;
+	SortedRecords.Reserve(Report.Records.Num());
+	for (const FRecord& Record : Report.Records)
+	{
+		SortedRecords.Add(&Record);
+	}
+
+	Algo::Sort(SortedRecords, [](const FRecord* Lhs, const FRecord* Rhs)
+	{
+		return Lhs->GetTotalSeconds() > Rhs->GetTotalSeconds();
+	});
+
+	return SortedRecords;
+}
+
+void FCommonStartupProfiler::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	if (!GCommonStartupProfilerDumpOnMapLoad || !IsValid(LoadedWorld))
+	{
+		return;
+	}
+
+	// Subsystems handle the map load through the same delegate, so wait for all of them to be done
+	const TWeakObjectPtr<UWorld> WeakWorld = LoadedWorld;
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, WeakWorld](float)
+	{
+		if (const UWorld* World = WeakWorld.Get())
+		{
+			DumpReport(World);
+		}
+
+		return false;
+	}));
+}
+
+static void PrintStartupReports(const TArray<FString>& Args, FOutputDevice& Ar)
+{
+	const bool bAllReports = Args.Contains(TEXT("all"));
+	FCommonStartupProfiler::Get().PrintReports(Ar, bAllReports);
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice PrintStartupReportsCommand(
+	TEXT("CommonSubsystems.Startup.Report"),
+	TEXT("Print time and memory world subsystems have spent in each lifecycle phase during the latest map load, ")
+	TEXT("sorted by time.\n")
+	TEXT("Usage: CommonSubsystems.Startup.Report [all]"),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateStatic(&PrintStartupReports));
+
+static void DumpStartupReport()
+{
+	FCommonStartupProfiler::Get().DumpReport();
+}
+
+static FAutoConsoleCommand DumpStartupReportCommand(
+	TEXT("CommonSubsystems.Startup.Dump"),
+	TEXT("Write the startup report of the latest map load as CSV to the profiling directory."),
+	FConsoleCommandDelegate::CreateStatic(&DumpStartupReport));
+
+#endif
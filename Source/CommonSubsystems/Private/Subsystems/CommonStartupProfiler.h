@@ -0,0 +1,230 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CommonSubsystems.h"
+
+#if COMMON_SUBSYSTEMS_WITH_STARTUP_PROFILER
+
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class UWorld;
+
+/**
+ * Lifecycle phases of a world subsystem measured by the startup profiler.
+ */
+enum class ECommonStartupPhase : uint8
+{
+	ShouldCreateSubsystem,
+	Initialize,
+	PostInitWorld,
+	OnWorldInitialized,
+
+	MAX,
+};
+
+/**
+ * Records the time and memory world subsystems spend in their lifecycle phases while a world is being loaded.
+ *
+ * Each world gets its own report, listing every subsystem class with the time and memory spent in each phase. Nested
+ * phases are only accounted to the innermost one. Memory is the process' used physical memory delta, so it's
+ * approximate, and only meaningful for allocations of a page or more.
+ *
+ * ShouldCreateSubsystem and Initialize are overridden by subclasses that call the base implementation first, so they
+ * can't be wrapped in a scope. They're open phases instead: they start in the base implementation, and last until the
+ * next phase starts or the world's subsystems are all initialized. This includes the subsystem's construction in its
+ * creation, and the work of subsystems that aren't profiled and are created right after it.
+ *
+ * Game thread only.
+ */
+class FCommonStartupProfiler
+{
+public:
+	struct FRecord
+	{
+		/** Subsystem class name. */
+		FName ClassName;
+
+		/** Time spent in each phase in seconds. */
+		double Seconds[static_cast<int32>(ECommonStartupPhase::MAX)] = {};
+
+		/** Memory allocated in each phase in bytes. */
+		int64 MemoryBytes[static_cast<int32>(ECommonStartupPhase::MAX)] = {};
+
+		/**
+		 * Get time spent in all phases in seconds.
+		 * @return	Total time.
+		 */
+		double GetTotalSeconds() const;
+
+		/**
+		 * Get memory allocated in all phases in bytes.
+		 * @return	Total memory.
+		 */
+		int64 GetTotalMemoryBytes() const;
+	};
+
+	struct FReport
+	{
+		/** World the report is about. */
+		TObjectKey<UWorld> World;
+
+		/** Name of the world's map. */
+		FString MapName;
+
+		/** Time the first phase has been recorded at. */
+		FDateTime StartTime;
+
+		/** Records, one per subsystem class. */
+		TArray<FRecord> Records;
+	};
+
+	struct FScope
+	{
+	public:
+		FScope(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase);
+		~FScope();
+
+	private:
+		/** If true, the scope is being recorded, false otherwise. */
+		bool bIsRecording = false;
+	};
+
+public:
+	/**
+	 * Get the profiler instance.
+	 * @return	Profiler instance.
+	 */
+	static FCommonStartupProfiler& Get();
+
+	/**
+	 * Print reports.
+	 * @param	Ar output device to print to.
+	 * @param	bAllReports if true, print all the kept reports, if false, only the latest one.
+	 */
+	void PrintReports(FOutputDevice& Ar, bool bAllReports) const;
+
+	/**
+	 * Write a report as CSV to the profiling directory.
+	 * @param	World world to write the report of. If nullptr, the latest report is written.
+	 * @return	Path of the written file. Empty if there's nothing to write.
+	 */
+	FString DumpReport(const UWorld* World = nullptr) const;
+
+	/**
+	 * Start measuring an open phase. It lasts until the next phase starts, or EndOpenPhase() is called.
+	 * @param	Subsystem profiled subsystem.
+	 * @param	World world the subsystem belongs to.
+	 * @param	Phase phase to measure.
+	 */
+	void BeginOpenPhase(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase);
+
+	/**
+	 * Finish measuring the current open phase, if any.
+	 */
+	void EndOpenPhase();
+
+private:
+	FCommonStartupProfiler();
+
+	/**
+	 * Start measuring a phase.
+	 * @param	Subsystem profiled subsystem.
+	 * @param	World world the subsystem belongs to.
+	 * @param	Phase phase to measure.
+	 * @return	If true, phase is being recorded, false otherwise.
+	 */
+	bool PushPhase(const UObject& Subsystem, const UWorld* World, ECommonStartupPhase Phase);
+
+	/**
+	 * Finish measuring the innermost phase, and add its exclusive time and memory to the world's report.
+	 */
+	void PopPhase();
+
+	/**
+	 * Find the report of a world, or create one.
+	 * @param	World world to find the report of.
+	 * @return	World's report.
+	 */
+	FReport& FindOrAddReport(const UWorld& World);
+
+	/**
+	 * Find the report of a world.
+	 * @param	World world to find the report of. If nullptr, the latest report is returned.
+	 * @return	Report if any, nullptr otherwise.
+	 */
+	const FReport* FindReport(const UWorld* World) const;
+
+	/**
+	 * Print a single report.
+	 * @param	Report report to print.
+	 * @param	Ar output device to print to.
+	 */
+	static void PrintReport(const FReport& Report, FOutputDevice& Ar);
+
+	/**
+	 * Get records of a report, sorted by total time descending.
+	 * @param	Report report to sort.
+	 * @return	Sorted records.
+	 */
+	static TArray<const FRecord*> GetSortedRecords(const FReport& Report);
+
+	/**
+	 * Called once a map has been loaded. Dumps the map's report on the next frame, once all subsystems have handled
+	 * the map load, if enabled.
+	 * @param	LoadedWorld loaded world.
+	 */
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+
+private:
+	struct FScopeFrame
+	{
+		/** Profiled subsystem class name. */
+		FName ClassName;
+
+		/** World the subsystem belongs to. */
+		TWeakObjectPtr<const UWorld> World;
+
+		/** Phase being measured. */
+		ECommonStartupPhase Phase = ECommonStartupPhase::MAX;
+
+		/** Platform time the scope has started at. */
+		double StartTime = 0.0;
+
+		/** Used physical memory the scope has started with. */
+		int64 StartMemory = 0;
+
+		/** Time spent by nested scopes in seconds. */
+		double ChildSeconds = 0.0;
+
+		/** Memory allocated by nested scopes in bytes. */
+		int64 ChildMemoryBytes = 0;
+	};
+
+	/** Phases being measured, innermost last. */
+	TArray<FScopeFrame> ScopeStack;
+
+	/** If true, the innermost phase is an open phase, false otherwise. */
+	bool bHasOpenPhase = false;
+
+	/** Reports, oldest first. */
+	TArray<FReport> Reports;
+};
+
+#define COMMON_SUBSYSTEMS_STARTUP_SCOPE(Subsystem, World, Phase) \
+	const FCommonStartupProfiler::FScope ANONYMOUS_VARIABLE(StartupScope)(Subsystem, World, ECommonStartupPhase::Phase)
+
+#define COMMON_SUBSYSTEMS_STARTUP_BEGIN_PHASE(Subsystem, World, Phase) \
+	FCommonStartupProfiler::Get().BeginOpenPhase(Subsystem, World, ECommonStartupPhase::Phase)
+
+#define COMMON_SUBSYSTEMS_STARTUP_END_PHASE() \
+	FCommonStartupProfiler::Get().EndOpenPhase()
+
+#else
+
+#define COMMON_SUBSYSTEMS_STARTUP_SCOPE(Subsystem, World, Phase)
+#define COMMON_SUBSYSTEMS_STARTUP_BEGIN_PHASE(Subsystem, World, Phase)
+#define COMMON_SUBSYSTEMS_STARTUP_END_PHASE()
+
+#endif
@@ -0,0 +1,213 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonSubsystemCache.h"
+
+#include "Subsystems/CommonSubsystemLifetime.h"
+
+FCommonSubsystemCache FCommonSubsystemCache::Instance;
+
+FCommonSubsystemCache::FCommonSubsystemCache()
+{
+	for (int32& TableIndex : Buckets)
+	{
+		TableIndex = INDEX_NONE;
+	}
+}
+
+int32 FCommonSubsystemCache::GetClassSlot(const UClass* Class)
+{
+	check(IsInGameThread());
+	check(Class);
+
+	if (const int32* Slot = ClassSlots.Find(Class))
+	{
+		return *Slot;
+	}
+
+	const int32 NewSlot = ClassSlots.Num();
+	ClassSlots.Add(Class, NewSlot);
+	return NewSlot;
+}
+
+void FCommonSubsystemCache::Register(USubsystem& Subsystem, const UClass* StopClass)
+{
+	check(IsInGameThread());
+
+	const UObject* Owner = Subsystem.GetOuter();
+	check(IsValid(Owner));
+
+	const int32 TableIndex = FindOrAddTableIndex(Owner);
+	FOwnerTable& Table = Tables[TableIndex];
+
+	// Register under super classes as well, so that looking up a subsystem by its base class hits the cache too
+	for (const UClass* Class = Subsystem.GetClass(); Class && Class != StopClass; Class = Class->GetSuperClass())
+	{
+		const int32 Slot = GetClassSlot(Class);
+		if (!Table.Subsystems.IsValidIndex(Slot))
+		{
+			Table.Subsystems.SetNumZeroed(Slot + 1);
+		}
+
+		// The first registered subsystem wins, same as with the engine's lookup
+		if (!Table.Subsystems[Slot])
+		{
+			Table.Subsystems[Slot] = &Subsystem;
+		}
+	}
+
+	Table.NumRegistered++;
+
+	Lifetimes.Add(&Subsystem, MakeShared<FCommonSubsystemLifetime, ESPMode::ThreadSafe>(Subsystem));
+}
+
+void FCommonSubsystemCache::Unregister(USubsystem& Subsystem)
+{
+	check(IsInGameThread());
+
+	// Normally closed already at the start of the deinitialization
+	CloseLifetime(Subsystem);
+
+	const int32 TableIndex = FindTableIndex(Subsystem.GetOuter());
+	if (TableIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FOwnerTable& Table = Tables[TableIndex];
+
+	bool bWasRegistered = false;
+	for (USubsystem*& RegisteredSubsystem : Table.Subsystems)
+	{
+		if (RegisteredSubsystem == &Subsystem)
+		{
+			RegisteredSubsystem = nullptr;
+			bWasRegistered = true;
+		}
+	}
+
+	if (!bWasRegistered)
+	{
+		return;
+	}
+
+	Table.NumRegistered--;
+	if (Table.NumRegistered == 0)
+	{
+		ReleaseTable(TableIndex);
+	}
+}
+
+void FCommonSubsystemCache::CloseLifetime(USubsystem& Subsystem)
+{
+	check(IsInGameThread());
+
+	TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe> Lifetime;
+	if (Lifetimes.RemoveAndCopyValue(&Subsystem, OUT Lifetime))
+	{
+		Lifetime->Close();
+	}
+}
+
+TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe> FCommonSubsystemCache::FindLifetime(
+	const USubsystem& Subsystem) const
+{
+	check(IsInGameThread());
+
+	const TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe>* Lifetime = Lifetimes.Find(&Subsystem);
+	return Lifetime ? *Lifetime : nullptr;
+}
+
+bool FCommonSubsystemCache::GetTableLocation(const USubsystem& Subsystem, int32& OutTableIndex,
+	uint32& OutGeneration) const
+{
+	const int32 TableIndex = FindTableIndex(Subsystem.GetOuter());
+	if (TableIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutTableIndex = TableIndex;
+	OutGeneration = Tables[TableIndex].Generation;
+	return true;
+}
+
+USubsystem* FCommonSubsystemCache::FindSlow(const UObject* Owner, int32 Slot) const
+{
+	const int32* TableIndex = OwnerTableIndices.Find(Owner);
+	if (!TableIndex)
+	{
+		return nullptr;
+	}
+
+	const FOwnerTable& Table = Tables[*TableIndex];
+	if (Table.OwnerSerialNumber != GetSerialNumber(Owner))
+	{
+		return nullptr;
+	}
+
+	USubsystem* Subsystem = Table.Subsystems.IsValidIndex(Slot) ? Table.Subsystems[Slot] : nullptr;
+	return Subsystem;
+}
+
+int32 FCommonSubsystemCache::FindTableIndex(const UObject* Owner) const
+{
+	const int32* TableIndex = OwnerTableIndices.Find(Owner);
+	return TableIndex ? *TableIndex : INDEX_NONE;
+}
+
+int32 FCommonSubsystemCache::FindOrAddTableIndex(const UObject* Owner)
+{
+	// Make sure the owner has a serial number to tell it apart from the objects that reuse its address later on
+	const int32 OwnerSerialNumber = GUObjectArray.AllocateSerialNumber(Owner->GetUniqueID());
+
+	const int32 ExistingTableIndex = FindTableIndex(Owner);
+	if (ExistingTableIndex != INDEX_NONE)
+	{
+		FOwnerTable& ExistingTable = Tables[ExistingTableIndex];
+		if (ExistingTable.OwnerSerialNumber != OwnerSerialNumber)
+		{
+			// Left by a destroyed owner, so there's nobody to unregister its subsystems
+			ExistingTable.OwnerSerialNumber = OwnerSerialNumber;
+			ExistingTable.Generation++;
+			ExistingTable.NumRegistered = 0;
+			ExistingTable.Subsystems.Reset();
+		}
+
+		return ExistingTableIndex;
+	}
+
+	const int32 TableIndex = FreeTableIndices.IsEmpty() ? Tables.AddDefaulted() : FreeTableIndices.Pop();
+	Tables[TableIndex].Owner = Owner;
+	Tables[TableIndex].OwnerSerialNumber = OwnerSerialNumber;
+	OwnerTableIndices.Add(Owner, TableIndex);
+
+	// Owners that collide with an existing one are only reachable through the slow path
+	int32& BucketTableIndex = Buckets[GetBucketIndex(Owner)];
+	if (BucketTableIndex == INDEX_NONE)
+	{
+		BucketTableIndex = TableIndex;
+	}
+
+	return TableIndex;
+}
+
+void FCommonSubsystemCache::ReleaseTable(int32 TableIndex)
+{
+	FOwnerTable& Table = Tables[TableIndex];
+	check(Table.NumRegistered == 0);
+
+	int32& BucketTableIndex = Buckets[GetBucketIndex(Table.Owner)];
+	if (BucketTableIndex == TableIndex)
+	{
+		BucketTableIndex = INDEX_NONE;
+	}
+
+	OwnerTableIndices.Remove(Table.Owner);
+
+	Table.Owner = nullptr;
+	Table.OwnerSerialNumber = 0;
+	Table.Generation++;
+	Table.Subsystems.Reset();
+
+	FreeTableIndices.Add(TableIndex);
+}
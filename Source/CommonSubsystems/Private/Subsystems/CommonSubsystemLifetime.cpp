@@ -0,0 +1,125 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonSubsystemLifetime.h"
+
+#include "HAL/IConsoleManager.h"
+#include "LogCategories.h"
+
+static float GCommonLifetimeWarningSeconds = 1.f;
+static FAutoConsoleVariableRef CVarCommonLifetimeWarningSeconds(
+	TEXT("CommonSubsystems.Lifetime.WarningSeconds"),
+	GCommonLifetimeWarningSeconds,
+	TEXT("Time in seconds a deinitializing subsystem waits for its borrowers before logging a warning about them."));
+
+static float GCommonLifetimeTimeoutSeconds = 5.f;
+static FAutoConsoleVariableRef CVarCommonLifetimeTimeoutSeconds(
+	TEXT("CommonSubsystems.Lifetime.TimeoutSeconds"),
+	GCommonLifetimeTimeoutSeconds,
+	TEXT("Time in seconds a deinitializing subsystem waits for its borrowers at most. Past it, the deinitialization ")
+	TEXT("goes on, and the subsystem object is kept from garbage collection until the last borrower returns it, so ")
+	TEXT("that a borrower waiting on the game thread can't deadlock it."));
+
+FCommonSubsystemLifetime::FCommonSubsystemLifetime(USubsystem& InSubsystem)
+	: Subsystem(&InSubsystem)
+{
+}
+
+FCommonSubsystemLifetime::~FCommonSubsystemLifetime()
+{
+	check((State.load(std::memory_order_acquire) & ~ClosedFlag) == 0);
+}
+
+USubsystem* FCommonSubsystemLifetime::TryBorrow()
+{
+	uint32 CurrentState = State.load(std::memory_order_acquire);
+	do
+	{
+		if (CurrentState & ClosedFlag)
+		{
+			return nullptr;
+		}
+	}
+	while (!State.compare_exchange_weak(CurrentState, CurrentState + 1, std::memory_order_acq_rel));
+
+	return Subsystem;
+}
+
+void FCommonSubsystemLifetime::Release()
+{
+	const uint32 PreviousState = State.fetch_sub(1, std::memory_order_acq_rel);
+	check((PreviousState & ~ClosedFlag) > 0);
+
+	if (PreviousState == (ClosedFlag | 1))
+	{
+		AllReleasedEvent->Trigger();
+
+		// Either this or Close() unroots it, whichever comes last
+		if (bIsKeptAlive.exchange(false, std::memory_order_acq_rel))
+		{
+			Subsystem->RemoveFromRoot();
+		}
+	}
+}
+
+bool FCommonSubsystemLifetime::IsClosed() const
+{
+	return (State.load(std::memory_order_acquire) & ClosedFlag) != 0;
+}
+
+bool FCommonSubsystemLifetime::IsCancellationRequested() const
+{
+	return bIsCancellationRequested.load(std::memory_order_acquire);
+}
+
+int32 FCommonSubsystemLifetime::GetNumBorrows() const
+{
+	const int32 NumBorrows = static_cast<int32>(State.load(std::memory_order_acquire) & ~ClosedFlag);
+	return NumBorrows;
+}
+
+bool FCommonSubsystemLifetime::Close()
+{
+	check(IsInGameThread());
+
+	bIsCancellationRequested.store(true, std::memory_order_release);
+
+	const uint32 PreviousState = State.fetch_or(ClosedFlag, std::memory_order_acq_rel);
+	if ((PreviousState & ~ClosedFlag) == 0)
+	{
+		return true;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(FCommonSubsystemLifetime::Close);
+
+	const float TimeoutSeconds = FMath::Max(GCommonLifetimeTimeoutSeconds, 0.f);
+	const float WarningSeconds = FMath::Clamp(GCommonLifetimeWarningSeconds, 0.f, TimeoutSeconds);
+
+	if (AllReleasedEvent->Wait(static_cast<uint32>(WarningSeconds * 1000.f)))
+	{
+		return true;
+	}
+
+	UE_LOG(LogCommonSubsystems, Warning, TEXT("Subsystem [%s] is waiting for %d borrowers to cancel their work before "
+		"it can deinitialize."), *GetNameSafe(Subsystem), GetNumBorrows());
+
+	if (AllReleasedEvent->Wait(static_cast<uint32>((TimeoutSeconds - WarningSeconds) * 1000.f)))
+	{
+		return true;
+	}
+
+	UE_LOG(LogCommonSubsystems, Error, TEXT("Subsystem [%s] has given up waiting for %d borrowers after [%.1f] s, and "
+		"deinitializes under them. It's kept from garbage collection until they return it."),
+		*GetNameSafe(Subsystem), GetNumBorrows(), TimeoutSeconds);
+
+	// Borrowers may still touch the object, so at least it mustn't be freed under them
+	Subsystem->AddToRoot();
+	bIsKeptAlive.store(true, std::memory_order_release);
+
+	// The last borrower might have returned it before it could see the flag
+	if (GetNumBorrows() == 0 && bIsKeptAlive.exchange(false, std::memory_order_acq_rel))
+	{
+		Subsystem->RemoveFromRoot();
+	}
+
+	return false;
+}
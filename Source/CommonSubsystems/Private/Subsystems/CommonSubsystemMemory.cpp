@@ -0,0 +1,297 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonSubsystemMemory.h"
+
+#include "Misc/ScopeRWLock.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+FName GetCommonSubsystemLlmTagName(const TCHAR* Phase, FName ClassName)
+{
+	if (!FLowLevelMemTracker::IsEnabled())
+	{
+		return NAME_None;
+	}
+
+	// Ticks ask on every frame, possibly from worker threads
+	static FRWLock Lock;
+	static TMap<TPair<FName, FName>, FName> TagNames;
+
+	const FName PhaseName = Phase;
+	const TPair<FName, FName> Key(PhaseName, ClassName);
+
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const FName* TagName = TagNames.Find(Key))
+		{
+			return *TagName;
+		}
+	}
+
+	const FName TagName = *FString::Printf(TEXT("CommonSubsystems/%s/%s"), Phase, *ClassName.ToString());
+
+	FWriteScopeLock WriteLock(Lock);
+	TagNames.Add(Key, TagName);
+	return TagName;
+}
+#endif
+
+#if COMMON_SUBSYSTEMS_WITH_MEMORY_REPORT
+
+#include "Algo/Sort.h"
+#include "Containers/Ticker.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Subsystems/CommonGameInstanceSubsystem.h"
+#include "Subsystems/CommonWorldSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectIterator.h"
+
+/**
+ * Add the memory held by a subsystem to a snapshot.
+ * @param	Snapshot snapshot to add to.
+ * @param	Subsystem subsystem to measure.
+ * @param	OwnerName name of the world or game instance owning the subsystem.
+ */
+static void AddUsage(FCommonMemoryReport::FSnapshot& Snapshot, UObject& Subsystem, const FString& OwnerName)
+{
+	// Properties are only counted in the estimated total mode, which also includes the subsystem's subobjects
+	const int64 Bytes = Subsystem.GetClass()->GetStructureSize() +
+		static_cast<int64>(Subsystem.GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal));
+
+	FCommonMemoryReport::FOwnerUsage& OwnerUsage = Snapshot.ByOwner.FindOrAdd(OwnerName);
+	OwnerUsage.Total.Bytes += Bytes;
+	OwnerUsage.Total.NumInstances++;
+
+	FCommonMemoryReport::FUsage& ClassUsage = OwnerUsage.ByClass.FindOrAdd(Subsystem.GetClass()->GetName());
+	ClassUsage.Bytes += Bytes;
+	ClassUsage.NumInstances++;
+
+	Snapshot.TotalBytes += Bytes;
+}
+
+/**
+ * Add the usages of an owner to a table of usages by class.
+ * @param	ByClass table to add to.
+ * @param	OwnerUsage usages of the owner.
+ */
+static void AddClassUsages(TMap<FString, FCommonMemoryReport::FUsage>& ByClass,
+	const FCommonMemoryReport::FOwnerUsage& OwnerUsage)
+{
+	for (const auto& [ClassName, Usage] : OwnerUsage.ByClass)
+	{
+		FCommonMemoryReport::FUsage& ClassUsage = ByClass.FindOrAdd(ClassName);
+		ClassUsage.Bytes += Usage.Bytes;
+		ClassUsage.NumInstances += Usage.NumInstances;
+	}
+}
+
+FCommonMemoryReport& FCommonMemoryReport::Get()
+{
+	static FCommonMemoryReport Instance;
+	return Instance;
+}
+
+FCommonMemoryReport::FCommonMemoryReport()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FCommonMemoryReport::OnPostLoadMapWithWorld);
+}
+
+FCommonMemoryReport::FSnapshot FCommonMemoryReport::TakeSnapshot()
+{
+	check(IsInGameThread());
+
+	FSnapshot Snapshot;
+
+	for (TObjectIterator<UCommonWorldSubsystem> It; It; ++It)
+	{
+		UCommonWorldSubsystem* Subsystem = *It;
+		const UWorld* World = IsValid(Subsystem) ? Subsystem->GetWorld() : nullptr;
+		if (IsValid(World))
+		{
+			AddUsage(Snapshot, *Subsystem, World->GetOutermost()->GetName());
+		}
+	}
+
+	for (TObjectIterator<UCommonGameInstanceSubsystem> It; It; ++It)
+	{
+		UCommonGameInstanceSubsystem* Subsystem = *It;
+		const UGameInstance* GameInstance = IsValid(Subsystem) ? Subsystem->GetGameInstance() : nullptr;
+		if (IsValid(GameInstance))
+		{
+			AddUsage(Snapshot, *Subsystem, GameInstance->GetName());
+		}
+	}
+
+	return Snapshot;
+}
+
+void FCommonMemoryReport::PrintReport(FOutputDevice& Ar, int32 MaxRows) const
+{
+	const FSnapshot Snapshot = TakeSnapshot();
+
+	// Baselines of the owners that are gone don't take part in the deltas
+	TMap<FString, FUsage> ByClass;
+	TMap<FString, FUsage> BaselineByClass;
+	TMap<FString, FUsage> ByOwner;
+	TMap<FString, FUsage> BaselineByOwner;
+	int64 BaselineBytes = 0;
+
+	for (const auto& [OwnerName, OwnerUsage] : Snapshot.ByOwner)
+	{
+		ByOwner.Add(OwnerName, OwnerUsage.Total);
+		AddClassUsages(ByClass, OwnerUsage);
+
+		if (const FBaseline* Baseline = Baselines.Find(OwnerName))
+		{
+			BaselineByOwner.Add(OwnerName, Baseline->Usage.Total);
+			AddClassUsages(BaselineByClass, Baseline->Usage);
+			BaselineBytes += Baseline->Usage.Total.Bytes;
+		}
+	}
+
+	Ar.Logf(TEXT("Subsystem memory: [%.1f] KiB, [%+.1f] KiB since the owners' baselines."),
+		static_cast<double>(Snapshot.TotalBytes) / 1024.0,
+		static_cast<double>(Snapshot.TotalBytes - BaselineBytes) / 1024.0);
+
+	PrintUsages(Ar, TEXT("Class"), ByClass, BaselineByClass, MaxRows);
+	PrintUsages(Ar, TEXT("Owner"), ByOwner, BaselineByOwner, MaxRows);
+
+	for (const auto& [OwnerName, OwnerUsage] : Snapshot.ByOwner)
+	{
+		const FBaseline* Baseline = Baselines.Find(OwnerName);
+		Ar.Logf(TEXT("  Baseline of [%s]: [%s]."), *OwnerName, Baseline ? *Baseline->Label : TEXT("none"));
+	}
+}
+
+void FCommonMemoryReport::ResetBaselines(const FString& Label)
+{
+	const FSnapshot Snapshot = TakeSnapshot();
+
+	Baselines.Reset();
+	for (const auto& [OwnerName, OwnerUsage] : Snapshot.ByOwner)
+	{
+		ResetBaseline(Snapshot, OwnerName, Label);
+	}
+}
+
+void FCommonMemoryReport::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	if (!IsValid(LoadedWorld))
+	{
+		return;
+	}
+
+	// Subsystems handle the map load through the same delegate, so wait for all of them to be done
+	const TWeakObjectPtr<UWorld> WeakWorld = LoadedWorld;
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, WeakWorld](float)
+	{
+		const UWorld* World = WeakWorld.Get();
+		if (!World)
+		{
+			return false;
+		}
+
+		const FSnapshot Snapshot = TakeSnapshot();
+		const FString Label = FString::Printf(TEXT("load of %s"), *World->GetMapName());
+
+		// Owners that are gone won't be reported anymore
+		for (auto It = Baselines.CreateIterator(); It; ++It)
+		{
+			if (!Snapshot.ByOwner.Contains(It.Key()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		ResetBaseline(Snapshot, World->GetOutermost()->GetName(), Label);
+
+		if (const UGameInstance* GameInstance = World->GetGameInstance())
+		{
+			ResetBaseline(Snapshot, GameInstance->GetName(), Label);
+		}
+
+		return false;
+	}));
+}
+
+void FCommonMemoryReport::ResetBaseline(const FSnapshot& Snapshot, const FString& OwnerName, const FString& Label)
+{
+	const FOwnerUsage* OwnerUsage = Snapshot.ByOwner.Find(OwnerName);
+
+	FBaseline& Baseline = Baselines.FindOrAdd(OwnerName);
+	Baseline.Usage = OwnerUsage ? *OwnerUsage : FOwnerUsage();
+	Baseline.Label = Label;
+}
+
+void FCommonMemoryReport::PrintUsages(FOutputDevice& Ar, const TCHAR* Title, const TMap<FString, FUsage>& Usages,
+	const TMap<FString, FUsage>& BaselineUsages, int32 MaxRows)
+{
+	TArray<TPair<FString, FUsage>> SortedUsages = Usages.Array();
+	Algo::Sort(SortedUsages, [](const TPair<FString, FUsage>& Lhs, const TPair<FString, FUsage>& Rhs)
+	{
+		return Lhs.Value.Bytes > Rhs.Value.Bytes;
+	});
+
+	Ar.Logf(TEXT("  %-64s %9s %12s %12s"), Title, TEXT("Instances"), TEXT("KiB"), TEXT("DeltaKiB"));
+
+	const int32 NumRows = MaxRows > 0 ? FMath::Min(MaxRows, SortedUsages.Num()) : SortedUsages.Num();
+	for (int32 RowIndex = 0; RowIndex < NumRows; RowIndex++)
+	{
+		const TPair<FString, FUsage>& Usage = SortedUsages[RowIndex];
+
+		// Classes and owners without a baseline have grown by all they hold
+		const FUsage* BaselineUsage = BaselineUsages.Find(Usage.Key);
+		const int64 DeltaBytes = Usage.Value.Bytes - (BaselineUsage ? BaselineUsage->Bytes : 0);
+
+		Ar.Logf(TEXT("  %-64s %9d %12.1f %+12.1f"), *Usage.Key, Usage.Value.NumInstances,
+			static_cast<double>(Usage.Value.Bytes) / 1024.0, static_cast<double>(DeltaBytes) / 1024.0);
+	}
+
+	if (NumRows < SortedUsages.Num())
+	{
+		Ar.Logf(TEXT("  ... [%d] more."), SortedUsages.Num() - NumRows);
+	}
+}
+
+// The baseline has to be taken on the first map load already, so don't wait for the first report to create it
+static FDelayedAutoRegisterHelper GCommonMemoryReportRegistration(EDelayedRegisterRunPhase::ObjectSystemReady, []
+{
+	FCommonMemoryReport::Get();
+});
+
+static void PrintMemoryReport(const TArray<FString>& Args, FOutputDevice& Ar)
+{
+	int32 MaxRows = 0;
+	bool bResetBaseline = false;
+	for (const FString& Arg : Args)
+	{
+		if (Arg == TEXT("reset"))
+		{
+			bResetBaseline = true;
+		}
+		else if (Arg.IsNumeric())
+		{
+			MaxRows = FCString::Atoi(*Arg);
+		}
+	}
+
+	FCommonMemoryReport& Report = FCommonMemoryReport::Get();
+	Report.PrintReport(Ar, MaxRows);
+
+	if (bResetBaseline)
+	{
+		Report.ResetBaselines(FString::Printf(TEXT("reset at %s"), *FDateTime::Now().ToString()));
+	}
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice PrintMemoryReportCommand(
+	TEXT("CommonSubsystems.Memory.Report"),
+	TEXT("Print memory held by world and game instance subsystems by class and by world or game instance, sorted by ")
+	TEXT("size, with the deltas since each world's last map load. Optionally limits the number of rows per table, and ")
+	TEXT("makes the current usage the new baseline of every world and game instance.\n")
+	TEXT("Usage: CommonSubsystems.Memory.Report [MaxRows] [reset]"),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateStatic(&PrintMemoryReport));
+
+#endif
@@ -0,0 +1,142 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CommonSubsystems.h"
+#include "HAL/LowLevelMemTracker.h"
+
+class UWorld;
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+/**
+ * Get name of the LLM tag the memory allocated on behalf of a subsystem class in a given phase is tracked under. Tags
+ * are nested under their phase, and phases under CommonSubsystems, so that the classes add up to the plugin's total.
+ * Names are cached per phase and class. Thread-safe.
+ * @param	Phase phase the memory is allocated in, such as Tick.
+ * @param	ClassName class name, or tick debug name of a tick component.
+ * @return	LLM tag name. None if LLM is disabled.
+ */
+FName GetCommonSubsystemLlmTagName(const TCHAR* Phase, FName ClassName);
+
+#define COMMON_SUBSYSTEMS_LLM_SCOPE(Phase, ClassName) \
+	const FLLMScope ANONYMOUS_VARIABLE(LlmScope)(GetCommonSubsystemLlmTagName(TEXT(Phase), ClassName), false, \
+		ELLMTagSet::None, ELLMTracker::Default)
+#else
+#define COMMON_SUBSYSTEMS_LLM_SCOPE(Phase, ClassName)
+#endif
+
+#if COMMON_SUBSYSTEMS_WITH_MEMORY_REPORT
+
+/**
+ * Reports the memory held by world and game instance subsystems, by class and by the world or game instance owning
+ * them.
+ *
+ * Memory of a subsystem is the size of its object, plus its estimated total resource size: its properties'
+ * allocations as counted by serialization, its subobjects, and whatever it reports through GetAllocatedSize().
+ *
+ * Each owner has a baseline of its own, so that the report can tell how much each class and owner has grown since. A
+ * world's baseline is taken once its map has been loaded, along with the baseline of its game instance, so loading a
+ * map in one world doesn't reset the deltas of the others.
+ *
+ * Game thread only.
+ */
+class FCommonMemoryReport
+{
+public:
+	struct FUsage
+	{
+		/** Memory held in bytes. */
+		int64 Bytes = 0;
+
+		/** Number of subsystems holding it. */
+		int32 NumInstances = 0;
+	};
+
+	struct FOwnerUsage
+	{
+		/** Usage of all the owner's subsystems. */
+		FUsage Total;
+
+		/** Usage by subsystem class name. */
+		TMap<FString, FUsage> ByClass;
+	};
+
+	struct FSnapshot
+	{
+		/** Usage by world package name, or game instance name. */
+		TMap<FString, FOwnerUsage> ByOwner;
+
+		/** Memory held by all the subsystems in bytes. */
+		int64 TotalBytes = 0;
+	};
+
+public:
+	/**
+	 * Get the report. Created on first use.
+	 * @return	Memory report.
+	 */
+	static FCommonMemoryReport& Get();
+
+	/**
+	 * Measure the memory currently held by the live subsystems.
+	 * @return	Snapshot of the memory usage.
+	 */
+	static FSnapshot TakeSnapshot();
+
+	/**
+	 * Print the memory usage by class and by owner, biggest first, along with the deltas since each owner's baseline.
+	 * @param	Ar output device to print to.
+	 * @param	MaxRows maximum number of rows printed per table. 0 means no limit.
+	 */
+	void PrintReport(FOutputDevice& Ar, int32 MaxRows) const;
+
+	/**
+	 * Use the current memory usage as the baseline of every owner.
+	 * @param	Label description of when the baseline is taken, for the report.
+	 */
+	void ResetBaselines(const FString& Label);
+
+private:
+	struct FBaseline
+	{
+		/** Usage deltas are computed against. */
+		FOwnerUsage Usage;
+
+		/** Description of when the baseline has been taken. */
+		FString Label;
+	};
+
+private:
+	FCommonMemoryReport();
+
+	/**
+	 * Called once a map has been loaded.
+	 * @param	LoadedWorld world of the loaded map.
+	 */
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+
+	/**
+	 * Use the memory usage of a snapshot as the baseline of an owner.
+	 * @param	Snapshot snapshot to take the usage from.
+	 * @param	OwnerName name of the owner.
+	 * @param	Label description of when the baseline is taken, for the report.
+	 */
+	void ResetBaseline(const FSnapshot& Snapshot, const FString& OwnerName, const FString& Label);
+
+	/**
+	 * Print a usage table, biggest first.
+	 * @param	Ar output device to print to.
+	 * @param	Title name of the rows' column.
+	 * @param	Usages current usages.
+	 * @param	BaselineUsages usages deltas are computed against.
+	 * @param	MaxRows maximum number of rows to print. 0 means no limit.
+	 */
+	static void PrintUsages(FOutputDevice& Ar, const TCHAR* Title, const TMap<FString, FUsage>& Usages,
+		const TMap<FString, FUsage>& BaselineUsages, int32 MaxRows);
+
+private:
+	/** Baselines by owner name. Owners without one have grown by all they hold. */
+	TMap<FString, FBaseline> Baselines;
+};
+
+#endif
@@ -0,0 +1,708 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "LogCategories.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonWorldSubsystem.h"
+#include "Subsystems/CommonWorldSubsystemManager.h"
+#include "Subsystems/Components/CommonTickComponent.h"
+#include "Subsystems/Components/CommonTickScheduler.h"
+#include "Subsystems/Components/CommonTimerWheel.h"
+#include "TimerManager.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectIterator.h"
+
+#include <atomic>
+
+namespace CommonSubsystemsBenchmark
+{
+	/** Number of lookups per subsystem when measuring the lookup latency. */
+	static constexpr int32 NumLookupIterations = 10000;
+
+	/** Number of timers when measuring the timer costs. */
+	static constexpr int32 NumTimers = 100000;
+
+	/**
+	 * Keep a value from being optimized away, and keep the compiler from assuming that memory is unchanged across the
+	 * call, so that repeated lookups can't be folded into a single one.
+	 * @param	Value value to keep.
+	 */
+	template<typename T>
+	FORCEINLINE void DoNotOptimize(T Value)
+	{
+		static volatile T Sink;
+		Sink = Value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	/**
+	 * Subsystem looked up when measuring the lookup latency.
+	 */
+	struct FLookupKey
+	{
+		/** World the subsystem belongs to. */
+		const UWorld* World = nullptr;
+
+		/** Class of the subsystem. */
+		UClass* Class = nullptr;
+
+		/** Slot of the class in the subsystem cache. */
+		int32 Slot = INDEX_NONE;
+	};
+
+	/**
+	 * Tick component that does nothing but count its ticks.
+	 */
+	struct FEmptyTickComponent
+		: public FCommonTickComponent
+	{
+	public:
+		void Start(float InTickInterval, bool bInAlignTickInterval)
+		{
+			TickInterval = InTickInterval;
+			bAlignTickInterval = bInAlignTickInterval;
+			bStartWithTickEnabled = true;
+			Tick_Initialize(FTickSignature::CreateRaw(this, &FEmptyTickComponent::Tick));
+		}
+
+		void Stop()
+		{
+			Tick_Deinitialize();
+		}
+
+	private:
+		void Tick(float DeltaSeconds)
+		{
+			NumTicks++;
+		}
+
+	public:
+		/** Number of times the component has ticked. */
+		int32 NumTicks = 0;
+	};
+
+	/**
+	 * Set of tick components whose dispatch time is measured over a number of frames.
+	 */
+	struct FTickScenario
+	{
+		/** Prefix of the metric names. */
+		const TCHAR* Name = nullptr;
+
+		/** Tick interval of the components. */
+		float TickInterval = 0.f;
+
+		/** If true, components tick in the same frames, false if their phases are spread. */
+		bool bAlignTickInterval = false;
+	};
+
+	/** Scenarios measured one after another. Same-interval components show the spikes phase staggering flattens. */
+	static const FTickScenario TickScenarios[] =
+	{
+		{ TEXT("Tick"), 0.f, true },
+		{ TEXT("AlignedTick"), 0.5f, true },
+		{ TEXT("StaggeredTick"), 0.5f, false },
+	};
+
+	/** Upper bounds of the frame time histogram buckets in microseconds. The last bucket has no upper bound. */
+	static constexpr double HistogramBucketsUs[] = { 10.0, 25.0, 50.0, 100.0, 250.0, 500.0, 1000.0, 2500.0 };
+
+	/** Number of frame time histogram buckets with an upper bound. */
+	static constexpr int32 NumHistogramBounds = UE_ARRAY_COUNT(HistogramBucketsUs);
+
+	/**
+	 * Single measured value.
+	 */
+	struct FResult
+	{
+		/** Metric name. */
+		FString Name;
+
+		/** Measured value. */
+		double Value = 0.0;
+
+		/** Unit the value is expressed in. */
+		FString Unit;
+	};
+
+	/**
+	 * Benchmark of the plugin hot paths. Spans several frames, since ticking has to be measured over real frames.
+	 *
+	 * Creates N game worlds, which get every world subsystem class of the project that agrees to be created, measures
+	 * creation time and memory, lookup latency of the cached and the engine paths, timer costs of the timer wheel and
+	 * the engine's timer manager, scheduler dispatch cost of M empty tick components over F frames, every frame and at
+	 * a shared interval with and without phase staggering, and finally teardown time. Results are written as CSV and
+	 * JSON in the profiling directory.
+	 */
+	class FBenchmark
+	{
+	public:
+		FBenchmark(int32 InNumWorlds, int32 InNumTickComponents, int32 InNumFrames, bool bInExitWhenDone);
+		~FBenchmark();
+
+		/**
+		 * Start the benchmark.
+		 */
+		void Start();
+
+		/**
+		 * Check whether the benchmark has finished.
+		 * @return	If true, benchmark has finished, false otherwise.
+		 */
+		bool IsFinished() const;
+
+	private:
+		/**
+		 * Core ticker callback. Advances the benchmark by one frame.
+		 * @param	DeltaSeconds time since last tick.
+		 * @return	If true, benchmark has to keep ticking, false otherwise.
+		 */
+		bool Tick(float DeltaSeconds);
+
+		void CreateWorlds();
+		void MeasureLookups();
+		void MeasureTimers();
+		void StartTickComponents(const FTickScenario& Scenario);
+		void StopTickComponents();
+		void DestroyWorlds();
+		void AddFrameResults(const FString& Prefix, TArray<double>& FrameSeconds);
+		void AddFrameHistogram(const FString& Prefix, TConstArrayView<double> FrameSeconds);
+		void WriteResults() const;
+
+		/**
+		 * Add a measured value.
+		 * @param	Name metric name.
+		 * @param	Value measured value.
+		 * @param	Unit unit the value is expressed in.
+		 */
+		void AddResult(const FString& Name, double Value, const TCHAR* Unit);
+
+	private:
+		/** Number of worlds to create. */
+		int32 NumWorlds = 0;
+
+		/** Number of tick components to create. */
+		int32 NumTickComponents = 0;
+
+		/** Number of frames to measure the ticking for. */
+		int32 NumFrames = 0;
+
+		/** If true, requests engine exit once the results are written, false otherwise. */
+		bool bExitWhenDone = false;
+
+		/** Created worlds. */
+		TArray<UWorld*> Worlds;
+
+		/** Created tick components. */
+		TArray<TUniquePtr<FEmptyTickComponent>> TickComponents;
+
+		/** Scheduler dispatch time of each measured frame. */
+		TArray<double> DispatchSeconds;
+
+		/** Measured values. */
+		TArray<FResult> Results;
+
+		/** Index of the tick scenario being measured. */
+		int32 TickScenarioIndex = 0;
+
+		/** Number of frames ticked so far in the current tick scenario. */
+		int32 FrameIndex = 0;
+
+		/** If true, benchmark has finished, false otherwise. */
+		bool bIsFinished = false;
+
+		/** Delegate handle for the core ticker entry. */
+		FTSTicker::FDelegateHandle TickerHandle;
+	};
+
+	/** Benchmark being run. */
+	static TUniquePtr<FBenchmark> GBenchmark;
+
+	FBenchmark::FBenchmark(int32 InNumWorlds, int32 InNumTickComponents, int32 InNumFrames, bool bInExitWhenDone)
+		: NumWorlds(InNumWorlds)
+		, NumTickComponents(InNumTickComponents)
+		, NumFrames(InNumFrames)
+		, bExitWhenDone(bInExitWhenDone)
+	{
+	}
+
+	FBenchmark::~FBenchmark()
+	{
+		if (TickerHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		}
+
+		StopTickComponents();
+		DestroyWorlds();
+	}
+
+	void FBenchmark::Start()
+	{
+		UE_LOG(LogCommonSubsystems, Display, TEXT("Benchmark started: [%d] worlds, [%d] tick components, [%d] frames."),
+			NumWorlds, NumTickComponents, NumFrames);
+
+		CreateWorlds();
+		MeasureLookups();
+		MeasureTimers();
+		StartTickComponents(TickScenarios[TickScenarioIndex]);
+
+		FTickerDelegate Delegate;
+		Delegate.BindRaw(this, &FBenchmark::Tick);
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(Delegate);
+	}
+
+	bool FBenchmark::IsFinished() const
+	{
+		return bIsFinished;
+	}
+
+	bool FBenchmark::Tick(float DeltaSeconds)
+	{
+		// The components are scheduled in the same frame, so skip the first one
+		FrameIndex++;
+		if (FrameIndex <= 1)
+		{
+			return true;
+		}
+
+		const FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+		DispatchSeconds.Add(Scheduler.GetLastDispatchSeconds());
+
+		if (DispatchSeconds.Num() < NumFrames)
+		{
+			return true;
+		}
+
+		const FString ScenarioName = TickScenarios[TickScenarioIndex].Name;
+		AddFrameHistogram(ScenarioName, DispatchSeconds);
+		AddFrameResults(ScenarioName, DispatchSeconds);
+
+		StopTickComponents();
+
+		TickScenarioIndex++;
+		if (TickScenarioIndex < static_cast<int32>(UE_ARRAY_COUNT(TickScenarios)))
+		{
+			FrameIndex = 0;
+			DispatchSeconds.Reset();
+			StartTickComponents(TickScenarios[TickScenarioIndex]);
+			return true;
+		}
+
+		DestroyWorlds();
+		WriteResults();
+
+		UE_LOG(LogCommonSubsystems, Display, TEXT("Benchmark finished."));
+
+		bIsFinished = true;
+		TickerHandle.Reset();
+
+		if (bExitWhenDone)
+		{
+			RequestEngineExit(TEXT("CommonSubsystems benchmark finished"));
+		}
+
+		return false;
+	}
+
+	void FBenchmark::CreateWorlds()
+	{
+		const uint64 StartMemory = FPlatformMemory::GetStats().UsedPhysical;
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 WorldIndex = 0; WorldIndex < NumWorlds; WorldIndex++)
+		{
+			// Named packages, as "Untitled" levels are blocked by the common world subsystems by default
+			const FString WorldName = FString::Printf(TEXT("CommonSubsystemsBenchmark_%d"), WorldIndex);
+			UPackage* WorldPackage = CreatePackage(*FString::Printf(TEXT("/Temp/%s"), *WorldName));
+
+			UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, *WorldName, WorldPackage);
+			Worlds.Add(World);
+		}
+
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+		const uint64 EndMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+		// Created worlds don't load a map, so run what the map load would
+		const double InitStartTime = FPlatformTime::Seconds();
+		for (const UWorld* World : Worlds)
+		{
+			if (auto* Manager = World->GetSubsystem<UCommonWorldSubsystemManager>())
+			{
+				Manager->InitializeWorld();
+			}
+		}
+
+		const double InitElapsedSeconds = FPlatformTime::Seconds() - InitStartTime;
+
+		int32 NumSubsystems = 0;
+		for (const UWorld* World : Worlds)
+		{
+			NumSubsystems += World->GetSubsystemArray<UCommonWorldSubsystem>().Num();
+		}
+
+		AddResult(TEXT("Worlds"), Worlds.Num(), TEXT("count"));
+		AddResult(TEXT("WorldSubsystems"), NumSubsystems, TEXT("count"));
+		AddResult(TEXT("CreationTime"), ElapsedSeconds * 1000.0, TEXT("ms"));
+		AddResult(TEXT("CreationTimePerWorld"), ElapsedSeconds * 1000.0 / FMath::Max(Worlds.Num(), 1), TEXT("ms"));
+		AddResult(TEXT("WorldInitTime"), InitElapsedSeconds * 1000.0, TEXT("ms"));
+		AddResult(TEXT("CreationMemory"), static_cast<double>(EndMemory - FMath::Min(StartMemory, EndMemory)) / 1024.0,
+			TEXT("KiB"));
+	}
+
+	void FBenchmark::MeasureLookups()
+	{
+		TArray<UClass*> SubsystemClasses;
+		for (TObjectIterator<UClass> It; It; ++It)
+		{
+			UClass* Class = *It;
+			if (Class->IsChildOf<UCommonWorldSubsystem>() && !Class->HasAnyClassFlags(CLASS_Abstract))
+			{
+				SubsystemClasses.Add(Class);
+			}
+		}
+
+		FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+
+		TArray<FLookupKey> Keys;
+		for (const UWorld* World : Worlds)
+		{
+			for (UClass* Class : SubsystemClasses)
+			{
+				if (World->GetSubsystemBase(Class))
+				{
+					Keys.Add({ World, Class, Cache.GetClassSlot(Class) });
+				}
+			}
+		}
+
+		// Every iteration goes through all the keys, so that consecutive lookups never have the same key
+		const int32 NumLookups = Keys.Num() * NumLookupIterations;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumLookupIterations; Iteration++)
+		{
+			for (const FLookupKey& Key : Keys)
+			{
+				DoNotOptimize(Cache.Find(Key.World, Key.Slot));
+			}
+		}
+		const double CachedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumLookupIterations; Iteration++)
+		{
+			for (const FLookupKey& Key : Keys)
+			{
+				DoNotOptimize(Key.World->GetSubsystemBase(Key.Class));
+			}
+		}
+		const double EngineSeconds = FPlatformTime::Seconds() - StartTime;
+
+		const double LookupDivider = FMath::Max(NumLookups, 1);
+		AddResult(TEXT("Lookups"), NumLookups, TEXT("count"));
+		AddResult(TEXT("CachedLookup"), CachedSeconds * 1e9 / LookupDivider, TEXT("ns"));
+		AddResult(TEXT("EngineLookup"), EngineSeconds * 1e9 / LookupDivider, TEXT("ns"));
+	}
+
+	void FBenchmark::MeasureTimers()
+	{
+		// Same delays for both, spread over 10 seconds, with every fourth timer cancelled
+		constexpr float FrameSeconds = 1.f / 60.f;
+		constexpr int32 MaxFrames = 11 * 60;
+
+		TArray<float> Delays;
+		Delays.Reserve(NumTimers);
+
+		FRandomStream RandomStream(NumTimers);
+		for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+		{
+			Delays.Add(RandomStream.FRandRange(0.1f, 10.f));
+		}
+
+		{
+			FCommonTimerWheel TimerWheel;
+			TArray<FCommonTimerHandle> Handles;
+			TArray<FCommonExpiredTimer> ExpiredTimers;
+			Handles.Reserve(NumTimers);
+
+			const double AddStartTime = FPlatformTime::Seconds();
+			for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+			{
+				Handles.Add(TimerWheel.Add(Delays[TimerIndex], TimerIndex));
+			}
+
+			const double RemoveStartTime = FPlatformTime::Seconds();
+			for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex += 4)
+			{
+				TimerWheel.Remove(Handles[TimerIndex]);
+			}
+
+			const double AdvanceStartTime = FPlatformTime::Seconds();
+			uint64 PayloadSum = 0;
+			for (int32 Frame = 0; Frame < MaxFrames && TimerWheel.Num() > 0; Frame++)
+			{
+				ExpiredTimers.Reset();
+				TimerWheel.Advance(FrameSeconds, ExpiredTimers);
+
+				for (const FCommonExpiredTimer& ExpiredTimer : ExpiredTimers)
+				{
+					PayloadSum += ExpiredTimer.Payload;
+				}
+			}
+
+			const double EndTime = FPlatformTime::Seconds();
+
+			AddResult(TEXT("TimerWheelAdd"), (RemoveStartTime - AddStartTime) * 1e9 / NumTimers, TEXT("ns"));
+			AddResult(TEXT("TimerWheelRemove"), (AdvanceStartTime - RemoveStartTime) * 1e9 / (NumTimers / 4),
+				TEXT("ns"));
+			AddResult(TEXT("TimerWheelExpireAll"), (EndTime - AdvanceStartTime) * 1000.0, TEXT("ms"));
+
+			UE_LOG(LogCommonSubsystems, Verbose, TEXT("Timer wheel sink: %llu"), PayloadSum);
+		}
+
+		{
+			FTimerManager TimerManager;
+			TArray<FTimerHandle> Handles;
+			Handles.SetNum(NumTimers);
+
+			uint64 PayloadSum = 0;
+
+			const double AddStartTime = FPlatformTime::Seconds();
+			for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+			{
+				TimerManager.SetTimer(Handles[TimerIndex], FTimerDelegate::CreateLambda([&PayloadSum, TimerIndex]
+				{
+					PayloadSum += TimerIndex;
+				}), Delays[TimerIndex], false);
+			}
+
+			const double RemoveStartTime = FPlatformTime::Seconds();
+			for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex += 4)
+			{
+				TimerManager.ClearTimer(Handles[TimerIndex]);
+			}
+
+			// The timer manager ticks once per engine frame, so pretend frames pass
+			const uint64 FrameCounter = GFrameCounter;
+
+			const double AdvanceStartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < MaxFrames; Frame++)
+			{
+				GFrameCounter++;
+				TimerManager.Tick(FrameSeconds);
+			}
+
+			const double EndTime = FPlatformTime::Seconds();
+
+			GFrameCounter = FrameCounter;
+
+			AddResult(TEXT("TimerManagerAdd"), (RemoveStartTime - AddStartTime) * 1e9 / NumTimers, TEXT("ns"));
+			AddResult(TEXT("TimerManagerRemove"), (AdvanceStartTime - RemoveStartTime) * 1e9 / (NumTimers / 4),
+				TEXT("ns"));
+			AddResult(TEXT("TimerManagerExpireAll"), (EndTime - AdvanceStartTime) * 1000.0, TEXT("ms"));
+
+			UE_LOG(LogCommonSubsystems, Verbose, TEXT("Timer manager sink: %llu"), PayloadSum);
+		}
+	}
+
+	void FBenchmark::StartTickComponents(const FTickScenario& Scenario)
+	{
+		const uint64 StartMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+		for (int32 Index = 0; Index < NumTickComponents; Index++)
+		{
+			TUniquePtr<FEmptyTickComponent>& TickComponent = TickComponents.Add_GetRef(
+				MakeUnique<FEmptyTickComponent>());
+			TickComponent->Start(Scenario.TickInterval, Scenario.bAlignTickInterval);
+		}
+
+		const uint64 EndMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+		// Same components every scenario, so the first one is enough
+		if (&Scenario != &TickScenarios[0])
+		{
+			return;
+		}
+
+		AddResult(TEXT("TickComponents"), TickComponents.Num(), TEXT("count"));
+		AddResult(TEXT("TickComponentsMemory"), static_cast<double>(EndMemory - FMath::Min(StartMemory, EndMemory)) /
+			1024.0, TEXT("KiB"));
+	}
+
+	void FBenchmark::StopTickComponents()
+	{
+		for (const TUniquePtr<FEmptyTickComponent>& TickComponent : TickComponents)
+		{
+			TickComponent->Stop();
+		}
+
+		TickComponents.Reset();
+	}
+
+	void FBenchmark::DestroyWorlds()
+	{
+		if (Worlds.IsEmpty())
+		{
+			return;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (UWorld* World : Worlds)
+		{
+			World->DestroyWorld(false);
+			if (World->IsRooted())
+			{
+				World->RemoveFromRoot();
+			}
+		}
+
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+		AddResult(TEXT("TeardownTime"), ElapsedSeconds * 1000.0, TEXT("ms"));
+		AddResult(TEXT("TeardownTimePerWorld"), ElapsedSeconds * 1000.0 / Worlds.Num(), TEXT("ms"));
+
+		Worlds.Reset();
+		GEngine->ForceGarbageCollection(true);
+	}
+
+	void FBenchmark::AddFrameResults(const FString& Prefix, TArray<double>& FrameSeconds)
+	{
+		if (FrameSeconds.IsEmpty())
+		{
+			return;
+		}
+
+		FrameSeconds.Sort();
+
+		double TotalSeconds = 0.0;
+		for (const double Seconds : FrameSeconds)
+		{
+			TotalSeconds += Seconds;
+		}
+
+		const int32 LastIndex = FrameSeconds.Num() - 1;
+		const double AverageSeconds = TotalSeconds / FrameSeconds.Num();
+
+		AddResult(Prefix + TEXT("Frames"), FrameSeconds.Num(), TEXT("count"));
+		AddResult(Prefix + TEXT("FrameAverage"), AverageSeconds * 1e6, TEXT("us"));
+		AddResult(Prefix + TEXT("FrameP50"), FrameSeconds[LastIndex / 2] * 1e6, TEXT("us"));
+		AddResult(Prefix + TEXT("FrameP99"), FrameSeconds[LastIndex * 99 / 100] * 1e6, TEXT("us"));
+		AddResult(Prefix + TEXT("FrameMax"), FrameSeconds[LastIndex] * 1e6, TEXT("us"));
+		AddResult(Prefix + TEXT("PerComponent"), AverageSeconds * 1e9 / FMath::Max(NumTickComponents, 1), TEXT("ns"));
+	}
+
+	void FBenchmark::AddFrameHistogram(const FString& Prefix, TConstArrayView<double> FrameSeconds)
+	{
+		int32 BucketCounts[NumHistogramBounds + 1] = {};
+		for (const double Seconds : FrameSeconds)
+		{
+			const double Us = Seconds * 1e6;
+
+			int32 BucketIndex = 0;
+			while (BucketIndex < NumHistogramBounds && Us >= HistogramBucketsUs[BucketIndex])
+			{
+				BucketIndex++;
+			}
+
+			BucketCounts[BucketIndex]++;
+		}
+
+		for (int32 BucketIndex = 0; BucketIndex <= NumHistogramBounds; BucketIndex++)
+		{
+			const FString BucketName = BucketIndex < NumHistogramBounds
+				? FString::Printf(TEXT("Below%.0fus"), HistogramBucketsUs[BucketIndex])
+				: FString::Printf(TEXT("Above%.0fus"), HistogramBucketsUs[BucketIndex - 1]);
+
+			AddResult(Prefix + TEXT("Histogram") + BucketName, BucketCounts[BucketIndex], TEXT("frames"));
+		}
+	}
+
+	void FBenchmark::WriteResults() const
+	{
+		const FString BaseName = FPaths::ProfilingDir() / TEXT("CommonSubsystems") /
+			FString::Printf(TEXT("Benchmark-%s"), *FDateTime::Now().ToString());
+
+		FString Csv = TEXT("Metric,Value,Unit\n");
+		const TSharedRef<FJsonObject> JsonRoot = MakeShared<FJsonObject>();
+
+		for (const FResult& Result : Results)
+		{
+			Csv += FString::Printf(TEXT("%s,%f,%s\n"), *Result.Name, Result.Value, *Result.Unit);
+
+			const TSharedRef<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+			JsonResult->SetNumberField(TEXT("Value"), Result.Value);
+			JsonResult->SetStringField(TEXT("Unit"), Result.Unit);
+			JsonRoot->SetObjectField(Result.Name, JsonResult);
+
+			UE_LOG(LogCommonSubsystems, Display, TEXT("  %s: %f %s"), *Result.Name, Result.Value, *Result.Unit);
+		}
+
+		FString Json;
+		const TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&Json);
+		FJsonSerializer::Serialize(JsonRoot, JsonWriter);
+
+		FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+		FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+
+		UE_LOG(LogCommonSubsystems, Display, TEXT("Benchmark results have been written to [%s.csv/json]."), *BaseName);
+	}
+
+	void FBenchmark::AddResult(const FString& Name, double Value, const TCHAR* Unit)
+	{
+		Results.Add({ Name, Value, Unit });
+	}
+
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		if (GBenchmark.IsValid() && !GBenchmark->IsFinished())
+		{
+			UE_LOG(LogCommonSubsystems, Warning, TEXT("Benchmark is already running."));
+			return;
+		}
+
+		TArray<FString> NumericArgs;
+		bool bExitWhenDone = false;
+		for (const FString& Arg : Args)
+		{
+			if (Arg == TEXT("-exit"))
+			{
+				bExitWhenDone = true;
+			}
+			else
+			{
+				NumericArgs.Add(Arg);
+			}
+		}
+
+		const int32 NumWorlds = NumericArgs.IsValidIndex(0) ? FCString::Atoi(*NumericArgs[0]) : 4;
+		const int32 NumTickComponents = NumericArgs.IsValidIndex(1) ? FCString::Atoi(*NumericArgs[1]) : 1000;
+		const int32 NumFrames = NumericArgs.IsValidIndex(2) ? FCString::Atoi(*NumericArgs[2]) : 300;
+
+		GBenchmark = MakeUnique<FBenchmark>(FMath::Max(NumWorlds, 0), FMath::Max(NumTickComponents, 0),
+			FMath::Max(NumFrames, 1), bExitWhenDone);
+		GBenchmark->Start();
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("CommonSubsystems.Benchmark"),
+		TEXT("Measure subsystem creation, lookup, tick dispatch and teardown costs, and write the results as CSV ")
+		TEXT("and JSON to the profiling directory.\n")
+		TEXT("Usage: CommonSubsystems.Benchmark [NumWorlds=4] [NumTickComponents=1000] [NumFrames=300] [-exit]\n")
+		TEXT("Headless: -nullrhi -unattended -ExecCmds=\"CommonSubsystems.Benchmark 4 1000 300 -exit\""),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+#endif
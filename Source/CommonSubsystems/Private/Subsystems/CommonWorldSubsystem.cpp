@@ -4,7 +4,11 @@
 
 #include "Engine/NetDriver.h"
 #include "GameMapsSettings.h"
+#include "HAL/IConsoleManager.h"
 #include "LogCategories.h"
+#include "Subsystems/CommonStartupProfiler.h"
+#include "Subsystems/CommonSubsystemMemory.h"
+#include "Subsystems/CommonWorldSubsystemManager.h"
 
 #if WITH_EDITOR
 #include "Editor.h"
@@ -13,6 +17,13 @@
 
 DEFINE_LOG_CATEGORY(LogCommonSubsystems);
 
+static int32 GCommonTickAdaptiveMaxPlayers = 0;
+static FAutoConsoleVariableRef CVarCommonTickAdaptiveMaxPlayers(
+	TEXT("CommonSubsystems.Tick.Adaptive.MaxPlayers"),
+	GCommonTickAdaptiveMaxPlayers,
+	TEXT("Number of players at which world subsystems with an adaptive tick interval tick at their maximum interval. ")
+	TEXT("0 means player count is ignored. Worlds without any player always tick at the maximum interval."));
+
 static uint8 GetNetModeInteger(ECommonNetMode NetMode)
 {
 	const uint8 NetModeInteger = static_cast<uint8>(1) << static_cast<uint8>(NetMode);
@@ -36,11 +47,38 @@ UCommonWorldSubsystem::UCommonWorldSubsystem()
 	AddSupportedNetMode(ECommonNetMode::Client);
 }
 
+void UCommonWorldSubsystem::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	// Neither the tick component nor subclass' own containers are visible to the property based count
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Tick_GetAllocatedSize() + GetAllocatedSize());
+}
+
 void UCommonWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
+	// Lasts until the next subsystem starts its creation, so that subclass' initialization is included
+	COMMON_SUBSYSTEMS_STARTUP_BEGIN_PHASE(*this, GetWorld(), Initialize);
+
 	Super::Initialize(Collection);
 
-	Tick_Initialize(FTickSignature::CreateUObject(this, &ThisClass::Tick));
+	FCommonSubsystemCache::Get().Register(*this, UCommonWorldSubsystem::StaticClass());
+
+	// Lazily created subsystems are initialized once the collection is done, and can't initialize dependencies
+	auto* Manager = UCommonWorldSubsystemManager::Get(this);
+	if (!IsValid(Manager) && !bCreateOnFirstUse)
+	{
+		Manager = Collection.InitializeDependency<UCommonWorldSubsystemManager>();
+	}
+
+	if (IsValid(Manager))
+	{
+		Manager->AddSubsystem(*this);
+	}
+
+	Tick_Initialize(FBudgetedTickSignature::CreateUObject(this, &ThisClass::TickWithBudget), GetWorld());
+	FixedTick_Initialize(FFixedTickSignature::CreateUObject(this, &ThisClass::TickFixed));
+	Timer_Initialize(FTimersExpiredSignature::CreateUObject(this, &ThisClass::OnTimersExpired));
 
 	// We can't do safe initialization until much later
 	PostInitWorldDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(
@@ -53,15 +91,73 @@ void UCommonWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 #endif
 }
 
+void UCommonWorldSubsystem::PostInitialize()
+{
+	COMMON_SUBSYSTEMS_STARTUP_END_PHASE();
+
+	Super::PostInitialize();
+
+	// All the subsystems are created by now
+	const UWorld* World = GetWorld();
+	check(IsValid(World));
+
+	for (const TSubclassOf<UCommonWorldSubsystem>& PrerequisiteClass : TickPrerequisiteSubsystems)
+	{
+		auto* Prerequisite = Cast<UCommonWorldSubsystem>(World->GetSubsystemBase(PrerequisiteClass));
+		if (IsValid(Prerequisite) && Prerequisite != this)
+		{
+			AddTickPrerequisite(*Prerequisite);
+		}
+	}
+}
+
 void UCommonWorldSubsystem::Deinitialize()
 {
+	// Normally done by the manager before any subsystem has started deinitializing
+	CloseLifetime();
+	WaitForAsyncInit();
+
 	Super::Deinitialize();
 
+	if (auto* Manager = UCommonWorldSubsystemManager::Get(this))
+	{
+		Manager->RemoveSubsystem(*this);
+	}
+
 	Tick_Deinitialize();
+
+	FCommonSubsystemCache::Get().Unregister(*this);
 }
 
 bool UCommonWorldSubsystem::ShouldCreateSubsystem(UObject* Outer) const
 {
+	// Not even worth profiling
+	if (!IsCompiledForTarget())
+	{
+		return false;
+	}
+
+	// Lasts until the subsystem is initialized, or the next one starts its creation, so that subclass' checks and the
+	// construction are included
+	COMMON_SUBSYSTEMS_STARTUP_BEGIN_PHASE(*this, Cast<UWorld>(Outer), ShouldCreateSubsystem);
+
+	const bool bShouldCreate = ShouldCreateSubsystemInternal(Outer);
+	if (!bShouldCreate)
+	{
+		COMMON_SUBSYSTEMS_STARTUP_END_PHASE();
+	}
+
+	return bShouldCreate;
+}
+
+bool UCommonWorldSubsystem::ShouldCreateSubsystemInternal(UObject* Outer) const
+{
+	// The world's manager creates it on first use instead
+	if (bCreateOnFirstUse && !FCommonLazySubsystemSet::IsEvaluating())
+	{
+		return false;
+	}
+
 	if (!Super::ShouldCreateSubsystem(Outer))
 	{
 		return false;
@@ -113,11 +209,66 @@ bool UCommonWorldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldTyp
 	return Super::DoesSupportWorldType(WorldType);
 }
 
+bool UCommonWorldSubsystem::IsCompiledForTarget() const
+{
+	return bIsCompiledForTarget;
+}
+
+FString UCommonWorldSubsystem::GetTickDebugName() const
+{
+	return GetClass()->GetName();
+}
+
+float UCommonWorldSubsystem::GetTickLoad() const
+{
+	const UWorld* World = GetWorld();
+	check(IsValid(World));
+
+	// Local and connected players alike have a player controller
+	const int32 NumPlayers = World->GetNumPlayerControllers();
+	if (NumPlayers == 0)
+	{
+		// Nobody to tick for
+		return 1.f;
+	}
+
+	const float Load = GCommonTickAdaptiveMaxPlayers > 0
+		? static_cast<float>(NumPlayers) / GCommonTickAdaptiveMaxPlayers
+		: 0.f;
+
+	return Load;
+}
+
 void UCommonWorldSubsystem::Tick(float DeltaSeconds)
 {
 	// Empty
 }
 
+void UCommonWorldSubsystem::TickWithBudget(float DeltaSeconds, FCommonTickBudget& Budget)
+{
+	Tick(DeltaSeconds);
+}
+
+void UCommonWorldSubsystem::TickFixed(float StepSeconds, int32 NumSteps)
+{
+	// Empty
+}
+
+void UCommonWorldSubsystem::OnTimersExpired(TConstArrayView<FCommonExpiredTimer> ExpiredTimers)
+{
+	// Empty
+}
+
+void UCommonWorldSubsystem::CloseLifetime()
+{
+	FCommonSubsystemCache::Get().CloseLifetime(*this);
+}
+
+SIZE_T UCommonWorldSubsystem::GetAllocatedSize() const
+{
+	return 0;
+}
+
 bool UCommonWorldSubsystem::IsNetModeSupported(ECommonNetMode NetMode) const
 {
 	const bool bIsNetModeSupported = InitializationNetModeMask | GetNetModeInteger(NetMode);
@@ -173,11 +324,26 @@ FTimerManager& UCommonWorldSubsystem::GetTimerManager() const
 	return GetWorld()->GetTimerManager();
 }
 
+bool UCommonWorldSubsystem::IsAsyncInitComplete() const
+{
+	return AsyncInitEvent.IsCompleted();
+}
+
+bool UCommonWorldSubsystem::IsCreatedOnFirstUse() const
+{
+	return bCreateOnFirstUse;
+}
+
 void UCommonWorldSubsystem::OnWorldInitialized()
 {
 	// Empty
 }
 
+UE::Tasks::FTask UCommonWorldSubsystem::OnWorldInitializedAsync(TConstArrayView<UE::Tasks::FTaskEvent> Prerequisites)
+{
+	return UE::Tasks::FTask();
+}
+
 void UCommonWorldSubsystem::AddSupportedNetMode(ECommonNetMode NetMode)
 {
 	InitializationNetModeMask |= GetNetModeInteger(NetMode);
@@ -251,6 +417,8 @@ void UCommonWorldSubsystem::PostInitWorldInternal(UWorld* NewWorld)
 	const UWorld* World = GetWorld();
 	if (IsValid(World) && World == NewWorld && !bHasPostWorldInitialized)
 	{
+		COMMON_SUBSYSTEMS_STARTUP_SCOPE(*this, World, PostInitWorld);
+
 		bHasPostWorldInitialized = true;
 
 		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostInitWorldDelegateHandle);
@@ -258,7 +426,70 @@ void UCommonWorldSubsystem::PostInitWorldInternal(UWorld* NewWorld)
 		FEditorDelegates::PostPIEStarted.Remove(PostInitPieWorldDelegateHandle);
 #endif
 
-		OnWorldInitialized();
+		{
+			COMMON_SUBSYSTEMS_STARTUP_SCOPE(*this, World, OnWorldInitialized);
+			COMMON_SUBSYSTEMS_LLM_SCOPE("WorldInitialization", GetClass()->GetFName());
+			OnWorldInitialized();
+		}
+
+		if (auto* Manager = UCommonWorldSubsystemManager::Get(this))
+		{
+			Manager->NotifyWorldInitialized(*this);
+		}
+	}
+}
+
+TArray<UCommonWorldSubsystem*> UCommonWorldSubsystem::GetAsyncInitPrerequisites() const
+{
+	const UWorld* World = GetWorld();
+	check(IsValid(World));
+
+	TArray<UCommonWorldSubsystem*> Prerequisites;
+	for (const TSubclassOf<UCommonWorldSubsystem>& PrerequisiteClass : AsyncInitPrerequisiteSubsystems)
+	{
+		auto* Prerequisite = Cast<UCommonWorldSubsystem>(World->GetSubsystemBase(PrerequisiteClass));
+		if (IsValid(Prerequisite) && Prerequisite != this)
+		{
+			Prerequisites.Add(Prerequisite);
+		}
+	}
+
+	return Prerequisites;
+}
+
+void UCommonWorldSubsystem::StartAsyncInit()
+{
+	check(!bHasStartedAsyncInit);
+	bHasStartedAsyncInit = true;
+
+	// Prerequisites that haven't started yet are part of a cycle, and waiting for them would never end
+	TArray<UE::Tasks::FTaskEvent> Prerequisites;
+	for (const UCommonWorldSubsystem* Prerequisite : GetAsyncInitPrerequisites())
+	{
+		if (Prerequisite->bHasStartedAsyncInit)
+		{
+			Prerequisites.Add(Prerequisite->AsyncInitEvent);
+		}
+	}
+
+	AsyncInitTask = OnWorldInitializedAsync(Prerequisites);
+
+	// Dependents of this subsystem transitively depend on its prerequisites as well
+	AsyncInitEvent.AddPrerequisites(Prerequisites);
+	if (AsyncInitTask.IsValid())
+	{
+		AsyncInitEvent.AddPrerequisites(AsyncInitTask);
+	}
+
+	AsyncInitEvent.Trigger();
+}
+
+void UCommonWorldSubsystem::WaitForAsyncInit()
+{
+	if (AsyncInitTask.IsValid())
+	{
+		AsyncInitTask.Wait();
+		AsyncInitTask = UE::Tasks::FTask();
 	}
 }
 
@@ -0,0 +1,336 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/CommonWorldSubsystemManager.h"
+
+#include "Engine/World.h"
+#include "LogCategories.h"
+#include "Subsystems/CommonStartupProfiler.h"
+#include "Subsystems/CommonWorldSubsystem.h"
+
+#if WITH_EDITOR
+#include "Editor.h"
+#endif
+
+UCommonWorldSubsystemManager* UCommonWorldSubsystemManager::Get(const UObject* ContextObject)
+{
+	if (!IsValid(ContextObject))
+	{
+		return nullptr;
+	}
+
+	const UWorld* World = ContextObject->GetWorld();
+	if (!IsValid(World))
+	{
+		return nullptr;
+	}
+
+	auto* Manager = World->GetSubsystem<UCommonWorldSubsystemManager>();
+	return Manager;
+}
+
+void UCommonWorldSubsystemManager::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	auto* This = CastChecked<ThisClass>(InThis);
+	This->LazySubsystems.AddReferencedObjects(Collector);
+}
+
+void UCommonWorldSubsystemManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	EventBus = MakeUnique<FCommonEventBus>();
+
+	UWorld* World = GetWorld();
+	check(IsValid(World));
+
+	LazySubsystems.Initialize(*World, Collection, UCommonWorldSubsystem::StaticClass(),
+		[](const USubsystem& DefaultObject)
+		{
+			const bool bIsCreatedOnFirstUse = CastChecked<UCommonWorldSubsystem>(&DefaultObject)->IsCreatedOnFirstUse();
+			return bIsCreatedOnFirstUse;
+		});
+
+	// Evaluation doesn't create anything, so there's nothing more to account
+	COMMON_SUBSYSTEMS_STARTUP_END_PHASE();
+
+	PostInitWorldDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(
+		this, &ThisClass::PostInitWorldInternal);
+
+	WorldBeginTearDownDelegateHandle = FWorldDelegates::OnWorldBeginTearDown.AddUObject(
+		this, &ThisClass::OnWorldBeginTearDown);
+	WorldCleanupDelegateHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &ThisClass::OnWorldCleanup);
+
+#if WITH_EDITOR
+	PostInitPieWorldDelegateHandle = FEditorDelegates::PostPIEStarted.AddUObject(
+		this, &ThisClass::PostInitPieWorldInternal);
+#endif
+}
+
+void UCommonWorldSubsystemManager::Deinitialize()
+{
+	Super::Deinitialize();
+
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostInitWorldDelegateHandle);
+	FWorldDelegates::OnWorldBeginTearDown.Remove(WorldBeginTearDownDelegateHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupDelegateHandle);
+#if WITH_EDITOR
+	FEditorDelegates::PostPIEStarted.Remove(PostInitPieWorldDelegateHandle);
+#endif
+
+	LazySubsystems.Deinitialize();
+
+	EventBus.Reset();
+
+	FTSTicker::GetCoreTicker().RemoveTicker(PollTickerHandle);
+	PollTickerHandle.Reset();
+
+	OnSubsystemsReady.Clear();
+}
+
+bool UCommonWorldSubsystemManager::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const auto* World = CastChecked<UWorld>(Outer);
+	return World->IsGameWorld();
+}
+
+void UCommonWorldSubsystemManager::InitializeWorld()
+{
+	PostInitWorldInternal(GetWorld());
+}
+
+bool UCommonWorldSubsystemManager::CanCreateLazySubsystem(const UClass* Class) const
+{
+	return LazySubsystems.CanCreate(Class);
+}
+
+UCommonWorldSubsystem* UCommonWorldSubsystemManager::FindOrCreateLazySubsystem(const UClass* Class)
+{
+	bool bWasCreated = false;
+	auto* Subsystem = Cast<UCommonWorldSubsystem>(LazySubsystems.FindOrCreate(Class, OUT bWasCreated));
+	if (!bWasCreated)
+	{
+		return Subsystem;
+	}
+
+	// Catch up with what the other subsystems have already been through
+	UWorld* World = GetWorld();
+	check(IsValid(World));
+
+	Subsystem->PostInitialize();
+	COMMON_SUBSYSTEMS_STARTUP_END_PHASE();
+
+	if (bHasWorldInitialized)
+	{
+		Subsystem->PostInitWorldInternal(World);
+	}
+
+	if (World->HasBegunPlay())
+	{
+		Subsystem->OnWorldBeginPlay(*World);
+	}
+
+	return Subsystem;
+}
+
+bool UCommonWorldSubsystemManager::AreSubsystemsReady() const
+{
+	return bHasBroadcastReady;
+}
+
+FDelegateHandle UCommonWorldSubsystemManager::CallOrRegister_OnSubsystemsReady(
+	FOnSubsystemsReady::FDelegate&& Delegate)
+{
+	check(IsInGameThread());
+
+	if (bHasBroadcastReady)
+	{
+		Delegate.ExecuteIfBound();
+		return FDelegateHandle();
+	}
+
+	const FDelegateHandle Handle = OnSubsystemsReady.Add(MoveTemp(Delegate));
+	return Handle;
+}
+
+void UCommonWorldSubsystemManager::Unregister_OnSubsystemsReady(FDelegateHandle Handle)
+{
+	OnSubsystemsReady.Remove(Handle);
+}
+
+FCommonEventBus* UCommonWorldSubsystemManager::GetEventBus() const
+{
+	return EventBus.Get();
+}
+
+void UCommonWorldSubsystemManager::AddSubsystem(UCommonWorldSubsystem& Subsystem)
+{
+	check(IsInGameThread());
+
+	Subsystems.Add(&Subsystem);
+
+	// Lazily created subsystems start their asynchronous initialization on their own
+	if (!bHasStartedAsyncInit)
+	{
+		NumPendingSubsystems++;
+	}
+}
+
+void UCommonWorldSubsystemManager::RemoveSubsystem(UCommonWorldSubsystem& Subsystem)
+{
+	check(IsInGameThread());
+
+	if (Subsystems.Remove(&Subsystem) == 0)
+	{
+		return;
+	}
+
+	if (!Subsystem.bHasPostWorldInitialized && !bHasStartedAsyncInit)
+	{
+		NumPendingSubsystems--;
+	}
+}
+
+void UCommonWorldSubsystemManager::NotifyWorldInitialized(UCommonWorldSubsystem& Subsystem)
+{
+	check(IsInGameThread());
+
+	if (bHasStartedAsyncInit)
+	{
+		Subsystem.StartAsyncInit();
+		return;
+	}
+
+	check(NumPendingSubsystems > 0);
+	NumPendingSubsystems--;
+	if (NumPendingSubsystems == 0 && !bHasStartedAsyncInit)
+	{
+		StartAsyncInit();
+	}
+}
+
+void UCommonWorldSubsystemManager::StartAsyncInit()
+{
+	bHasStartedAsyncInit = true;
+
+	TArray<UCommonWorldSubsystem*> SortedSubsystems;
+	TArray<UCommonWorldSubsystem*> VisitingSubsystems;
+	SortedSubsystems.Reserve(Subsystems.Num());
+
+	for (UCommonWorldSubsystem* Subsystem : Subsystems)
+	{
+		AddSortedSubsystem(*Subsystem, SortedSubsystems, VisitingSubsystems);
+	}
+
+	for (UCommonWorldSubsystem* Subsystem : SortedSubsystems)
+	{
+		Subsystem->StartAsyncInit();
+		ReadyEvent.AddPrerequisites(Subsystem->AsyncInitEvent);
+	}
+
+	ReadyEvent.Trigger();
+
+	// Broadcast on the game thread, without blocking it while the asynchronous work is running
+	if (PollSubsystemsReady(0.f))
+	{
+		PollTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &ThisClass::PollSubsystemsReady));
+	}
+}
+
+void UCommonWorldSubsystemManager::AddSortedSubsystem(UCommonWorldSubsystem& Subsystem,
+	TArray<UCommonWorldSubsystem*>& OutSortedSubsystems, TArray<UCommonWorldSubsystem*>& VisitingSubsystems)
+{
+	if (OutSortedSubsystems.Contains(&Subsystem))
+	{
+		return;
+	}
+
+	if (VisitingSubsystems.Contains(&Subsystem))
+	{
+		UE_LOG(LogCommonSubsystems, Warning, TEXT("Subsystem [%s] is part of an asynchronous initialization "
+			"prerequisite cycle. The cycle is broken at it."), *Subsystem.GetName());
+		return;
+	}
+
+	VisitingSubsystems.Push(&Subsystem);
+
+	for (UCommonWorldSubsystem* Prerequisite : Subsystem.GetAsyncInitPrerequisites())
+	{
+		AddSortedSubsystem(*Prerequisite, OutSortedSubsystems, VisitingSubsystems);
+	}
+
+	VisitingSubsystems.Pop(/*bAllowShrinking*/ false);
+	OutSortedSubsystems.Add(&Subsystem);
+}
+
+void UCommonWorldSubsystemManager::OnWorldBeginTearDown(UWorld* TearingDownWorld)
+{
+	if (TearingDownWorld != GetWorld())
+	{
+		return;
+	}
+
+	for (UCommonWorldSubsystem* Subsystem : Subsystems)
+	{
+		Subsystem->CloseLifetime();
+	}
+
+	// The asynchronous initialization may be using any of them, so wait for all before anything deinitializes
+	for (UCommonWorldSubsystem* Subsystem : Subsystems)
+	{
+		Subsystem->WaitForAsyncInit();
+	}
+}
+
+void UCommonWorldSubsystemManager::OnWorldCleanup(UWorld* CleanedUpWorld, bool bSessionEnded, bool bCleanupResources)
+{
+	// Closing twice does nothing, so it doesn't matter whether the world has been torn down first
+	OnWorldBeginTearDown(CleanedUpWorld);
+}
+
+void UCommonWorldSubsystemManager::PostInitWorldInternal(UWorld* NewWorld)
+{
+	UWorld* World = GetWorld();
+	if (!IsValid(World) || World != NewWorld || bHasWorldInitialized)
+	{
+		return;
+	}
+
+	bHasWorldInitialized = true;
+
+	// Lazily created subsystems might have been created after the delegate has started broadcasting
+	for (UCommonWorldSubsystem* Subsystem : TArray<UCommonWorldSubsystem*>(Subsystems))
+	{
+		Subsystem->PostInitWorldInternal(World);
+	}
+}
+
+#if WITH_EDITOR
+void UCommonWorldSubsystemManager::PostInitPieWorldInternal(bool bSimulating)
+{
+	PostInitWorldInternal(GetWorld());
+}
+#endif
+
+bool UCommonWorldSubsystemManager::PollSubsystemsReady(float DeltaSeconds)
+{
+	if (!ReadyEvent.IsCompleted())
+	{
+		return true;
+	}
+
+	PollTickerHandle.Reset();
+	bHasBroadcastReady = true;
+
+	OnSubsystemsReady.Broadcast();
+	OnSubsystemsReady.Clear();
+
+	return false;
+}
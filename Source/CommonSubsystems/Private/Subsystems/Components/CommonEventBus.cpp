@@ -0,0 +1,151 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonEventBus.h"
+
+#include "LogCategories.h"
+#include "Misc/ScopeLock.h"
+#include "Subsystems/Components/CommonTickScheduler.h"
+
+static FCriticalSection GEventTypeIdsCriticalSection;
+static TMap<const UScriptStruct*, int32> GEventTypeIds;
+static std::atomic<int32> GNumEventTypes = 0;
+
+FCommonEventBus::FCommonEventBus()
+{
+	check(IsInGameThread());
+
+	for (std::atomic<FChannelBase*>& Channel : Channels)
+	{
+		Channel.store(nullptr, std::memory_order_relaxed);
+	}
+
+	FCommonTickScheduler::Get().AddEventBus(*this);
+}
+
+FCommonEventBus::~FCommonEventBus()
+{
+	check(IsInGameThread());
+
+	FCommonTickScheduler::Get().RemoveEventBus(*this);
+
+	if (Delivery)
+	{
+		Delivery->bIsBusAlive = false;
+	}
+
+	for (std::atomic<FChannelBase*>& Channel : Channels)
+	{
+		FChannelBase* DeletedChannel = Channel.exchange(nullptr, std::memory_order_acq_rel);
+
+		// Destroyed by one of its subscribers, so the channel they're called by has to outlive the broadcast
+		if (!Delivery || DeletedChannel != Delivery->Channel)
+		{
+			delete DeletedChannel;
+		}
+	}
+}
+
+void FCommonEventBus::UnsubscribeAll(const void* Subscriber)
+{
+	check(IsInGameThread());
+
+	const int32 NumEventTypes = GetNumEventTypes();
+	for (int32 EventTypeId = 0; EventTypeId < NumEventTypes; EventTypeId++)
+	{
+		if (FChannelBase* Channel = Channels[EventTypeId].load(std::memory_order_acquire))
+		{
+			Channel->UnsubscribeAll(Subscriber);
+		}
+	}
+}
+
+int32 FCommonEventBus::Deliver()
+{
+	check(IsInGameThread());
+	check(!Delivery);
+
+	FDelivery CurrentDelivery;
+	Delivery = &CurrentDelivery;
+
+	int32 NumDelivered = 0;
+
+	const int32 NumEventTypes = GetNumEventTypes();
+	for (int32 EventTypeId = 0; EventTypeId < NumEventTypes; EventTypeId++)
+	{
+		FChannelBase* Channel = Channels[EventTypeId].load(std::memory_order_acquire);
+		if (!Channel || Channel->NumQueued.load(std::memory_order_relaxed) == 0)
+		{
+			continue;
+		}
+
+		CurrentDelivery.Channel = Channel;
+		NumDelivered += Channel->Deliver();
+
+		if (!CurrentDelivery.bIsBusAlive)
+		{
+			// Don't touch the bus from here on, it's been destroyed by a subscriber
+			delete Channel;
+			return NumDelivered;
+		}
+	}
+
+	Delivery = nullptr;
+
+	return NumDelivered;
+}
+
+int32 FCommonEventBus::GetNumQueued() const
+{
+	int32 NumQueued = 0;
+
+	const int32 NumEventTypes = GetNumEventTypes();
+	for (int32 EventTypeId = 0; EventTypeId < NumEventTypes; EventTypeId++)
+	{
+		if (const FChannelBase* Channel = Channels[EventTypeId].load(std::memory_order_acquire))
+		{
+			NumQueued += Channel->NumQueued.load(std::memory_order_relaxed);
+		}
+	}
+
+	return NumQueued;
+}
+
+int32 FCommonEventBus::GetEventTypeId(const UScriptStruct* EventStruct)
+{
+	check(EventStruct);
+
+	// Called once per event type per module, so the lock isn't on the posting path
+	FScopeLock Lock(&GEventTypeIdsCriticalSection);
+
+	if (const int32* ExistingId = GEventTypeIds.Find(EventStruct))
+	{
+		return *ExistingId;
+	}
+
+	const int32 NewId = GNumEventTypes.load(std::memory_order_relaxed);
+	UE_CLOG(NewId >= MaxEventTypes, LogCommonSubsystems, Fatal, TEXT("Too many event bus event types. Raise "
+		"FCommonEventBus::MaxEventTypes."));
+
+	GEventTypeIds.Add(EventStruct, NewId);
+	GNumEventTypes.store(NewId + 1, std::memory_order_release);
+
+	return NewId;
+}
+
+int32 FCommonEventBus::GetNumEventTypes()
+{
+	return GNumEventTypes.load(std::memory_order_acquire);
+}
+
+FCommonEventBus::FChannelBase* FCommonEventBus::AddChannel(int32 EventTypeId, FChannelBase* NewChannel)
+{
+	FChannelBase* ExistingChannel = nullptr;
+	if (Channels[EventTypeId].compare_exchange_strong(ExistingChannel, NewChannel, std::memory_order_acq_rel))
+	{
+		return NewChannel;
+	}
+
+	// Another thread has been faster
+	delete NewChannel;
+	return ExistingChannel;
+}
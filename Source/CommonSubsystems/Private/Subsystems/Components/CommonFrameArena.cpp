@@ -0,0 +1,138 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonFrameArena.h"
+
+#include "CommonSubsystemsStats.h"
+
+#include <atomic>
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+DECLARE_MEMORY_STAT(TEXT("Frame Arena High Water"), STAT_CommonSubsystems_FrameArenaHighWater,
+	STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frame Arena Overflows"), STAT_CommonSubsystems_FrameArenaOverflows,
+	STATGROUP_CommonSubsystems);
+
+/** Highest high-water mark of all the arenas in bytes. */
+static std::atomic<SIZE_T> GCommonFrameArenaHighWaterBytes = 0;
+#endif
+
+/** Alignment of the allocations that don't ask for a specific one. */
+static constexpr uint32 DefaultArenaAlignment = 16;
+
+static thread_local FCommonFrameArena* GCurrentFrameArena = nullptr;
+
+FCommonFrameArena::FScope::FScope(FCommonFrameArena* InArena)
+	: Arena(InArena)
+	, PreviousArena(GCurrentFrameArena)
+{
+	GCurrentFrameArena = Arena;
+}
+
+FCommonFrameArena::FScope::~FScope()
+{
+	GCurrentFrameArena = PreviousArena;
+
+	if (Arena)
+	{
+		Arena->Reset();
+	}
+}
+
+FCommonFrameArena::FCommonFrameArena(SIZE_T InCapacity)
+	: Capacity(InCapacity)
+{
+}
+
+FCommonFrameArena::~FCommonFrameArena()
+{
+	Reset();
+
+	if (Memory)
+	{
+		FMemory::Free(Memory);
+	}
+}
+
+FCommonFrameArena* FCommonFrameArena::GetCurrent()
+{
+	return GCurrentFrameArena;
+}
+
+void* FCommonFrameArena::Allocate(SIZE_T Size, uint32 Alignment)
+{
+	const uint32 EffectiveAlignment = Alignment == DEFAULT_ALIGNMENT
+		? DefaultArenaAlignment
+		: FMath::Max(Alignment, DefaultArenaAlignment);
+
+	if (!Memory && Capacity > 0)
+	{
+		Memory = static_cast<uint8*>(FMemory::Malloc(Capacity, DefaultArenaAlignment));
+	}
+
+	// The block itself is only aligned to the default, so it's the address that has to be aligned, not the offset
+	const SIZE_T AlignedOffset = Memory ? Align(Memory + Offset, EffectiveAlignment) - Memory : 0;
+	if (Memory && AlignedOffset + Size <= Capacity)
+	{
+		Offset = AlignedOffset + Size;
+		return Memory + AlignedOffset;
+	}
+
+	// Doesn't fit, so it's up to the heap until the next reset
+	void* Allocation = FMemory::Malloc(Size, EffectiveAlignment);
+	OverflowAllocations.Add(Allocation);
+	OverflowBytes += Size;
+	NumOverflows++;
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	INC_DWORD_STAT(STAT_CommonSubsystems_FrameArenaOverflows);
+#endif
+
+	return Allocation;
+}
+
+void FCommonFrameArena::Reset()
+{
+	const SIZE_T UsedBytes = Offset + OverflowBytes;
+	if (UsedBytes > HighWaterBytes)
+	{
+		HighWaterBytes = UsedBytes;
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+		// Arenas reset concurrently on the workers ticking their components
+		SIZE_T GlobalHighWaterBytes = GCommonFrameArenaHighWaterBytes.load(std::memory_order_relaxed);
+		while (HighWaterBytes > GlobalHighWaterBytes)
+		{
+			if (GCommonFrameArenaHighWaterBytes.compare_exchange_weak(GlobalHighWaterBytes, HighWaterBytes,
+				std::memory_order_relaxed))
+			{
+				SET_MEMORY_STAT(STAT_CommonSubsystems_FrameArenaHighWater, HighWaterBytes);
+				break;
+			}
+		}
+#endif
+	}
+
+	for (void* Allocation : OverflowAllocations)
+	{
+		FMemory::Free(Allocation);
+	}
+
+	OverflowAllocations.Reset();
+	OverflowBytes = 0;
+	Offset = 0;
+}
+
+SIZE_T FCommonFrameArena::GetCapacity() const
+{
+	return Capacity;
+}
+
+SIZE_T FCommonFrameArena::GetHighWaterBytes() const
+{
+	return HighWaterBytes;
+}
+
+int32 FCommonFrameArena::GetNumOverflows() const
+{
+	return NumOverflows;
+}
@@ -0,0 +1,455 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonRegistryComponent.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "UObject/UObjectArray.h"
+
+/**
+ * Object delete listener shared by all the registry components, so that the garbage collector notifies a single
+ * listener however many registries there are.
+ */
+class FCommonRegistryDeleteListener
+	: public FUObjectArray::FUObjectDeleteListener
+{
+public:
+	virtual ~FCommonRegistryDeleteListener() override;
+
+	/**
+	 * Get the listener.
+	 * @return	Delete listener.
+	 */
+	static FCommonRegistryDeleteListener& Get();
+
+	/**
+	 * Start notifying a registry about deleted objects.
+	 * @param	Registry registry to notify.
+	 */
+	void AddRegistry(FCommonRegistryComponentBase& Registry);
+
+	/**
+	 * Stop notifying a registry about deleted objects.
+	 * @param	Registry registry to stop notifying.
+	 */
+	void RemoveRegistry(FCommonRegistryComponentBase& Registry);
+
+protected:
+	//~FUObjectDeleteListener Interface
+	virtual void NotifyUObjectDeleted(const UObjectBase* Object, int32 Index) override;
+	virtual void OnUObjectArrayShutdown() override;
+	//~End of FUObjectDeleteListener Interface
+
+private:
+	/** Registries to notify. Guarded by CriticalSection. */
+	TArray<FCommonRegistryComponentBase*> Registries;
+
+	/** Guards the registries, which the garbage collector reads from any thread. */
+	FCriticalSection CriticalSection;
+
+	/** If true, the listener is added to the UObject array, false otherwise. */
+	bool bIsListening = false;
+
+	/** If true, the UObject array has been shut down, and there's nothing left to listen to. */
+	bool bIsShutDown = false;
+};
+
+FCommonRegistryDeleteListener::~FCommonRegistryDeleteListener()
+{
+	if (bIsListening)
+	{
+		GUObjectArray.RemoveUObjectDeleteListener(this);
+		bIsListening = false;
+	}
+}
+
+FCommonRegistryDeleteListener& FCommonRegistryDeleteListener::Get()
+{
+	static FCommonRegistryDeleteListener Instance;
+	return Instance;
+}
+
+void FCommonRegistryDeleteListener::AddRegistry(FCommonRegistryComponentBase& Registry)
+{
+	check(IsInGameThread());
+
+	{
+		FScopeLock Lock(&CriticalSection);
+		Registries.Add(&Registry);
+	}
+
+	// Keep listening once started, registries come and go with the worlds
+	if (!bIsListening && !bIsShutDown)
+	{
+		GUObjectArray.AddUObjectDeleteListener(this);
+		bIsListening = true;
+	}
+}
+
+void FCommonRegistryDeleteListener::RemoveRegistry(FCommonRegistryComponentBase& Registry)
+{
+	FScopeLock Lock(&CriticalSection);
+	Registries.RemoveSingleSwap(&Registry, /*bAllowShrinking*/ false);
+}
+
+void FCommonRegistryDeleteListener::NotifyUObjectDeleted(const UObjectBase* Object, int32 Index)
+{
+	// May be called from the garbage collector's threads
+	FScopeLock Lock(&CriticalSection);
+
+	for (FCommonRegistryComponentBase* Registry : Registries)
+	{
+		Registry->OnObjectDeleted(Index);
+	}
+}
+
+void FCommonRegistryDeleteListener::OnUObjectArrayShutdown()
+{
+	GUObjectArray.RemoveUObjectDeleteListener(this);
+	bIsListening = false;
+	bIsShutDown = true;
+}
+
+bool FCommonRegistryHandle::IsValid() const
+{
+	return Index != MAX_uint32;
+}
+
+void FCommonRegistryHandle::Invalidate()
+{
+	Index = MAX_uint32;
+	Generation = 0;
+}
+
+bool FCommonRegistryHandle::operator==(const FCommonRegistryHandle& Other) const
+{
+	return Index == Other.Index && Generation == Other.Generation;
+}
+
+bool FCommonRegistryHandle::operator!=(const FCommonRegistryHandle& Other) const
+{
+	return !(*this == Other);
+}
+
+FCommonRegistryComponentBase::FCommonRegistryComponentBase()
+{
+	FCommonRegistryDeleteListener::Get().AddRegistry(*this);
+}
+
+FCommonRegistryComponentBase::~FCommonRegistryComponentBase()
+{
+	UnwatchActorDestruction();
+
+	FCommonRegistryDeleteListener::Get().RemoveRegistry(*this);
+}
+
+bool FCommonRegistryComponentBase::Unregister(FCommonRegistryHandle Handle)
+{
+	check(IsInGameThread());
+
+	// Make sure the entry's object is alive
+	Flush();
+
+	const int32 SlotIndex = FindSlot(Handle);
+	if (SlotIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const UObject* Object = DenseObjects[Slots[SlotIndex].DenseIndex];
+		ObjectHandles.Remove(GUObjectArray.ObjectToIndex(Object));
+	}
+
+	RemoveEntry(SlotIndex);
+	return true;
+}
+
+bool FCommonRegistryComponentBase::Unregister(const UObject& Object)
+{
+	const FCommonRegistryHandle Handle = FindHandle(Object);
+	const bool bWasUnregistered = Unregister(Handle);
+	return bWasUnregistered;
+}
+
+bool FCommonRegistryComponentBase::IsRegistered(FCommonRegistryHandle Handle) const
+{
+	return FindSlot(Handle) != INDEX_NONE;
+}
+
+FCommonRegistryHandle FCommonRegistryComponentBase::FindHandle(const UObject& Object) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const FCommonRegistryHandle* Handle = ObjectHandles.Find(GUObjectArray.ObjectToIndex(&Object));
+	return Handle ? *Handle : FCommonRegistryHandle();
+}
+
+int32 FCommonRegistryComponentBase::GetDenseIndex(FCommonRegistryHandle Handle) const
+{
+	const int32 SlotIndex = FindSlot(Handle);
+	if (SlotIndex == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 DenseIndex = Slots[SlotIndex].DenseIndex;
+	return DenseIndex;
+}
+
+int32 FCommonRegistryComponentBase::Num() const
+{
+	return DenseObjects.Num();
+}
+
+void FCommonRegistryComponentBase::Flush()
+{
+	check(IsInGameThread());
+
+	if (!bHasDeletedEntries.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	TArray<FCommonRegistryHandle> EntriesToRemove;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		EntriesToRemove = MoveTemp(DeletedEntries);
+		bHasDeletedEntries.store(false, std::memory_order_release);
+	}
+
+	for (const FCommonRegistryHandle Handle : EntriesToRemove)
+	{
+		// The entry might have been unregistered manually in the meantime
+		const int32 SlotIndex = FindSlot(Handle);
+		if (SlotIndex != INDEX_NONE)
+		{
+			RemoveEntry(SlotIndex);
+		}
+	}
+}
+
+void FCommonRegistryComponentBase::Reset()
+{
+	check(IsInGameThread());
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		ObjectHandles.Reset();
+		DeletedEntries.Reset();
+		bHasDeletedEntries.store(false, std::memory_order_release);
+	}
+
+	// Keep the generations, so that outstanding handles don't refer to new entries
+	FreeSlots.Reset();
+	for (int32 SlotIndex = Slots.Num() - 1; SlotIndex >= 0; SlotIndex--)
+	{
+		FSlot& Slot = Slots[SlotIndex];
+		if (Slot.DenseIndex != INDEX_NONE)
+		{
+			Slot.DenseIndex = INDEX_NONE;
+			Slot.Generation++;
+		}
+
+		FreeSlots.Add(SlotIndex);
+	}
+
+	DenseObjects.Reset();
+	DenseSlots.Reset();
+	ResetData();
+
+	UnwatchActorDestruction();
+}
+
+void FCommonRegistryComponentBase::ForEachChunk(int32 ChunkSize,
+	TFunctionRef<void(int32 StartIndex, int32 EndIndex)> Callback, bool bParallel)
+{
+	check(IsInGameThread());
+
+	Flush();
+
+	const int32 NumEntries = DenseObjects.Num();
+	if (NumEntries == 0)
+	{
+		return;
+	}
+
+	const int32 SafeChunkSize = FMath::Max(ChunkSize, 1);
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumEntries, SafeChunkSize);
+
+	const EParallelForFlags Flags = bParallel && NumChunks > 1
+		? EParallelForFlags::None
+		: EParallelForFlags::ForceSingleThread;
+
+	ParallelFor(NumChunks, [NumEntries, SafeChunkSize, &Callback](int32 ChunkIndex)
+	{
+		const int32 StartIndex = ChunkIndex * SafeChunkSize;
+		const int32 EndIndex = FMath::Min(StartIndex + SafeChunkSize, NumEntries);
+		Callback(StartIndex, EndIndex);
+	}, Flags);
+}
+
+FCommonRegistryHandle FCommonRegistryComponentBase::AddEntry(UObject& Object, bool& bOutWasAdded)
+{
+	check(IsInGameThread());
+
+	// A deleted object's array index may have been reused by the object being registered
+	Flush();
+
+	bOutWasAdded = false;
+
+	const int32 ObjectIndex = GUObjectArray.ObjectToIndex(&Object);
+
+	FScopeLock Lock(&CriticalSection);
+
+	if (const FCommonRegistryHandle* ExistingHandle = ObjectHandles.Find(ObjectIndex))
+	{
+		return *ExistingHandle;
+	}
+
+	int32 SlotIndex = INDEX_NONE;
+	if (!FreeSlots.IsEmpty())
+	{
+		SlotIndex = FreeSlots.Pop(/*bAllowShrinking*/ false);
+	}
+	else
+	{
+		SlotIndex = Slots.AddDefaulted();
+	}
+
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.DenseIndex = DenseObjects.Add(&Object);
+	DenseSlots.Add(SlotIndex);
+	AddDataDefaulted();
+
+	FCommonRegistryHandle Handle;
+	Handle.Index = static_cast<uint32>(SlotIndex);
+	Handle.Generation = Slot.Generation;
+
+	ObjectHandles.Add(ObjectIndex, Handle);
+
+	if (const auto* Actor = Cast<AActor>(&Object))
+	{
+		WatchActorDestruction(*Actor);
+	}
+
+	bOutWasAdded = true;
+	return Handle;
+}
+
+UObject* FCommonRegistryComponentBase::GetObjectAt(int32 DenseIndex) const
+{
+	UObject* Object = DenseObjects[DenseIndex];
+
+	// Entries of deleted objects stay until the next flush, and their pointers are dangling meanwhile
+	if (bHasDeletedEntries.load(std::memory_order_acquire))
+	{
+		const int32 SlotIndex = DenseSlots[DenseIndex];
+
+		FCommonRegistryHandle Handle;
+		Handle.Index = static_cast<uint32>(SlotIndex);
+		Handle.Generation = Slots[SlotIndex].Generation;
+
+		FScopeLock Lock(&CriticalSection);
+
+		if (DeletedEntries.Contains(Handle))
+		{
+			return nullptr;
+		}
+	}
+
+	return Object;
+}
+
+void FCommonRegistryComponentBase::OnObjectDeleted(int32 ObjectIndex)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FCommonRegistryHandle Handle;
+	if (ObjectHandles.RemoveAndCopyValue(ObjectIndex, OUT Handle))
+	{
+		DeletedEntries.Add(Handle);
+		bHasDeletedEntries.store(true, std::memory_order_release);
+	}
+}
+
+int32 FCommonRegistryComponentBase::FindSlot(FCommonRegistryHandle Handle) const
+{
+	if (!Handle.IsValid() || !Slots.IsValidIndex(static_cast<int32>(Handle.Index)))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 SlotIndex = static_cast<int32>(Handle.Index);
+	const FSlot& Slot = Slots[SlotIndex];
+	if (Slot.Generation != Handle.Generation || Slot.DenseIndex == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	return SlotIndex;
+}
+
+void FCommonRegistryComponentBase::RemoveEntry(int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	const int32 DenseIndex = Slot.DenseIndex;
+	const int32 LastDenseIndex = DenseObjects.Num() - 1;
+
+	// The last entry takes the removed entry's place
+	if (DenseIndex != LastDenseIndex)
+	{
+		Slots[DenseSlots[LastDenseIndex]].DenseIndex = DenseIndex;
+	}
+
+	DenseObjects.RemoveAtSwap(DenseIndex, 1, /*bAllowShrinking*/ false);
+	DenseSlots.RemoveAtSwap(DenseIndex, 1, /*bAllowShrinking*/ false);
+	RemoveDataAtSwap(DenseIndex);
+
+	Slot.DenseIndex = INDEX_NONE;
+	Slot.Generation++;
+	FreeSlots.Add(SlotIndex);
+}
+
+void FCommonRegistryComponentBase::WatchActorDestruction(const AActor& Actor)
+{
+	UWorld* World = Actor.GetWorld();
+	if (!IsValid(World) || WatchedWorld.Get() == World)
+	{
+		return;
+	}
+
+	// Registries are expected to hold the actors of a single world, the others are cleaned up on deletion only
+	if (WatchedWorld.IsValid())
+	{
+		return;
+	}
+
+	WatchedWorld = World;
+	ActorDestroyedDelegateHandle = World->AddOnActorDestroyedHandler(
+		FOnActorDestroyed::FDelegate::CreateRaw(this, &FCommonRegistryComponentBase::OnActorDestroyed));
+}
+
+void FCommonRegistryComponentBase::OnActorDestroyed(AActor* Actor)
+{
+	if (Actor)
+	{
+		Unregister(*Actor);
+	}
+}
+
+void FCommonRegistryComponentBase::UnwatchActorDestruction()
+{
+	if (UWorld* World = WatchedWorld.Get())
+	{
+		World->RemoveOnActorDestroyededHandler(ActorDestroyedDelegateHandle);
+	}
+
+	WatchedWorld.Reset();
+	ActorDestroyedDelegateHandle.Reset();
+}
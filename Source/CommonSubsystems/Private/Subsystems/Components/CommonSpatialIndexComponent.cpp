@@ -0,0 +1,385 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonSpatialIndexComponent.h"
+
+#include "CommonSubsystemsStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spatial Index Commit"), STAT_CommonSubsystems_SpatialIndexCommit, STATGROUP_CommonSubsystems);
+
+static FIntVector ComponentMin(const FIntVector& A, const FIntVector& B)
+{
+	return FIntVector(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y), FMath::Min(A.Z, B.Z));
+}
+
+static FIntVector ComponentMax(const FIntVector& A, const FIntVector& B)
+{
+	return FIntVector(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y), FMath::Max(A.Z, B.Z));
+}
+
+int32 FCommonSpatialSnapshot::Num() const
+{
+	return Ids.Num();
+}
+
+void FCommonSpatialSnapshot::QueryRadius(const FVector& Center, double Radius, TArray<uint64>& OutIds) const
+{
+	if (Ids.IsEmpty() || Radius < 0.0)
+	{
+		return;
+	}
+
+	const FIntVector StartCell = ComponentMax(GetCell(Center - FVector(Radius)), MinCell);
+	const FIntVector EndCell = ComponentMin(GetCell(Center + FVector(Radius)), MaxCell);
+	const double RadiusSquared = FMath::Square(Radius);
+
+	for (int32 X = StartCell.X; X <= EndCell.X; X++)
+	{
+		for (int32 Y = StartCell.Y; Y <= EndCell.Y; Y++)
+		{
+			for (int32 Z = StartCell.Z; Z <= EndCell.Z; Z++)
+			{
+				ForEachEntryInCell(FIntVector(X, Y, Z), [&](int32 EntryIndex)
+				{
+					if (FVector::DistSquared(Locations[EntryIndex], Center) <= RadiusSquared)
+					{
+						OutIds.Add(Ids[EntryIndex]);
+					}
+				});
+			}
+		}
+	}
+}
+
+void FCommonSpatialSnapshot::QueryBox(const FBox& Box, TArray<uint64>& OutIds) const
+{
+	if (Ids.IsEmpty() || !Box.IsValid)
+	{
+		return;
+	}
+
+	const FIntVector StartCell = ComponentMax(GetCell(Box.Min), MinCell);
+	const FIntVector EndCell = ComponentMin(GetCell(Box.Max), MaxCell);
+
+	for (int32 X = StartCell.X; X <= EndCell.X; X++)
+	{
+		for (int32 Y = StartCell.Y; Y <= EndCell.Y; Y++)
+		{
+			for (int32 Z = StartCell.Z; Z <= EndCell.Z; Z++)
+			{
+				ForEachEntryInCell(FIntVector(X, Y, Z), [&](int32 EntryIndex)
+				{
+					if (Box.IsInsideOrOn(Locations[EntryIndex]))
+					{
+						OutIds.Add(Ids[EntryIndex]);
+					}
+				});
+			}
+		}
+	}
+}
+
+void FCommonSpatialSnapshot::QueryNearest(const FVector& Center, int32 MaxCount, TArray<uint64>& OutIds,
+	double MaxRadius) const
+{
+	if (Ids.IsEmpty() || MaxCount <= 0 || MaxRadius < 0.0)
+	{
+		return;
+	}
+
+	const FIntVector CenterCell = GetCell(Center);
+	const double MaxRadiusSquared = FMath::Square(MaxRadius);
+
+	// No ring past the furthest non-empty cell, or past the max radius, can contain anything
+	const FIntVector ToMin = CenterCell - MinCell;
+	const FIntVector ToMax = MaxCell - CenterCell;
+	const int32 BoundsRing = FMath::Max3(
+		FMath::Max(FMath::Abs(ToMin.X), FMath::Abs(ToMax.X)),
+		FMath::Max(FMath::Abs(ToMin.Y), FMath::Abs(ToMax.Y)),
+		FMath::Max(FMath::Abs(ToMin.Z), FMath::Abs(ToMax.Z)));
+
+	const double RadiusRing = FMath::CeilToDouble(MaxRadius * InvCellSize) + 1.0;
+	const int32 MaxRing = RadiusRing < static_cast<double>(BoundsRing) ? static_cast<int32>(RadiusRing) : BoundsRing;
+
+	// Cells worth visiting relative to the center cell, i.e. the non-empty cells' bounds within the max ring
+	const FIntVector SearchMin(FMath::Max(-MaxRing, -ToMin.X), FMath::Max(-MaxRing, -ToMin.Y),
+		FMath::Max(-MaxRing, -ToMin.Z));
+	const FIntVector SearchMax(FMath::Min(MaxRing, ToMax.X), FMath::Min(MaxRing, ToMax.Y),
+		FMath::Min(MaxRing, ToMax.Z));
+
+	if (SearchMin.X > SearchMax.X || SearchMin.Y > SearchMax.Y || SearchMin.Z > SearchMax.Z)
+	{
+		return;
+	}
+
+	// Squared distance and entry index
+	TArray<TPair<double, int32>> Candidates;
+
+	const int64 NumSearchCells = (static_cast<int64>(SearchMax.X) - SearchMin.X + 1) *
+		(static_cast<int64>(SearchMax.Y) - SearchMin.Y + 1) * (static_cast<int64>(SearchMax.Z) - SearchMin.Z + 1);
+
+	// Sparse entries spread over a large volume are cheaper to scan than their cells
+	if (NumSearchCells > Ids.Num())
+	{
+		for (int32 EntryIndex = 0; EntryIndex < Locations.Num(); EntryIndex++)
+		{
+			const double DistanceSquared = FVector::DistSquared(Locations[EntryIndex], Center);
+			if (DistanceSquared <= MaxRadiusSquared)
+			{
+				Candidates.Emplace(DistanceSquared, EntryIndex);
+			}
+		}
+	}
+	else
+	{
+		const auto AddCandidates = [&](int32 X, int32 Y, int32 Z)
+		{
+			ForEachEntryInCell(CenterCell + FIntVector(X, Y, Z), [&](int32 EntryIndex)
+			{
+				const double DistanceSquared = FVector::DistSquared(Locations[EntryIndex], Center);
+				if (DistanceSquared <= MaxRadiusSquared)
+				{
+					Candidates.Emplace(DistanceSquared, EntryIndex);
+				}
+			});
+		};
+
+		// Rings closer than the bounds have no cells in them
+		const int32 MinRing = FMath::Max(FMath::Max3(
+			FMath::Max(SearchMin.X, -SearchMax.X),
+			FMath::Max(SearchMin.Y, -SearchMax.Y),
+			FMath::Max(SearchMin.Z, -SearchMax.Z)), 0);
+
+		for (int32 Ring = MinRing; Ring <= MaxRing; Ring++)
+		{
+			// Walk the shell of cells at the given distance from the center cell only, clipped to the bounds
+			const FIntVector ShellMin(FMath::Max(-Ring, SearchMin.X), FMath::Max(-Ring, SearchMin.Y),
+				FMath::Max(-Ring, SearchMin.Z));
+			const FIntVector ShellMax(FMath::Min(Ring, SearchMax.X), FMath::Min(Ring, SearchMax.Y),
+				FMath::Min(Ring, SearchMax.Z));
+
+			for (int32 X = ShellMin.X; X <= ShellMax.X; X++)
+			{
+				for (int32 Y = ShellMin.Y; Y <= ShellMax.Y; Y++)
+				{
+					if (FMath::Abs(X) == Ring || FMath::Abs(Y) == Ring)
+					{
+						for (int32 Z = ShellMin.Z; Z <= ShellMax.Z; Z++)
+						{
+							AddCandidates(X, Y, Z);
+						}
+					}
+					else
+					{
+						if (ShellMin.Z == -Ring)
+						{
+							AddCandidates(X, Y, -Ring);
+						}
+
+						if (ShellMax.Z == Ring)
+						{
+							AddCandidates(X, Y, Ring);
+						}
+					}
+				}
+			}
+
+			if (Candidates.Num() >= MaxCount)
+			{
+				Candidates.Sort([](const TPair<double, int32>& Lhs, const TPair<double, int32>& Rhs)
+				{
+					return Lhs.Key < Rhs.Key;
+				});
+
+				Candidates.SetNum(MaxCount, /*bAllowShrinking*/ false);
+
+				// Entries of the next rings are at least this far
+				const double NextRingDistance = static_cast<double>(Ring) * CellSize;
+				if (Candidates.Last().Key <= FMath::Square(NextRingDistance))
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	Candidates.Sort([](const TPair<double, int32>& Lhs, const TPair<double, int32>& Rhs)
+	{
+		return Lhs.Key < Rhs.Key;
+	});
+
+	const int32 NumFound = FMath::Min(Candidates.Num(), MaxCount);
+	OutIds.Reserve(OutIds.Num() + NumFound);
+
+	for (int32 Index = 0; Index < NumFound; Index++)
+	{
+		OutIds.Add(Ids[Candidates[Index].Value]);
+	}
+}
+
+FIntVector FCommonSpatialSnapshot::GetCell(const FVector& Location) const
+{
+	// Locations far away, e.g. bounds of huge queries, are clamped rather than overflowing
+	const auto ToCellCoordinate = [this](double Coordinate)
+	{
+		const double Scaled = FMath::Clamp(Coordinate * InvCellSize, static_cast<double>(MIN_int32 / 2),
+			static_cast<double>(MAX_int32 / 2));
+
+		return FMath::FloorToInt32(Scaled);
+	};
+
+	const FIntVector Cell(ToCellCoordinate(Location.X), ToCellCoordinate(Location.Y), ToCellCoordinate(Location.Z));
+	return Cell;
+}
+
+void FCommonSpatialSnapshot::ForEachEntryInCell(const FIntVector& Cell,
+	TFunctionRef<void(int32 EntryIndex)> Callback) const
+{
+	const FCellRange* Range = Cells.Find(Cell);
+	if (!Range)
+	{
+		return;
+	}
+
+	for (int32 EntryIndex = Range->Start; EntryIndex < Range->Start + Range->Num; EntryIndex++)
+	{
+		Callback(EntryIndex);
+	}
+}
+
+FCommonSpatialIndexComponent::FCommonSpatialIndexComponent(double InCellSize)
+	: CellSize(FMath::Max(InCellSize, UE_KINDA_SMALL_NUMBER))
+	, Snapshot(MakeShared<const FCommonSpatialSnapshot, ESPMode::ThreadSafe>())
+{
+}
+
+void FCommonSpatialIndexComponent::Update(uint64 Id, const FVector& Location)
+{
+	if (FVector* StagedLocation = StagedLocations.Find(Id))
+	{
+		if (*StagedLocation == Location)
+		{
+			return;
+		}
+
+		*StagedLocation = Location;
+	}
+	else
+	{
+		StagedLocations.Add(Id, Location);
+	}
+
+	bIsDirty = true;
+}
+
+void FCommonSpatialIndexComponent::Remove(uint64 Id)
+{
+	if (StagedLocations.Remove(Id) > 0)
+	{
+		bIsDirty = true;
+	}
+}
+
+void FCommonSpatialIndexComponent::Reset()
+{
+	if (!StagedLocations.IsEmpty())
+	{
+		StagedLocations.Reset();
+		bIsDirty = true;
+	}
+}
+
+int32 FCommonSpatialIndexComponent::Num() const
+{
+	return StagedLocations.Num();
+}
+
+bool FCommonSpatialIndexComponent::Commit()
+{
+	if (!bIsDirty)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_CommonSubsystems_SpatialIndexCommit);
+
+	bIsDirty = false;
+
+	// Snapshots in use elsewhere are left untouched, so a new one is built from scratch
+	const TSharedRef<FCommonSpatialSnapshot, ESPMode::ThreadSafe> NewSnapshot =
+		MakeShared<FCommonSpatialSnapshot, ESPMode::ThreadSafe>();
+
+	NewSnapshot->CellSize = CellSize;
+	NewSnapshot->InvCellSize = 1.0 / CellSize;
+
+	struct FBuildEntry
+	{
+		FIntVector Cell;
+		FVector Location;
+		uint64 Id;
+	};
+
+	TArray<FBuildEntry> BuildEntries;
+	BuildEntries.Reserve(StagedLocations.Num());
+
+	for (const TPair<uint64, FVector>& Pair : StagedLocations)
+	{
+		BuildEntries.Add({ NewSnapshot->GetCell(Pair.Value), Pair.Value, Pair.Key });
+	}
+
+	BuildEntries.Sort([](const FBuildEntry& Lhs, const FBuildEntry& Rhs)
+	{
+		if (Lhs.Cell.X != Rhs.Cell.X)
+		{
+			return Lhs.Cell.X < Rhs.Cell.X;
+		}
+
+		if (Lhs.Cell.Y != Rhs.Cell.Y)
+		{
+			return Lhs.Cell.Y < Rhs.Cell.Y;
+		}
+
+		return Lhs.Cell.Z < Rhs.Cell.Z;
+	});
+
+	NewSnapshot->Locations.Reserve(BuildEntries.Num());
+	NewSnapshot->Ids.Reserve(BuildEntries.Num());
+
+	if (!BuildEntries.IsEmpty())
+	{
+		NewSnapshot->MinCell = BuildEntries[0].Cell;
+		NewSnapshot->MaxCell = BuildEntries[0].Cell;
+	}
+
+	int32 CellStart = 0;
+	for (int32 EntryIndex = 0; EntryIndex < BuildEntries.Num(); EntryIndex++)
+	{
+		const FBuildEntry& BuildEntry = BuildEntries[EntryIndex];
+
+		NewSnapshot->Locations.Add(BuildEntry.Location);
+		NewSnapshot->Ids.Add(BuildEntry.Id);
+
+		// Close the cell once its last entry has been added
+		const bool bIsLastInCell = EntryIndex == BuildEntries.Num() - 1 ||
+			BuildEntries[EntryIndex + 1].Cell != BuildEntry.Cell;
+
+		if (bIsLastInCell)
+		{
+			FCommonSpatialSnapshot::FCellRange& Range = NewSnapshot->Cells.Add(BuildEntry.Cell);
+			Range.Start = CellStart;
+			Range.Num = EntryIndex - CellStart + 1;
+
+			NewSnapshot->MinCell = ComponentMin(NewSnapshot->MinCell, BuildEntry.Cell);
+			NewSnapshot->MaxCell = ComponentMax(NewSnapshot->MaxCell, BuildEntry.Cell);
+
+			CellStart = EntryIndex + 1;
+		}
+	}
+
+	Snapshot = NewSnapshot;
+	return true;
+}
+
+FCommonSpatialIndexComponent::FSnapshotRef FCommonSpatialIndexComponent::GetSnapshot() const
+{
+	return Snapshot;
+}
@@ -2,22 +2,78 @@
 
 #include "Subsystems/Components/CommonTickComponent.h"
 
+#include "CommonSubsystemsStats.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Subsystems/Components/CommonTickScheduler.h"
+#include "Subsystems/Components/CommonWorldTickFunction.h"
+#include "Subsystems/CommonSubsystemMemory.h"
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+#include "HAL/IConsoleManager.h"
+#include "LogCategories.h"
+
+static float GCommonTickHitchThresholdMs = 0.f;
+static FAutoConsoleVariableRef CVarCommonTickHitchThresholdMs(
+	TEXT("CommonSubsystems.Tick.HitchThresholdMs"),
+	GCommonTickHitchThresholdMs,
+	TEXT("Ticks taking longer than this many milliseconds are logged along with their delta time and tick interval. ")
+	TEXT("0 disables the reports."));
+#endif
+
+FCommonTickBudget::FCommonTickBudget(double InStartTime, double InEndTime)
+	: StartTime(InStartTime)
+	, EndTime(InEndTime)
+{
+}
+
+bool FCommonTickBudget::IsExhausted() const
+{
+	const bool bIsExhausted = FPlatformTime::Seconds() >= EndTime;
+	return bIsExhausted;
+}
+
+double FCommonTickBudget::GetRemainingSeconds() const
+{
+	const double RemainingSeconds = FMath::Max(EndTime - FPlatformTime::Seconds(), 0.0);
+	return RemainingSeconds;
+}
+
+double FCommonTickBudget::GetElapsedSeconds() const
+{
+	const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+	return ElapsedSeconds;
+}
+
+void FCommonTickBudget::Yield()
+{
+	bHasYielded = true;
+}
+
+bool FCommonTickBudget::HasYielded() const
+{
+	return bHasYielded;
+}
+
 FCommonTickComponent::~FCommonTickComponent()
 {
 	Tick_Deinitialize();
 }
 
-void FCommonTickComponent::Tick_Initialize(const FTickSignature& Callback)
+void FCommonTickComponent::Tick_Initialize(const FTickSignature& Callback, UWorld* TickWorld)
 {
 	TickDelegate = Callback;
+	BudgetedTickDelegate.Unbind();
 
-	bIsTickEnabled = bStartWithTickEnabled;
-	InternalTickInterval = TickInterval;
+	InitializeTicking(TickWorld);
+}
 
-	if (bIsTickEnabled)
-	{
-		StartTicking();
-	}
+void FCommonTickComponent::Tick_Initialize(const FBudgetedTickSignature& Callback, UWorld* TickWorld)
+{
+	BudgetedTickDelegate = Callback;
+	TickDelegate.Unbind();
+
+	InitializeTicking(TickWorld);
 }
 
 void FCommonTickComponent::Tick_Deinitialize()
@@ -26,6 +82,29 @@ void FCommonTickComponent::Tick_Deinitialize()
 	{
 		StopTicking();
 	}
+
+	if (WorldTickFunction.IsValid())
+	{
+		WorldTickFunction->UnRegisterTickFunction();
+		WorldTickFunction.Reset();
+	}
+
+	ClearTickPrerequisites();
+
+	TimerWheel.Reset();
+	TimersExpiredDelegate.Unbind();
+
+	FixedTickDelegate.Unbind();
+	FixedTickAccumulator = 0.0;
+	NumDroppedFixedTicks = 0;
+
+	FrameArena.Reset();
+
+	if (TickAliveFlag.IsValid())
+	{
+		*TickAliveFlag = false;
+		TickAliveFlag.Reset();
+	}
 }
 
 void FCommonTickComponent::EnableTick(bool bEnable)
@@ -53,11 +132,70 @@ void FCommonTickComponent::SetTickIntervalTime(float InTickInterval)
 	}
 
 	InternalTickInterval = InTickInterval;
-	if (bIsTickEnabled)
+	EffectiveTickInterval = InTickInterval;
+
+	if (WorldTickFunction.IsValid())
 	{
-		StopTicking();
-		StartTicking();
+		WorldTickFunction->UpdateTickIntervalAndCoolDown(InternalTickInterval);
+	}
+	else if (bIsTickEnabled)
+	{
+		FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+		Scheduler.Reschedule(*this);
+	}
+}
+
+void FCommonTickComponent::AddTickPrerequisite(FCommonTickComponent& Prerequisite)
+{
+	check(&Prerequisite != this);
+
+	if (TickPrerequisites.Contains(&Prerequisite))
+	{
+		return;
 	}
+
+	TickPrerequisites.Add(&Prerequisite);
+	Prerequisite.TickDependents.Add(this);
+
+	FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+	Scheduler.MarkGraphDirty();
+}
+
+void FCommonTickComponent::RemoveTickPrerequisite(FCommonTickComponent& Prerequisite)
+{
+	if (TickPrerequisites.RemoveSingleSwap(&Prerequisite) == 0)
+	{
+		return;
+	}
+
+	Prerequisite.TickDependents.RemoveSingleSwap(this);
+
+	FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+	Scheduler.MarkGraphDirty();
+}
+
+void FCommonTickComponent::ClearTickPrerequisites()
+{
+	if (TickPrerequisites.IsEmpty() && TickDependents.IsEmpty())
+	{
+		return;
+	}
+
+	for (FCommonTickComponent* Prerequisite : TickPrerequisites)
+	{
+		Prerequisite->TickDependents.RemoveSingleSwap(this);
+	}
+
+	for (FCommonTickComponent* Dependent : TickDependents)
+	{
+		Dependent->TickPrerequisites.RemoveSingleSwap(this);
+	}
+
+	TickPrerequisites.Empty();
+	TickDependents.Empty();
+
+	FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+	Scheduler.MarkGraphDirty();
 }
 
 bool FCommonTickComponent::IsTickEnabled() const
@@ -70,22 +208,265 @@ float FCommonTickComponent::GetTickIntervalTime() const
 	return InternalTickInterval;
 }
 
-bool FCommonTickComponent::Tick_Implementation(float DeltaSeconds)
+float FCommonTickComponent::GetEffectiveTickIntervalTime() const
 {
-	TickDelegate.Execute(DeltaSeconds);
-	return true;
+	return EffectiveTickInterval;
 }
 
-void FCommonTickComponent::StartTicking()
+float FCommonTickComponent::GetTickRelevance() const
 {
-	ensure(bIsTickEnabled);
-	check(!TickHandle.IsValid());
+	return 1.f;
+}
+
+float FCommonTickComponent::GetTickLoad() const
+{
+	return 0.f;
+}
+
+void FCommonTickComponent::FixedTick_Initialize(const FFixedTickSignature& Callback)
+{
+	FixedTickDelegate = Callback;
+}
 
-	FTickerDelegate Delegate;
-	Delegate.BindRaw(this, &FCommonTickComponent::Tick_Implementation);
+float FCommonTickComponent::GetFixedTickAlpha() const
+{
+	const float Alpha = FixedTickStep > 0.f
+		? FMath::Clamp(static_cast<float>(FixedTickAccumulator / FixedTickStep), 0.f, 1.f)
+		: 0.f;
+
+	return Alpha;
+}
+
+int32 FCommonTickComponent::GetNumDroppedFixedTicks() const
+{
+	return NumDroppedFixedTicks;
+}
 
-	FTSTicker& Ticker = FTSTicker::GetCoreTicker();
-	TickHandle = Ticker.AddTicker(Delegate, InternalTickInterval);
+FCommonFrameArena* FCommonTickComponent::GetFrameArena() const
+{
+	return FrameArena.Get();
+}
+
+void FCommonTickComponent::Timer_Initialize(const FTimersExpiredSignature& Callback)
+{
+	TimersExpiredDelegate = Callback;
+}
+
+FCommonTimerHandle FCommonTickComponent::Timer_Add(float DelaySeconds, uint64 Payload)
+{
+	if (!TimerWheel.IsValid())
+	{
+		TimerWheel = MakeUnique<FCommonTimerWheel>(TimerResolution);
+	}
+
+	const FCommonTimerHandle Handle = TimerWheel->Add(DelaySeconds, Payload);
+	return Handle;
+}
+
+bool FCommonTickComponent::Timer_Remove(FCommonTimerHandle& Handle)
+{
+	const bool bWasRemoved = TimerWheel.IsValid() && TimerWheel->Remove(Handle);
+	Handle.Invalidate();
+	return bWasRemoved;
+}
+
+bool FCommonTickComponent::Timer_IsActive(FCommonTimerHandle Handle) const
+{
+	const bool bIsActive = TimerWheel.IsValid() && TimerWheel->IsActive(Handle);
+	return bIsActive;
+}
+
+float FCommonTickComponent::Timer_GetRemainingTime(FCommonTimerHandle Handle) const
+{
+	const float RemainingTime = TimerWheel.IsValid() ? TimerWheel->GetRemainingSeconds(Handle) : -1.f;
+	return RemainingTime;
+}
+
+FString FCommonTickComponent::GetTickDebugName() const
+{
+	return TEXT("CommonTickComponent");
+}
+
+SIZE_T FCommonTickComponent::Tick_GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = ExpiredTimers.GetAllocatedSize() + TickPrerequisites.GetAllocatedSize() +
+		TickDependents.GetAllocatedSize();
+
+	if (TimerWheel.IsValid())
+	{
+		AllocatedSize += sizeof(FCommonTimerWheel) + TimerWheel->GetAllocatedSize();
+	}
+
+	if (WorldTickFunction.IsValid())
+	{
+		AllocatedSize += sizeof(FCommonWorldTickFunction);
+	}
+
+	if (FrameArena.IsValid())
+	{
+		AllocatedSize += sizeof(FCommonFrameArena) + FrameArena->GetCapacity();
+	}
+
+	return AllocatedSize;
+}
+
+void FCommonTickComponent::InitializeTicking(UWorld* TickWorld)
+{
+	bIsTickEnabled = bStartWithTickEnabled;
+	InternalTickInterval = TickInterval;
+	EffectiveTickInterval = TickInterval;
+	TickShardWorld = TickWorld;
+	TickAliveFlag = MakeShared<bool>(true);
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	TickDebugName = GetTickDebugName();
+	TickCsvStatName = *TickDebugName;
+	TickIntervalCsvStatName = *(TickDebugName + TEXT("_TickInterval"));
+
+#if STATS
+	TickStatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_CommonSubsystems>(TickDebugName);
+#endif
+#endif
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	TickLlmName = *GetTickDebugName();
+#endif
+
+	if (FrameArenaSize > 0)
+	{
+		FrameArena = MakeShared<FCommonFrameArena>(FrameArenaSize);
+	}
+
+	if (TickBackend == ECommonTickBackend::World)
+	{
+		check(IsValid(TickWorld));
+		check(IsValid(TickWorld->PersistentLevel));
+
+		WorldTickFunction = MakeUnique<FCommonWorldTickFunction>(*this);
+		WorldTickFunction->TickGroup = TickGroup;
+		WorldTickFunction->bTickEvenWhenPaused = bTickEvenWhenPaused;
+		WorldTickFunction->TickInterval = InternalTickInterval;
+		WorldTickFunction->RegisterTickFunction(TickWorld->PersistentLevel);
+	}
+
+	if (bIsTickEnabled)
+	{
+		StartTicking();
+	}
+}
+
+void FCommonTickComponent::Tick_Implementation(float DeltaSeconds, FCommonTickBudget& Budget)
+{
+	COMMON_SUBSYSTEMS_LLM_SCOPE("Tick", TickLlmName);
+
+	// The component might be destroyed during its own tick, so keep the arena alive until it's reset
+	const TSharedPtr<FCommonFrameArena> TickFrameArena = FrameArena;
+
+	// Cleared if a callback deinitializes or destroys the component, which mustn't be touched anymore then
+	const TSharedPtr<bool> AliveFlag = TickAliveFlag;
+	check(AliveFlag.IsValid());
+	const FCommonFrameArena::FScope FrameArenaScope(TickFrameArena.Get());
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*TickDebugName);
+#if STATS
+	FScopeCycleCounter CycleCounter(TickStatId);
+#endif
+
+	// The component might be destroyed during its own tick, so keep what's needed afterwards
+	const FName CsvStatName = TickCsvStatName;
+	const float TickIntervalSeconds = EffectiveTickInterval;
+	const FString DebugName = GCommonTickHitchThresholdMs > 0.f ? TickDebugName : FString();
+	const double StartTime = FPlatformTime::Seconds();
+#endif
+
+	if (TimerWheel.IsValid() && TimerWheel->Num() > 0)
+	{
+		ExpiredTimers.Reset();
+		TimerWheel->Advance(DeltaSeconds, ExpiredTimers);
+
+		if (!ExpiredTimers.IsEmpty())
+		{
+			// Owned by the tick during the callback, so that it outlives the component
+			TArray<FCommonExpiredTimer> TickExpiredTimers = MoveTemp(ExpiredTimers);
+			TimersExpiredDelegate.ExecuteIfBound(TickExpiredTimers);
+
+			if (!*AliveFlag)
+			{
+				return;
+			}
+
+			// Hand the allocation back for the next tick
+			ExpiredTimers = MoveTemp(TickExpiredTimers);
+		}
+	}
+
+	if (bTickFixedStep && FixedTickStep > 0.f && FixedTickDelegate.IsBound())
+	{
+		FixedTickAccumulator += DeltaSeconds;
+
+		int32 NumSteps = FMath::FloorToInt32(FixedTickAccumulator / FixedTickStep);
+		if (MaxFixedTickSubsteps > 0 && NumSteps > MaxFixedTickSubsteps)
+		{
+			NumDroppedFixedTicks += NumSteps - MaxFixedTickSubsteps;
+			NumSteps = MaxFixedTickSubsteps;
+
+			// Keep the fraction of the next step only, the rest would never be caught up with
+			FixedTickAccumulator = NumSteps * static_cast<double>(FixedTickStep) +
+				FMath::Fmod(FixedTickAccumulator, static_cast<double>(FixedTickStep));
+		}
+
+		FixedTickAccumulator -= NumSteps * static_cast<double>(FixedTickStep);
+
+		if (NumSteps > 0)
+		{
+			FixedTickDelegate.Execute(FixedTickStep, NumSteps);
+
+			if (!*AliveFlag)
+			{
+				return;
+			}
+		}
+	}
+
+	if (BudgetedTickDelegate.IsBound())
+	{
+		BudgetedTickDelegate.Execute(DeltaSeconds, Budget);
+	}
+	else
+	{
+		TickDelegate.Execute(DeltaSeconds);
+	}
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(CsvStatName, CSV_CATEGORY_INDEX(CommonSubsystems), ElapsedMs,
+		ECsvCustomStatOp::Accumulate);
+#endif
+
+	if (GCommonTickHitchThresholdMs > 0.f && ElapsedMs >= GCommonTickHitchThresholdMs)
+	{
+		UE_LOG(LogCommonSubsystems, Warning, TEXT("Tick of [%s] has taken [%.2f] ms. Delta time [%.4f] s, tick "
+			"interval [%.4f] s."), *DebugName, ElapsedMs, DeltaSeconds, TickIntervalSeconds);
+	}
+#endif
+}
+
+void FCommonTickComponent::StartTicking()
+{
+	if (WorldTickFunction.IsValid())
+	{
+		WorldTickFunction->SetTickFunctionEnable(true);
+	}
+	else
+	{
+		check(ScheduleIndex == INDEX_NONE);
+
+		FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+		Scheduler.Schedule(*this);
+	}
 
 	bIsTickEnabled = true;
 }
@@ -93,10 +474,18 @@ void FCommonTickComponent::StartTicking()
 void FCommonTickComponent::StopTicking()
 {
 	ensure(bIsTickEnabled);
-	check(TickHandle.IsValid());
 
-	FTSTicker& Ticker = FTSTicker::GetCoreTicker();
-	Ticker.RemoveTicker(TickHandle);
+	if (WorldTickFunction.IsValid())
+	{
+		WorldTickFunction->SetTickFunctionEnable(false);
+	}
+	else
+	{
+		check(ScheduleIndex != INDEX_NONE);
+
+		FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+		Scheduler.Unschedule(*this);
+	}
 
 	bIsTickEnabled = false;
 }
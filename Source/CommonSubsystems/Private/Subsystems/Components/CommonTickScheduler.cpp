@@ -0,0 +1,855 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonTickScheduler.h"
+
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "CommonSubsystemsStats.h"
+#include "HAL/IConsoleManager.h"
+#include "LogCategories.h"
+#include "Misc/App.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/PackageName.h"
+#include "Subsystems/Components/CommonEventBus.h"
+#include "Subsystems/Components/CommonTickComponent.h"
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_CommonSubsystems_SchedulerTick, STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Components"), STAT_CommonSubsystems_NumScheduled,
+	STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dispatched Components"), STAT_CommonSubsystems_NumDispatched,
+	STATGROUP_CommonSubsystems);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Frame Pressure"), STAT_CommonSubsystems_FramePressure, STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stretched Components"), STAT_CommonSubsystems_NumStretched,
+	STATGROUP_CommonSubsystems);
+DECLARE_CYCLE_STAT(TEXT("Event Delivery"), STAT_CommonSubsystems_EventDelivery, STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Events"), STAT_CommonSubsystems_NumQueuedEvents, STATGROUP_CommonSubsystems);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Delivered Events"), STAT_CommonSubsystems_NumDeliveredEvents,
+	STATGROUP_CommonSubsystems);
+#endif
+
+static float GCommonTickFrameBudgetMs = 0.f;
+static FAutoConsoleVariableRef CVarCommonTickFrameBudgetMs(
+	TEXT("CommonSubsystems.Tick.FrameBudgetMs"),
+	GCommonTickFrameBudgetMs,
+	TEXT("Time in milliseconds tick components are allowed to spend each frame. Components that tick within the frame ")
+	TEXT("budget are postponed to the next frame once it's used up. 0 means no limit."));
+
+static int32 GCommonTickMaxSkippedFrames = 10;
+static FAutoConsoleVariableRef CVarCommonTickMaxSkippedFrames(
+	TEXT("CommonSubsystems.Tick.MaxSkippedFrames"),
+	GCommonTickMaxSkippedFrames,
+	TEXT("Number of frames in a row a tick can be postponed due to the frame budget before it's forced to tick. ")
+	TEXT("0 means it can be postponed indefinitely."));
+
+static bool GCommonTickAllowParallel = true;
+static FAutoConsoleVariableRef CVarCommonTickAllowParallel(
+	TEXT("CommonSubsystems.Tick.AllowParallel"),
+	GCommonTickAllowParallel,
+	TEXT("If true, thread-safe tick components that don't depend on each other tick in parallel on worker threads."));
+
+static bool GCommonTickShardByWorld = false;
+static FAutoConsoleVariableRef CVarCommonTickShardByWorld(
+	TEXT("CommonSubsystems.Tick.ShardByWorld"),
+	GCommonTickShardByWorld,
+	TEXT("If true, thread-safe tick components are grouped by their world, and each world's group ticks on its own ")
+	TEXT("worker with its own frame budget. Meant for processes that host many worlds, e.g. dedicated servers."));
+
+static float GCommonTickAdaptiveTargetFrameMs = 33.3f;
+static FAutoConsoleVariableRef CVarCommonTickAdaptiveTargetFrameMs(
+	TEXT("CommonSubsystems.Tick.Adaptive.TargetFrameMs"),
+	GCommonTickAdaptiveTargetFrameMs,
+	TEXT("Frame time in milliseconds above which tick components with an adaptive tick interval start ticking less ")
+	TEXT("often. At twice this frame time, they tick at their maximum interval. 0 means frame time is ignored."));
+
+static float GCommonTickAdaptiveSmoothing = 0.1f;
+static FAutoConsoleVariableRef CVarCommonTickAdaptiveSmoothing(
+	TEXT("CommonSubsystems.Tick.Adaptive.Smoothing"),
+	GCommonTickAdaptiveSmoothing,
+	TEXT("Weight of the latest frame in the smoothed frame time the adaptive tick interval follows. Lower values ")
+	TEXT("react slower, but don't flip intervals on single hitches."));
+
+/**
+ * Check whether a component that ticks within the frame budget can still be postponed to the next frame.
+ * @param	Component component to check.
+ * @return	If true, component can be postponed, false otherwise.
+ */
+static bool CanPostponeTick(const FCommonTickComponent& Component)
+{
+	const bool bCanPostpone = GCommonTickMaxSkippedFrames <= 0 || Component.SkippedFrames < GCommonTickMaxSkippedFrames;
+	return bCanPostpone;
+}
+
+FCommonTickScheduler& FCommonTickScheduler::Get()
+{
+	static FCommonTickScheduler Instance;
+	return Instance;
+}
+
+void FCommonTickScheduler::Schedule(FCommonTickComponent& Component)
+{
+	check(IsInGameThread());
+	check(Component.ScheduleIndex == INDEX_NONE);
+
+	const double TickPhase = Component.bAlignTickInterval || Component.EffectiveTickInterval <= 0.f
+		? 1.0
+		: GetNextTickPhase(Component.EffectiveTickInterval);
+
+	Component.LastTickTime = CurrentTime;
+	HeapPush(Component, CurrentTime + Component.EffectiveTickInterval * TickPhase);
+
+	if (const UWorld* ShardWorld = Component.TickShardWorld.Get())
+	{
+		TUniquePtr<FCommonTickShard>& Shard = Shards.FindOrAdd(ShardWorld);
+		if (!Shard.IsValid())
+		{
+			Shard = MakeUnique<FCommonTickShard>();
+			Shard->World = ShardWorld;
+			Shard->WorldName = ShardWorld->GetOutermost()->GetName();
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+			Shard->CsvStatName = *FString::Printf(TEXT("World_%s"), *FPackageName::GetShortName(Shard->WorldName));
+#endif
+		}
+
+		Shard->NumScheduled++;
+		Component.TickShard = Shard.Get();
+
+		if (!WorldCleanupDelegateHandle.IsValid())
+		{
+			WorldCleanupDelegateHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this,
+				&FCommonTickScheduler::OnWorldCleanup);
+		}
+	}
+
+	StartTicking();
+}
+
+void FCommonTickScheduler::Unschedule(FCommonTickComponent& Component)
+{
+	check(IsInGameThread());
+	check(Heap.IsValidIndex(Component.ScheduleIndex));
+
+	HeapRemoveAt(Component.ScheduleIndex);
+
+	// The component might be waiting for its turn in this frame's dispatch
+	if (Component.DispatchIndex != INDEX_NONE)
+	{
+		DueComponents[Component.DispatchIndex] = nullptr;
+		Component.DispatchIndex = INDEX_NONE;
+	}
+
+	// The shard is removed at the end of the tick, since it might be accounting the current frame
+	if (Component.TickShard)
+	{
+		Component.TickShard->NumScheduled--;
+		Component.TickShard = nullptr;
+	}
+
+	// The core ticker entry is removed on its next tick once there's nothing left to tick
+}
+
+void FCommonTickScheduler::Reschedule(FCommonTickComponent& Component)
+{
+	check(IsInGameThread());
+	check(Heap.IsValidIndex(Component.ScheduleIndex));
+
+	const int32 Index = Component.ScheduleIndex;
+	Heap[Index].NextTickTime = Component.LastTickTime + Component.EffectiveTickInterval;
+	HeapUpdate(Index);
+}
+
+void FCommonTickScheduler::DeferToNextFrame(FCommonTickComponent& Component)
+{
+	check(Heap.IsValidIndex(Component.ScheduleIndex));
+
+	// Anything due at the current time will be picked up on the next tick
+	const int32 Index = Component.ScheduleIndex;
+	Heap[Index].NextTickTime = CurrentTime;
+	HeapUpdate(Index);
+}
+
+void FCommonTickScheduler::AddEventBus(FCommonEventBus& EventBus)
+{
+	check(IsInGameThread());
+
+	EventBuses.AddUnique(&EventBus);
+	StartTicking();
+}
+
+void FCommonTickScheduler::RemoveEventBus(FCommonEventBus& EventBus)
+{
+	check(IsInGameThread());
+
+	// Buses might be destroyed by subscribers, so keep the indices of the ones left to deliver
+	if (bIsDeliveringEvents)
+	{
+		const int32 Index = EventBuses.Find(&EventBus);
+		if (Index != INDEX_NONE)
+		{
+			EventBuses[Index] = nullptr;
+		}
+
+		return;
+	}
+
+	// The core ticker entry is removed on its next tick once there's nothing left to tick
+	EventBuses.Remove(&EventBus);
+}
+
+void FCommonTickScheduler::MarkGraphDirty()
+{
+	GraphGeneration++;
+}
+
+int32 FCommonTickScheduler::GetNumScheduled() const
+{
+	return Heap.Num();
+}
+
+int32 FCommonTickScheduler::GetLastNumDispatched() const
+{
+	return LastNumDispatched;
+}
+
+double FCommonTickScheduler::GetLastDispatchSeconds() const
+{
+	return LastDispatchSeconds;
+}
+
+void FCommonTickScheduler::PrintShards(FOutputDevice& Ar) const
+{
+	TArray<const FCommonTickShard*> SortedShards;
+	for (const auto& [World, Shard] : Shards)
+	{
+		SortedShards.Add(Shard.Get());
+	}
+
+	SortedShards.Sort([](const FCommonTickShard& Lhs, const FCommonTickShard& Rhs)
+	{
+		return Lhs.LastFrameMs > Rhs.LastFrameMs;
+	});
+
+	Ar.Logf(TEXT("Tick shards: %d, sharding %s"), SortedShards.Num(),
+		GCommonTickShardByWorld ? TEXT("enabled") : TEXT("disabled"));
+
+	for (const FCommonTickShard* Shard : SortedShards)
+	{
+		const double AverageFrameMs = Shard->NumTickedFrames > 0
+			? Shard->TotalSeconds * 1000.0 / Shard->NumTickedFrames
+			: 0.0;
+
+		Ar.Logf(TEXT("  %s: components %d, last %.3f ms, average %.3f ms, peak %.3f ms, total %.2f s"),
+			*Shard->WorldName, Shard->NumScheduled, Shard->LastFrameMs, AverageFrameMs, Shard->PeakFrameMs,
+			Shard->TotalSeconds);
+	}
+}
+
+void FCommonTickScheduler::StartTicking()
+{
+	if (!TickerHandle.IsValid())
+	{
+		FTickerDelegate Delegate;
+		Delegate.BindRaw(this, &FCommonTickScheduler::Tick);
+
+		FTSTicker& Ticker = FTSTicker::GetCoreTicker();
+		TickerHandle = Ticker.AddTicker(Delegate);
+	}
+}
+
+void FCommonTickScheduler::DeliverEvents()
+{
+	if (EventBuses.IsEmpty())
+	{
+		return;
+	}
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	TRACE_CPUPROFILER_EVENT_SCOPE(FCommonTickScheduler::DeliverEvents);
+	SCOPE_CYCLE_COUNTER(STAT_CommonSubsystems_EventDelivery);
+	CSV_SCOPED_TIMING_STAT(CommonSubsystems, EventDelivery);
+
+	int32 NumQueued = 0;
+	for (const FCommonEventBus* EventBus : EventBuses)
+	{
+		NumQueued += EventBus->GetNumQueued();
+	}
+
+	int32 NumDelivered = 0;
+#endif
+
+	// Subscribers are free to destroy event buses, which are nulled rather than removed until the delivery is over
+	bIsDeliveringEvents = true;
+
+	for (int32 Index = 0; Index < EventBuses.Num(); Index++)
+	{
+		if (FCommonEventBus* EventBus = EventBuses[Index])
+		{
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+			NumDelivered += EventBus->Deliver();
+#else
+			EventBus->Deliver();
+#endif
+		}
+	}
+
+	bIsDeliveringEvents = false;
+	EventBuses.Remove(nullptr);
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	SET_DWORD_STAT(STAT_CommonSubsystems_NumQueuedEvents, NumQueued);
+	SET_DWORD_STAT(STAT_CommonSubsystems_NumDeliveredEvents, NumDelivered);
+	CSV_CUSTOM_STAT(CommonSubsystems, QueuedEvents, NumQueued, ECsvCustomStatOp::Set);
+#endif
+}
+
+bool FCommonTickScheduler::Tick(float DeltaSeconds)
+{
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	TRACE_CPUPROFILER_EVENT_SCOPE(FCommonTickScheduler::Tick);
+	SCOPE_CYCLE_COUNTER(STAT_CommonSubsystems_SchedulerTick);
+	CSV_SCOPED_TIMING_STAT(CommonSubsystems, SchedulerTick);
+#endif
+
+	const double TickStartTime = FPlatformTime::Seconds();
+	CurrentTime += DeltaSeconds;
+
+	UpdateFramePressure(DeltaSeconds);
+
+	DeliverEvents();
+
+	// Pull everything that is due before executing anything, since callbacks are free to change the schedule
+	check(DueComponents.IsEmpty());
+	while (!Heap.IsEmpty() && Heap[0].NextTickTime <= CurrentTime)
+	{
+		FCommonTickComponent* Component = Heap[0].Component;
+		HeapRemoveAt(0);
+
+		DueComponents.Add(Component);
+	}
+
+	// Put them back with their next tick time first, so that a component that stops ticking during the dispatch
+	// doesn't have to be treated differently from the rest
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	int32 NumStretched = 0;
+#endif
+
+	for (FCommonTickComponent* Component : DueComponents)
+	{
+		if (Component->bAdaptiveTickInterval)
+		{
+			UpdateAdaptiveTickInterval(*Component);
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+			NumStretched += Component->EffectiveTickInterval > Component->InternalTickInterval ? 1 : 0;
+#endif
+		}
+
+		HeapPush(*Component, CurrentTime + Component->EffectiveTickInterval);
+		UpdateTickLevel(*Component);
+	}
+
+	// Prerequisites first; then higher priority first; then the ones that have been waiting for longer first
+	Algo::Sort(DueComponents, [](const FCommonTickComponent* Lhs, const FCommonTickComponent* Rhs)
+	{
+		if (Lhs->TickLevel != Rhs->TickLevel)
+		{
+			return Lhs->TickLevel < Rhs->TickLevel;
+		}
+
+		if (Lhs->TickPriority != Rhs->TickPriority)
+		{
+			return Lhs->TickPriority > Rhs->TickPriority;
+		}
+
+		return Lhs->LastTickTime < Rhs->LastTickTime;
+	});
+
+	// Components might be unscheduled during the dispatch, so find the waves beforehand
+	WaveEndIndices.Reset();
+	for (int32 DueIndex = 0; DueIndex < DueComponents.Num(); DueIndex++)
+	{
+		DueComponents[DueIndex]->DispatchIndex = DueIndex;
+
+		const bool bIsLast = DueIndex == DueComponents.Num() - 1;
+		if (bIsLast || DueComponents[DueIndex]->TickLevel != DueComponents[DueIndex + 1]->TickLevel)
+		{
+			WaveEndIndices.Add(DueIndex + 1);
+		}
+	}
+
+	if (GCommonTickShardByWorld)
+	{
+		DispatchShards();
+	}
+
+	const double DispatchStartTime = FPlatformTime::Seconds();
+	const double FrameEndTime = GCommonTickFrameBudgetMs > 0.f
+		? DispatchStartTime + GCommonTickFrameBudgetMs / 1000.0
+		: TNumericLimits<double>::Max();
+
+	int32 WaveBeginIndex = 0;
+	for (const int32 WaveEndIndex : WaveEndIndices)
+	{
+		DispatchWaveInParallel(WaveBeginIndex, WaveEndIndex);
+		DispatchWaveOnGameThread(WaveBeginIndex, WaveEndIndex, FrameEndTime);
+		WaveBeginIndex = WaveEndIndex;
+	}
+
+	LastNumDispatched = DueComponents.Num();
+	LastDispatchSeconds = FPlatformTime::Seconds() - TickStartTime;
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	SET_DWORD_STAT(STAT_CommonSubsystems_NumScheduled, Heap.Num());
+	SET_DWORD_STAT(STAT_CommonSubsystems_NumDispatched, LastNumDispatched);
+	SET_DWORD_STAT(STAT_CommonSubsystems_NumStretched, NumStretched);
+	SET_FLOAT_STAT(STAT_CommonSubsystems_FramePressure, FramePressure);
+	CSV_CUSTOM_STAT(CommonSubsystems, FramePressure, FramePressure, ECsvCustomStatOp::Set);
+#endif
+
+	DueComponents.Reset();
+
+	UpdateShards();
+
+	if (Heap.IsEmpty() && EventBuses.IsEmpty())
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+double FCommonTickScheduler::GetNextTickPhase(float TickInterval)
+{
+	// Fractional parts of the multiples of the golden ratio conjugate never repeat, and each new one lands in one of
+	// the largest gaps left by the previous ones
+	constexpr double GoldenRatioConjugate = 0.6180339887498949;
+
+	const int32 TickIntervalMs = FMath::RoundToInt(TickInterval * 1000.f);
+	uint32& NumStarted = NumStartedPerTickInterval.FindOrAdd(TickIntervalMs);
+	NumStarted++;
+
+	const double Phase = 1.0 - FMath::Frac(NumStarted * GoldenRatioConjugate);
+	return Phase;
+}
+
+void FCommonTickScheduler::UpdateFramePressure(float DeltaSeconds)
+{
+	const float FrameMs = DeltaSeconds * 1000.f;
+	SmoothedFrameMs = SmoothedFrameMs > 0.f
+		? FMath::Lerp(SmoothedFrameMs, FrameMs, FMath::Clamp(GCommonTickAdaptiveSmoothing, 0.f, 1.f))
+		: FrameMs;
+
+	if (GCommonTickAdaptiveTargetFrameMs > 0.f)
+	{
+		const float OverBudgetMs = SmoothedFrameMs - GCommonTickAdaptiveTargetFrameMs;
+		FramePressure = FMath::Clamp(OverBudgetMs / GCommonTickAdaptiveTargetFrameMs, 0.f, 1.f);
+	}
+	else
+	{
+		FramePressure = 0.f;
+	}
+}
+
+void FCommonTickScheduler::UpdateAdaptiveTickInterval(FCommonTickComponent& Component) const
+{
+	const float Load = FMath::Clamp(Component.GetTickLoad(), 0.f, 1.f);
+	const float Pressure = FMath::Max(FramePressure, Load);
+	const float Relevance = FMath::Clamp(Component.GetTickRelevance(), 0.f, 1.f);
+
+	// Irrelevant components stretch all the way, fully relevant ones only as far as the pressure pushes them
+	const float Stretch = 1.f - Relevance * (1.f - Pressure);
+
+	const float MinTickInterval = Component.InternalTickInterval;
+	const float MaxTickInterval = FMath::Max(Component.MaxTickInterval, MinTickInterval);
+	Component.EffectiveTickInterval = FMath::Lerp(MinTickInterval, MaxTickInterval, Stretch);
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION && CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(Component.TickIntervalCsvStatName, CSV_CATEGORY_INDEX(CommonSubsystems),
+		Component.EffectiveTickInterval * 1000.0, ECsvCustomStatOp::Set);
+#endif
+}
+
+void FCommonTickScheduler::DispatchWaveInParallel(int32 BeginIndex, int32 EndIndex)
+{
+	ParallelDueIndices.Reset();
+	for (int32 DueIndex = BeginIndex; DueIndex < EndIndex; DueIndex++)
+	{
+		const FCommonTickComponent* Component = DueComponents[DueIndex];
+		if (Component && Component->bIsTickThreadSafe)
+		{
+			ParallelDueIndices.Add(DueIndex);
+		}
+	}
+
+	if (ParallelDueIndices.IsEmpty())
+	{
+		return;
+	}
+
+	const bool bRunInParallel = GCommonTickAllowParallel && ParallelDueIndices.Num() > 1 &&
+		FApp::ShouldUseThreadingForPerformance();
+
+	ParallelFor(ParallelDueIndices.Num(), [this](int32 Index)
+	{
+		FCommonTickComponent& Component = *DueComponents[ParallelDueIndices[Index]];
+		Component.bHasTickYielded = DispatchComponent(Component, TNumericLimits<double>::Max());
+	}, bRunInParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	// Back on the game thread, the schedule can be touched again
+	for (const int32 DueIndex : ParallelDueIndices)
+	{
+		FCommonTickComponent& Component = *DueComponents[DueIndex];
+		DueComponents[DueIndex] = nullptr;
+		Component.DispatchIndex = INDEX_NONE;
+
+		if (Component.bHasTickYielded)
+		{
+			DeferToNextFrame(Component);
+		}
+	}
+}
+
+void FCommonTickScheduler::DispatchShards()
+{
+	ActiveShards.Reset();
+	for (int32 DueIndex = 0; DueIndex < DueComponents.Num(); DueIndex++)
+	{
+		const FCommonTickComponent* Component = DueComponents[DueIndex];
+		if (!Component->bCanTickInShard)
+		{
+			continue;
+		}
+
+		FCommonTickShard& Shard = *Component->TickShard;
+		if (Shard.DueIndices.IsEmpty())
+		{
+			ActiveShards.Add(&Shard);
+		}
+
+		Shard.DueIndices.Add(DueIndex);
+	}
+
+	if (ActiveShards.IsEmpty())
+	{
+		return;
+	}
+
+	const bool bRunInParallel = GCommonTickAllowParallel && ActiveShards.Num() > 1 &&
+		FApp::ShouldUseThreadingForPerformance();
+
+	ParallelFor(ActiveShards.Num(), [this](int32 Index)
+	{
+		DispatchShard(*ActiveShards[Index]);
+	}, bRunInParallel ? EParallelForFlags::Unbalanced : EParallelForFlags::ForceSingleThread);
+
+	// Every shard has completed its frame, so the schedule can be touched again
+	for (FCommonTickShard* Shard : ActiveShards)
+	{
+		for (const int32 DueIndex : Shard->DueIndices)
+		{
+			FCommonTickComponent& Component = *DueComponents[DueIndex];
+			DueComponents[DueIndex] = nullptr;
+			Component.DispatchIndex = INDEX_NONE;
+
+			if (Component.bHasTickYielded)
+			{
+				DeferToNextFrame(Component);
+			}
+		}
+
+		Shard->DueIndices.Reset();
+	}
+}
+
+void FCommonTickScheduler::DispatchShard(FCommonTickShard& Shard)
+{
+	const double FrameEndTime = GCommonTickFrameBudgetMs > 0.f
+		? FPlatformTime::Seconds() + GCommonTickFrameBudgetMs / 1000.0
+		: TNumericLimits<double>::Max();
+
+	for (const int32 DueIndex : Shard.DueIndices)
+	{
+		FCommonTickComponent& Component = *DueComponents[DueIndex];
+
+		double EndTime = TNumericLimits<double>::Max();
+		if (Component.bTickWithinFrameBudget)
+		{
+			if (FPlatformTime::Seconds() >= FrameEndTime && CanPostponeTick(Component))
+			{
+				// Deferred once back on the game thread
+				Component.SkippedFrames++;
+				Component.bHasTickYielded = true;
+				continue;
+			}
+
+			EndTime = FrameEndTime;
+		}
+
+		Component.bHasTickYielded = DispatchComponent(Component, EndTime);
+	}
+}
+
+void FCommonTickScheduler::UpdateShards()
+{
+	for (auto It = Shards.CreateIterator(); It; ++It)
+	{
+		FCommonTickShard& Shard = *It->Value;
+
+		const uint64 FrameCycles = Shard.FrameCycles.exchange(0, std::memory_order_relaxed);
+		Shard.LastFrameMs = FPlatformTime::ToMilliseconds64(FrameCycles);
+
+		if (FrameCycles > 0)
+		{
+			Shard.PeakFrameMs = FMath::Max(Shard.PeakFrameMs, Shard.LastFrameMs);
+			Shard.TotalSeconds += Shard.LastFrameMs / 1000.0;
+			Shard.NumTickedFrames++;
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION && CSV_PROFILER
+			FCsvProfiler::RecordCustomStat(Shard.CsvStatName, CSV_CATEGORY_INDEX(CommonSubsystems), Shard.LastFrameMs,
+				ECsvCustomStatOp::Set);
+#endif
+		}
+
+		if (Shard.NumScheduled == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	CleanedUpShards.Reset();
+}
+
+void FCommonTickScheduler::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	check(IsInGameThread());
+
+	TUniquePtr<FCommonTickShard>* Shard = Shards.Find(World);
+	if (!Shard)
+	{
+		return;
+	}
+
+	// Components still scheduled tick on the game thread from now on
+	for (const FEntry& Entry : Heap)
+	{
+		FCommonTickComponent& Component = *Entry.Component;
+		if (Component.TickShard == Shard->Get())
+		{
+			Component.TickShard = nullptr;
+			Component.TickShardWorld.Reset();
+		}
+	}
+
+	// Frame accounting might be in progress if the world is cleaned up during a tick
+	CleanedUpShards.Add(MoveTemp(*Shard));
+	Shards.Remove(World);
+
+	MarkGraphDirty();
+}
+
+void FCommonTickScheduler::DispatchWaveOnGameThread(int32 BeginIndex, int32 EndIndex, double FrameEndTime)
+{
+	for (int32 DueIndex = BeginIndex; DueIndex < EndIndex; DueIndex++)
+	{
+		FCommonTickComponent* Component = DueComponents[DueIndex];
+		if (!Component)
+		{
+			// Either ticked in parallel, or stopped ticking by one of the previous callbacks
+			continue;
+		}
+
+		double EndTime = TNumericLimits<double>::Max();
+		if (Component->bTickWithinFrameBudget)
+		{
+			if (FPlatformTime::Seconds() >= FrameEndTime && CanPostponeTick(*Component))
+			{
+				// Keep the last tick time as is, so that the time keeps accumulating until the component gets its turn
+				Component->SkippedFrames++;
+				Component->DispatchIndex = INDEX_NONE;
+				DeferToNextFrame(*Component);
+				continue;
+			}
+
+			EndTime = FrameEndTime;
+		}
+
+		const bool bHasYielded = DispatchComponent(*Component, EndTime);
+
+		// The component might've stopped ticking, or even be destroyed, during its own tick
+		if (!DueComponents[DueIndex])
+		{
+			continue;
+		}
+
+		Component->DispatchIndex = INDEX_NONE;
+
+		if (bHasYielded)
+		{
+			DeferToNextFrame(*Component);
+		}
+	}
+}
+
+bool FCommonTickScheduler::DispatchComponent(FCommonTickComponent& Component, double EndTime)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	if (Component.MaxTickTimeMs > 0.f)
+	{
+		EndTime = FMath::Min(EndTime, StartTime + Component.MaxTickTimeMs / 1000.0);
+	}
+
+	Component.SkippedFrames = 0;
+
+	const float TickDeltaSeconds = static_cast<float>(CurrentTime - Component.LastTickTime);
+	Component.LastTickTime = CurrentTime;
+
+	// Shards outlive the frame, even if the component is destroyed during its own tick
+	FCommonTickShard* Shard = Component.TickShard;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	FCommonTickBudget Budget(StartTime, EndTime);
+	Component.Tick_Implementation(TickDeltaSeconds, Budget);
+
+	// Don't touch the component from here on, it might've been destroyed during its own tick
+	if (Shard)
+	{
+		Shard->FrameCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+	}
+
+	const bool bHasYielded = Budget.HasYielded();
+	return bHasYielded;
+}
+
+void FCommonTickScheduler::UpdateTickLevel(FCommonTickComponent& Component)
+{
+	if (Component.TickLevelGeneration == GraphGeneration)
+	{
+		return;
+	}
+
+	// Mark as being visited, to detect cycles
+	Component.TickLevelGeneration = GraphGeneration;
+	Component.TickLevel = INDEX_NONE;
+	Component.bCanTickInShard = false;
+
+	int32 TickLevel = 0;
+	bool bCanTickInShard = Component.bIsTickThreadSafe && Component.TickShard;
+	for (FCommonTickComponent* Prerequisite : Component.TickPrerequisites)
+	{
+		UpdateTickLevel(*Prerequisite);
+		if (Prerequisite->TickLevel == INDEX_NONE)
+		{
+			UE_LOG(LogCommonSubsystems, Warning,
+				TEXT("Tick dependency cycle detected. The dependency will be ignored."));
+			continue;
+		}
+
+		TickLevel = FMath::Max(TickLevel, Prerequisite->TickLevel + 1);
+
+		// Shards tick concurrently, and ahead of the game thread, so prerequisites have to tick on the same shard
+		if (!Prerequisite->bCanTickInShard || Prerequisite->TickShardWorld != Component.TickShardWorld)
+		{
+			bCanTickInShard = false;
+		}
+	}
+
+	Component.TickLevel = TickLevel;
+	Component.bCanTickInShard = bCanTickInShard;
+}
+
+void FCommonTickScheduler::HeapPush(FCommonTickComponent& Component, double NextTickTime)
+{
+	const int32 Index = Heap.Add({ NextTickTime, &Component });
+	Component.ScheduleIndex = Index;
+
+	HeapSiftUp(Index);
+}
+
+void FCommonTickScheduler::HeapRemoveAt(int32 Index)
+{
+	FCommonTickComponent* Component = Heap[Index].Component;
+
+	const int32 LastIndex = Heap.Num() - 1;
+	if (Index != LastIndex)
+	{
+		HeapSwap(Index, LastIndex);
+	}
+
+	Heap.Pop(/*bAllowShrinking*/ false);
+	Component->ScheduleIndex = INDEX_NONE;
+
+	if (Index != LastIndex)
+	{
+		HeapUpdate(Index);
+	}
+}
+
+void FCommonTickScheduler::HeapUpdate(int32 Index)
+{
+	if (HeapSiftUp(Index) == Index)
+	{
+		HeapSiftDown(Index);
+	}
+}
+
+int32 FCommonTickScheduler::HeapSiftUp(int32 Index)
+{
+	while (Index > 0)
+	{
+		const int32 ParentIndex = (Index - 1) / 2;
+		if (Heap[ParentIndex].NextTickTime <= Heap[Index].NextTickTime)
+		{
+			break;
+		}
+
+		HeapSwap(Index, ParentIndex);
+		Index = ParentIndex;
+	}
+
+	return Index;
+}
+
+int32 FCommonTickScheduler::HeapSiftDown(int32 Index)
+{
+	const int32 Num = Heap.Num();
+	while (true)
+	{
+		const int32 LeftIndex = Index * 2 + 1;
+		if (LeftIndex >= Num)
+		{
+			break;
+		}
+
+		const int32 RightIndex = LeftIndex + 1;
+		const int32 MinChildIndex = RightIndex < Num && Heap[RightIndex].NextTickTime < Heap[LeftIndex].NextTickTime
+			? RightIndex : LeftIndex;
+
+		if (Heap[Index].NextTickTime <= Heap[MinChildIndex].NextTickTime)
+		{
+			break;
+		}
+
+		HeapSwap(Index, MinChildIndex);
+		Index = MinChildIndex;
+	}
+
+	return Index;
+}
+
+void FCommonTickScheduler::HeapSwap(int32 A, int32 B)
+{
+	Swap(Heap[A], Heap[B]);
+	Heap[A].Component->ScheduleIndex = A;
+	Heap[B].Component->ScheduleIndex = B;
+}
+
+static void PrintTickShards(const TArray<FString>& Args, FOutputDevice& Ar)
+{
+	FCommonTickScheduler::Get().PrintShards(Ar);
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice PrintTickShardsCommand(
+	TEXT("CommonSubsystems.Tick.Shards"),
+	TEXT("Print time each world's tick components spend ticking, sorted by the last frame."),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateStatic(&PrintTickShards));
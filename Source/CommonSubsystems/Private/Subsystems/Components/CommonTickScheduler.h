@@ -0,0 +1,350 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Containers/Ticker.h"
+
+#include <atomic>
+
+class FCommonEventBus;
+struct FCommonTickComponent;
+
+/**
+ * Tick components of a single world. Keeps the world's CPU accounting, and, when sharding is enabled, the world's
+ * thread-safe components that tick together on a worker.
+ */
+struct FCommonTickShard
+{
+	/** World the shard belongs to. The shard is removed once the world is cleaned up, so it's alive as long as set. */
+	const UWorld* World = nullptr;
+
+	/** Name of the world's package. Cached for reports. */
+	FString WorldName;
+
+	/** Number of scheduled components of the world. The shard is removed once there are none left. */
+	int32 NumScheduled = 0;
+
+	/** Indices of the due components that tick on the shard this frame, in dispatch order. */
+	TArray<int32> DueIndices;
+
+	/** CPU cycles the world's components have spent ticking this frame. Added to from any thread. */
+	std::atomic<uint64> FrameCycles = 0;
+
+	/** Time the world's components have spent ticking on the last frame in milliseconds. */
+	double LastFrameMs = 0.0;
+
+	/** Longest frame so far in milliseconds. */
+	double PeakFrameMs = 0.0;
+
+	/** Time the world's components have spent ticking in total in seconds. */
+	double TotalSeconds = 0.0;
+
+	/** Number of frames the world's components have ticked on. */
+	int32 NumTickedFrames = 0;
+
+#if COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+	/** Name used by CSV stats. */
+	FName CsvStatName;
+#endif
+};
+
+/**
+ * Scheduler shared by every tick component.
+ *
+ * It owns a single core ticker entry, and keeps all the ticking components in a flat binary min-heap ordered by the
+ * time they're due next, so components that don't have to tick in the current frame aren't touched at all.
+ *
+ * Due components are dispatched in waves following their tick prerequisites. Within a wave, thread-safe components
+ * tick in parallel on worker threads, and then the rest ticks on the game thread by priority. Components that opt in
+ * to the frame budget are postponed to the next frame once the budget is used up.
+ *
+ * Before the dispatch, events posted to the event buses are delivered, so that ticks see them in the same frame.
+ *
+ * Components are grouped by the world they tick for, and their CPU time is accounted per world. With
+ * CommonSubsystems.Tick.ShardByWorld, each world's thread-safe components tick on their own worker, with their own
+ * frame budget, so a busy world doesn't hold back the waves of the others. All the shards complete before the rest of
+ * the components tick.
+ *
+ * Components with an adaptive tick interval are rescheduled further apart as the smoothed frame time goes over its
+ * target, as the load they report grows, and as their relevance drops.
+ *
+ * Components that share a tick interval are started at different phases of it, so that their ticks are spread across
+ * frames rather than all landing in the same one.
+ */
+class FCommonTickScheduler
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	friend struct FCommonTickSchedulerTestAccess;
+#endif
+
+public:
+	/**
+	 * Get the scheduler instance.
+	 * @return	Scheduler instance.
+	 */
+	static FCommonTickScheduler& Get();
+
+	/**
+	 * Start ticking a component. It will tick for the first time within its tick interval, at a phase that sets it
+	 * apart from the other components of the same interval, or once the interval elapses if it's aligned.
+	 * @param	Component component to schedule.
+	 */
+	void Schedule(FCommonTickComponent& Component);
+
+	/**
+	 * Stop ticking a component.
+	 * @param	Component component to unschedule.
+	 */
+	void Unschedule(FCommonTickComponent& Component);
+
+	/**
+	 * Move a scheduled component to its right place after its tick interval has changed.
+	 * @param	Component component to reschedule.
+	 */
+	void Reschedule(FCommonTickComponent& Component);
+
+	/**
+	 * Start delivering the events of an event bus each tick, before the components are dispatched.
+	 * @param	EventBus event bus to deliver.
+	 */
+	void AddEventBus(FCommonEventBus& EventBus);
+
+	/**
+	 * Stop delivering the events of an event bus.
+	 * @param	EventBus event bus to stop delivering.
+	 */
+	void RemoveEventBus(FCommonEventBus& EventBus);
+
+	/**
+	 * Notify that tick prerequisites have changed, so that the tick waves have to be rebuilt.
+	 */
+	void MarkGraphDirty();
+
+	/**
+	 * Get number of scheduled components.
+	 * @return	Number of components that are ticking.
+	 */
+	int32 GetNumScheduled() const;
+
+	/**
+	 * Get number of components that have been due on the last tick.
+	 * @return	Number of due components.
+	 */
+	int32 GetLastNumDispatched() const;
+
+	/**
+	 * Get time the last tick has taken in seconds, including the scheduling overhead.
+	 * @return	Time the last tick has taken.
+	 */
+	double GetLastDispatchSeconds() const;
+
+	/**
+	 * Print time each world's components spend ticking.
+	 * @param	Ar output device to print to.
+	 */
+	void PrintShards(FOutputDevice& Ar) const;
+
+private:
+	/**
+	 * Add the core ticker entry, unless it's already there.
+	 */
+	void StartTicking();
+
+	/**
+	 * Deliver the events posted to the event buses.
+	 */
+	void DeliverEvents();
+
+	/**
+	 * Core ticker callback. Ticks all the components that are due.
+	 * @param	DeltaSeconds time since last core ticker tick.
+	 * @return	If true, scheduler has to keep ticking, false otherwise.
+	 */
+	bool Tick(float DeltaSeconds);
+
+	/**
+	 * Make a scheduled component due on the next frame.
+	 * @param	Component component to defer.
+	 */
+	void DeferToNextFrame(FCommonTickComponent& Component);
+
+	/**
+	 * Get phase the next component of a given tick interval starts at. Consecutive phases of the same interval are
+	 * spread evenly, however many components there are.
+	 * @param	TickInterval tick interval of the component.
+	 * @return	Phase in the (0, 1] range.
+	 */
+	double GetNextTickPhase(float TickInterval);
+
+	/**
+	 * Update the frame time pressure the adaptive tick intervals follow.
+	 * @param	DeltaSeconds time since last core ticker tick.
+	 */
+	void UpdateFramePressure(float DeltaSeconds);
+
+	/**
+	 * Stretch the tick interval of a component with an adaptive tick interval according to the current pressure, and
+	 * to its load and relevance.
+	 * @param	Component component to update.
+	 */
+	void UpdateAdaptiveTickInterval(FCommonTickComponent& Component) const;
+
+	/**
+	 * Tick thread-safe components of a wave in parallel. Waits for all of them to finish.
+	 * @param	BeginIndex index of the first due component of the wave.
+	 * @param	EndIndex index past the last due component of the wave.
+	 */
+	void DispatchWaveInParallel(int32 BeginIndex, int32 EndIndex);
+
+	/**
+	 * Tick the due components that can tick on their world's shard, each shard on its own worker. Waits for all of
+	 * them to finish.
+	 */
+	void DispatchShards();
+
+	/**
+	 * Tick the due components of a shard in dispatch order, within the shard's own frame budget.
+	 * @param	Shard shard to tick.
+	 */
+	void DispatchShard(FCommonTickShard& Shard);
+
+	/**
+	 * Wrap up the per-world CPU accounting of the frame, and remove the shards that have no components left.
+	 */
+	void UpdateShards();
+
+	/**
+	 * Called when a world is cleaned up. Removes the world's shard, so that it's never mistaken for the shard of
+	 * another world allocated at the same address later on.
+	 * @param	World world that is being cleaned up.
+	 * @param	bSessionEnded whether to notify the viewport that the game session has ended.
+	 * @param	bCleanupResources whether to clean up the resources.
+	 */
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+	/**
+	 * Tick the rest of the components of a wave on the game thread.
+	 * @param	BeginIndex index of the first due component of the wave.
+	 * @param	EndIndex index past the last due component of the wave.
+	 * @param	FrameEndTime platform time the frame budget is used up at.
+	 */
+	void DispatchWaveOnGameThread(int32 BeginIndex, int32 EndIndex, double FrameEndTime);
+
+	/**
+	 * Tick a single component.
+	 * @param	Component component to tick.
+	 * @param	EndTime platform time the tick budget is used up at.
+	 * @return	If true, the component has asked to be resumed on the next frame, false otherwise.
+	 */
+	bool DispatchComponent(FCommonTickComponent& Component, double EndTime);
+
+	/**
+	 * Compute the depth of a component in the tick dependency graph, unless it's already up to date.
+	 * @param	Component component to compute the depth for.
+	 */
+	void UpdateTickLevel(FCommonTickComponent& Component);
+
+	/**
+	 * Add an entry to the heap.
+	 * @param	Component component to add.
+	 * @param	NextTickTime time the component is due.
+	 */
+	void HeapPush(FCommonTickComponent& Component, double NextTickTime);
+
+	/**
+	 * Remove an entry from the heap.
+	 * @param	Index heap index of the entry to remove.
+	 */
+	void HeapRemoveAt(int32 Index);
+
+	/**
+	 * Restore heap order for an entry whose time has changed.
+	 * @param	Index heap index of the entry to move.
+	 */
+	void HeapUpdate(int32 Index);
+
+	/**
+	 * Move an entry towards the root until the heap order is restored.
+	 * @param	Index heap index of the entry to move.
+	 * @return	Final heap index of the entry.
+	 */
+	int32 HeapSiftUp(int32 Index);
+
+	/**
+	 * Move an entry towards the leaves until the heap order is restored.
+	 * @param	Index heap index of the entry to move.
+	 * @return	Final heap index of the entry.
+	 */
+	int32 HeapSiftDown(int32 Index);
+
+	/**
+	 * Swap two heap entries, keeping the components' heap indices up to date.
+	 * @param	A first heap index.
+	 * @param	B second heap index.
+	 */
+	void HeapSwap(int32 A, int32 B);
+
+private:
+	struct FEntry
+	{
+		/** Scheduler time the component is due. */
+		double NextTickTime = 0.0;
+
+		/** Scheduled component. */
+		FCommonTickComponent* Component = nullptr;
+	};
+
+	/** Scheduled components, ordered as a binary min-heap by their next tick time. */
+	TArray<FEntry> Heap;
+
+	/** Components that are being dispatched this frame. Entries are nulled when unscheduled mid-dispatch. */
+	TArray<FCommonTickComponent*> DueComponents;
+
+	/** Indices past the last due component of each wave. */
+	TArray<int32> WaveEndIndices;
+
+	/** Indices of due components of the current wave that tick in parallel. */
+	TArray<int32> ParallelDueIndices;
+
+	/** Shards of the worlds that have scheduled components. */
+	TMap<const UWorld*, TUniquePtr<FCommonTickShard>> Shards;
+
+	/** Shards that have due components this frame. */
+	TArray<FCommonTickShard*> ActiveShards;
+
+	/** Shards of the worlds cleaned up this frame. Kept until the end of the tick, as they may be accounting it. */
+	TArray<TUniquePtr<FCommonTickShard>> CleanedUpShards;
+
+	/** Delegate associated with FCommonTickScheduler::OnWorldCleanup(). */
+	FDelegateHandle WorldCleanupDelegateHandle;
+
+	/** Number of components started so far, per tick interval in milliseconds. Used to spread their phases. */
+	TMap<int32, uint32> NumStartedPerTickInterval;
+
+	/** Event buses to deliver each tick. Entries are nulled when removed mid-delivery. */
+	TArray<FCommonEventBus*> EventBuses;
+
+	/** If true, events are being delivered, false otherwise. */
+	bool bIsDeliveringEvents = false;
+
+	/** Incremented each time tick prerequisites change. */
+	uint32 GraphGeneration = 1;
+
+	/** Delegate handle for the core ticker entry. */
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	/** Time accumulated by the scheduler. */
+	double CurrentTime = 0.0;
+
+	/** Frame time in milliseconds, smoothed over the last frames. */
+	float SmoothedFrameMs = 0.f;
+
+	/** How far over its target the smoothed frame time is, between 0 and 1. */
+	float FramePressure = 0.f;
+
+	/** Number of components that have been due on the last tick. */
+	int32 LastNumDispatched = 0;
+
+	/** Time the last tick has taken in seconds. */
+	double LastDispatchSeconds = 0.0;
+};
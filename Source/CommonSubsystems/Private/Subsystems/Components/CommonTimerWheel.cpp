@@ -0,0 +1,314 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonTimerWheel.h"
+
+#include "Algo/Sort.h"
+
+bool FCommonTimerHandle::IsValid() const
+{
+	return Index != MAX_uint32;
+}
+
+void FCommonTimerHandle::Invalidate()
+{
+	Index = MAX_uint32;
+	Serial = 0;
+}
+
+bool FCommonTimerHandle::operator==(const FCommonTimerHandle& Other) const
+{
+	return Index == Other.Index && Serial == Other.Serial;
+}
+
+bool FCommonTimerHandle::operator!=(const FCommonTimerHandle& Other) const
+{
+	return !(*this == Other);
+}
+
+FCommonTimerWheel::FCommonTimerWheel(float InResolution)
+	: Resolution(FMath::Max(InResolution, UE_KINDA_SMALL_NUMBER))
+{
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(SlotHeads); Slot++)
+	{
+		SlotHeads[Slot] = INDEX_NONE;
+		SlotTails[Slot] = INDEX_NONE;
+	}
+}
+
+FCommonTimerHandle FCommonTimerWheel::Add(float DelaySeconds, uint64 Payload)
+{
+	int32 NodeIndex = FreeHead;
+	if (NodeIndex != INDEX_NONE)
+	{
+		FreeHead = Nodes[NodeIndex].Next;
+	}
+	else
+	{
+		NodeIndex = Nodes.AddDefaulted();
+	}
+
+	// Count from the current time rather than from the last wheel tick
+	const int64 DelayTicks = FMath::CeilToInt64((FMath::Max(DelaySeconds, 0.f) + Accumulator) / Resolution);
+
+	FNode& Node = Nodes[NodeIndex];
+	Node.ExpiryTick = CurrentTick + FMath::Max<int64>(DelayTicks, 1);
+	Node.Payload = Payload;
+	Node.Sequence = NextSequence++;
+	LinkNode(NodeIndex);
+
+	NumActive++;
+
+	FCommonTimerHandle Handle;
+	Handle.Index = static_cast<uint32>(NodeIndex);
+	Handle.Serial = Node.Serial;
+	return Handle;
+}
+
+bool FCommonTimerWheel::Remove(FCommonTimerHandle Handle)
+{
+	const int32 NodeIndex = FindNode(Handle);
+	if (NodeIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	UnlinkNode(NodeIndex);
+	FreeNode(NodeIndex);
+	return true;
+}
+
+bool FCommonTimerWheel::IsActive(FCommonTimerHandle Handle) const
+{
+	return FindNode(Handle) != INDEX_NONE;
+}
+
+float FCommonTimerWheel::GetRemainingSeconds(FCommonTimerHandle Handle) const
+{
+	const int32 NodeIndex = FindNode(Handle);
+	if (NodeIndex == INDEX_NONE)
+	{
+		return -1.f;
+	}
+
+	const int64 RemainingTicks = Nodes[NodeIndex].ExpiryTick - CurrentTick;
+	const float RemainingSeconds = FMath::Max(static_cast<float>(RemainingTicks) * Resolution - Accumulator, 0.f);
+	return RemainingSeconds;
+}
+
+int32 FCommonTimerWheel::Num() const
+{
+	return NumActive;
+}
+
+SIZE_T FCommonTimerWheel::GetAllocatedSize() const
+{
+	return Nodes.GetAllocatedSize();
+}
+
+void FCommonTimerWheel::Advance(float DeltaSeconds, TArray<FCommonExpiredTimer>& OutExpiredTimers)
+{
+	Accumulator += FMath::Max(DeltaSeconds, 0.f);
+	if (Accumulator < Resolution)
+	{
+		return;
+	}
+
+	const int64 NumTicks = FMath::FloorToInt64(Accumulator / Resolution);
+	Accumulator = FMath::Max(Accumulator - static_cast<float>(NumTicks) * Resolution, 0.f);
+
+	// Nothing to cascade or expire
+	if (NumActive == 0)
+	{
+		CurrentTick += NumTicks;
+		return;
+	}
+
+	for (int64 TickIndex = 0; TickIndex < NumTicks; TickIndex++)
+	{
+		CurrentTick++;
+
+		// Once a level wraps around, timers of the next level's current slot are due within its range
+		for (int32 Level = 1; Level < NumLevels; Level++)
+		{
+			const int64 LevelMask = (static_cast<int64>(1) << (SlotBits * Level)) - 1;
+			if ((CurrentTick & LevelMask) != 0)
+			{
+				break;
+			}
+
+			Cascade(Level);
+		}
+
+		const int32 Slot = static_cast<int32>(CurrentTick & (SlotsPerLevel - 1));
+		int32 NodeIndex = SlotHeads[Slot];
+		SlotHeads[Slot] = INDEX_NONE;
+		SlotTails[Slot] = INDEX_NONE;
+
+		const int32 FirstExpiredIndex = OutExpiredTimers.Num();
+		uint64 LastSequence = 0;
+		bool bIsInOrder = true;
+
+		while (NodeIndex != INDEX_NONE)
+		{
+			FNode& Node = Nodes[NodeIndex];
+			const int32 NextIndex = Node.Next;
+			checkSlow(Node.ExpiryTick == CurrentTick);
+
+			FCommonExpiredTimer& ExpiredTimer = OutExpiredTimers.AddDefaulted_GetRef();
+			ExpiredTimer.Handle.Index = static_cast<uint32>(NodeIndex);
+			ExpiredTimer.Handle.Serial = Node.Serial;
+			ExpiredTimer.Payload = Node.Payload;
+
+			bIsInOrder &= Node.Sequence >= LastSequence;
+			LastSequence = Node.Sequence;
+
+			FreeNode(NodeIndex);
+			NodeIndex = NextIndex;
+		}
+
+		// Slots are filled in order, but timers cascaded from a higher level land after the ones added directly
+		if (!bIsInOrder)
+		{
+			TArrayView<FCommonExpiredTimer> TickExpiredTimers = MakeArrayView(OutExpiredTimers)
+				.Slice(FirstExpiredIndex, OutExpiredTimers.Num() - FirstExpiredIndex);
+
+			// Freed nodes keep their sequence until they're reused
+			Algo::Sort(TickExpiredTimers, [this](const FCommonExpiredTimer& Lhs, const FCommonExpiredTimer& Rhs)
+			{
+				const uint64 LhsSequence = Nodes[static_cast<int32>(Lhs.Handle.Index)].Sequence;
+				const uint64 RhsSequence = Nodes[static_cast<int32>(Rhs.Handle.Index)].Sequence;
+				return LhsSequence < RhsSequence;
+			});
+		}
+
+		if (NumActive == 0)
+		{
+			CurrentTick += NumTicks - TickIndex - 1;
+			break;
+		}
+	}
+}
+
+void FCommonTimerWheel::Reset()
+{
+	for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		if (Nodes[NodeIndex].Slot != INDEX_NONE)
+		{
+			FreeNode(NodeIndex);
+		}
+	}
+
+	for (int32 Slot = 0; Slot < UE_ARRAY_COUNT(SlotHeads); Slot++)
+	{
+		SlotHeads[Slot] = INDEX_NONE;
+		SlotTails[Slot] = INDEX_NONE;
+	}
+}
+
+void FCommonTimerWheel::LinkNode(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+
+	// Timers beyond the range of the last level are parked in its furthest slot until they come closer
+	constexpr int64 MaxDeltaTicks = (static_cast<int64>(1) << (SlotBits * NumLevels)) - 1;
+	const int64 DeltaTicks = FMath::Min(Node.ExpiryTick - CurrentTick, MaxDeltaTicks);
+	const int64 SlotTick = CurrentTick + DeltaTicks;
+
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && DeltaTicks >= (static_cast<int64>(1) << (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+
+	const int32 SlotInLevel = static_cast<int32>((SlotTick >> (SlotBits * Level)) & (SlotsPerLevel - 1));
+	const int32 Slot = Level * SlotsPerLevel + SlotInLevel;
+
+	// Appended, so that timers of the same tick expire in the order they've been added
+	Node.Slot = Slot;
+	Node.Prev = SlotTails[Slot];
+	Node.Next = INDEX_NONE;
+
+	if (Node.Prev != INDEX_NONE)
+	{
+		Nodes[Node.Prev].Next = NodeIndex;
+	}
+	else
+	{
+		SlotHeads[Slot] = NodeIndex;
+	}
+
+	SlotTails[Slot] = NodeIndex;
+}
+
+void FCommonTimerWheel::UnlinkNode(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+
+	if (Node.Prev != INDEX_NONE)
+	{
+		Nodes[Node.Prev].Next = Node.Next;
+	}
+	else
+	{
+		SlotHeads[Node.Slot] = Node.Next;
+	}
+
+	if (Node.Next != INDEX_NONE)
+	{
+		Nodes[Node.Next].Prev = Node.Prev;
+	}
+	else
+	{
+		SlotTails[Node.Slot] = Node.Prev;
+	}
+
+	Node.Prev = INDEX_NONE;
+	Node.Next = INDEX_NONE;
+}
+
+void FCommonTimerWheel::FreeNode(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+	Node.Slot = INDEX_NONE;
+	Node.Prev = INDEX_NONE;
+	Node.Next = FreeHead;
+	Node.Serial++;
+
+	FreeHead = NodeIndex;
+	NumActive--;
+}
+
+void FCommonTimerWheel::Cascade(int32 Level)
+{
+	const int32 SlotInLevel = static_cast<int32>((CurrentTick >> (SlotBits * Level)) & (SlotsPerLevel - 1));
+	const int32 Slot = Level * SlotsPerLevel + SlotInLevel;
+
+	int32 NodeIndex = SlotHeads[Slot];
+	SlotHeads[Slot] = INDEX_NONE;
+	SlotTails[Slot] = INDEX_NONE;
+
+	while (NodeIndex != INDEX_NONE)
+	{
+		const int32 NextIndex = Nodes[NodeIndex].Next;
+		LinkNode(NodeIndex);
+		NodeIndex = NextIndex;
+	}
+}
+
+int32 FCommonTimerWheel::FindNode(FCommonTimerHandle Handle) const
+{
+	if (!Handle.IsValid() || !Nodes.IsValidIndex(static_cast<int32>(Handle.Index)))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 NodeIndex = static_cast<int32>(Handle.Index);
+	const FNode& Node = Nodes[NodeIndex];
+	if (Node.Serial != Handle.Serial || Node.Slot == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	return NodeIndex;
+}
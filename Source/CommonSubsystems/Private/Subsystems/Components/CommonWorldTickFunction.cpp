@@ -0,0 +1,36 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Subsystems/Components/CommonWorldTickFunction.h"
+
+#include "Subsystems/Components/CommonTickComponent.h"
+
+FCommonWorldTickFunction::FCommonWorldTickFunction(FCommonTickComponent& InComponent)
+	: Component(InComponent)
+{
+	bCanEverTick = true;
+	bStartWithTickEnabled = false;
+	bAllowTickOnDedicatedServer = true;
+}
+
+void FCommonWorldTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+	const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (TickType == LEVELTICK_ViewportsOnly)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = Component.MaxTickTimeMs > 0.f
+		? StartTime + Component.MaxTickTimeMs / 1000.0
+		: TNumericLimits<double>::Max();
+
+	FCommonTickBudget Budget(StartTime, EndTime);
+	Component.Tick_Implementation(DeltaTime, Budget);
+}
+
+FString FCommonWorldTickFunction::DiagnosticMessage()
+{
+	const FString Message = FString::Printf(TEXT("FCommonWorldTickFunction[%s]"), *Component.GetTickDebugName());
+	return Message;
+}
@@ -0,0 +1,196 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Subsystems/Components/CommonRegistryComponent.h"
+#include "UObject/GarbageCollection.h"
+#include "UObject/Package.h"
+
+namespace CommonRegistryComponentTests
+{
+	using FTestRegistry = TCommonRegistryComponent<UObject, int32>;
+
+	/**
+	 * Create an object to register.
+	 * @param	Name name of the object.
+	 * @return	New object.
+	 */
+	UObject* CreateObject(const FString& Name)
+	{
+		UPackage* Object = CreatePackage(*FString::Printf(TEXT("/Temp/CommonRegistryComponentTests_%s"), *Name));
+		return Object;
+	}
+
+	/**
+	 * Check that the dense storage holds the given objects and values, in the given order.
+	 * @param	Test test to report to.
+	 * @param	Registry registry to check.
+	 * @param	Objects expected objects in dense order.
+	 * @param	Values expected values in dense order.
+	 */
+	void TestDenseOrder(FAutomationTestBase& Test, FTestRegistry& Registry, const TArray<UObject*>& Objects,
+		const TArray<int32>& Values)
+	{
+		if (!Test.TestEqual(TEXT("Entries"), Registry.Num(), Objects.Num()))
+		{
+			return;
+		}
+
+		const TArrayView<int32> Column = Registry.GetColumn<0>();
+		for (int32 DenseIndex = 0; DenseIndex < Objects.Num(); DenseIndex++)
+		{
+			Test.TestTrue(TEXT("Object in dense order"), Registry.GetObject(DenseIndex) == Objects[DenseIndex]);
+			Test.TestEqual(TEXT("Value in dense order"), Column[DenseIndex], Values[DenseIndex]);
+
+			const FCommonRegistryHandle Handle = Registry.FindHandle(*Objects[DenseIndex]);
+			Test.TestEqual(TEXT("Dense index of the object's handle"), Registry.GetDenseIndex(Handle), DenseIndex);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonRegistryStaleHandleTest, "CommonSubsystems.RegistryComponent.StaleHandle",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonRegistryStaleHandleTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonRegistryComponentTests;
+
+	FTestRegistry Registry;
+
+	UObject* Object = CreateObject(TEXT("StaleHandle"));
+	UObject* OtherObject = CreateObject(TEXT("StaleHandleOther"));
+
+	const FCommonRegistryHandle Handle = Registry.Register(*Object, 1);
+	TestTrue(TEXT("Registered"), Registry.IsRegistered(Handle));
+	TestTrue(TEXT("Registering again finds the entry"), Registry.Register(*Object, 2) == Handle);
+	TestEqual(TEXT("Registering again overwrites the data"), *Registry.Find<0>(Handle), 2);
+
+	TestTrue(TEXT("Unregistered"), Registry.Unregister(Handle));
+	TestFalse(TEXT("Unregistered twice"), Registry.Unregister(Handle));
+	TestFalse(TEXT("Stale handle is registered"), Registry.IsRegistered(Handle));
+	TestEqual(TEXT("Dense index of the stale handle"), Registry.GetDenseIndex(Handle), INDEX_NONE);
+	TestNull(TEXT("Data of the stale handle"), Registry.Find<0>(Handle));
+	TestFalse(TEXT("Handle of the unregistered object"), Registry.FindHandle(*Object).IsValid());
+
+	// The freed slot is reused, only with the next generation
+	const FCommonRegistryHandle OtherHandle = Registry.Register(*OtherObject, 3);
+	TestTrue(TEXT("Handle of the slot's new entry"), OtherHandle != Handle);
+	TestFalse(TEXT("Stale handle is registered once its slot is reused"), Registry.IsRegistered(Handle));
+	TestNull(TEXT("Data of the stale handle once its slot is reused"), Registry.Find<0>(Handle));
+	TestFalse(TEXT("Stale handle unregisters the slot's new entry"), Registry.Unregister(Handle));
+	TestTrue(TEXT("Slot's new entry is registered"), Registry.IsRegistered(OtherHandle));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonRegistrySwapRemoveTest, "CommonSubsystems.RegistryComponent.SwapRemove",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonRegistrySwapRemoveTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonRegistryComponentTests;
+
+	FTestRegistry Registry;
+
+	TArray<UObject*> Objects;
+	TArray<FCommonRegistryHandle> Handles;
+	for (int32 Index = 0; Index < 4; Index++)
+	{
+		UObject* Object = CreateObject(FString::Printf(TEXT("SwapRemove%d"), Index));
+		Objects.Add(Object);
+		Handles.Add(Registry.Register(*Object, Index));
+	}
+
+	TestDenseOrder(*this, Registry, Objects, { 0, 1, 2, 3 });
+
+	// The last entry takes the removed entry's place
+	Registry.Unregister(Handles[1]);
+	TestDenseOrder(*this, Registry, { Objects[0], Objects[3], Objects[2] }, { 0, 3, 2 });
+	TestEqual(TEXT("Data of the moved entry"), *Registry.Find<0>(Handles[3]), 3);
+
+	// Removing the last entry moves nothing
+	Registry.Unregister(*Objects[2]);
+	TestDenseOrder(*this, Registry, { Objects[0], Objects[3] }, { 0, 3 });
+
+	Registry.Unregister(Handles[0]);
+	TestDenseOrder(*this, Registry, { Objects[3] }, { 3 });
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonRegistryDeletionTest, "CommonSubsystems.RegistryComponent.Deletion",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonRegistryDeletionTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonRegistryComponentTests;
+
+	FTestRegistry Registry;
+
+	UObject* DeletedObject = CreateObject(TEXT("DeletionDeleted"));
+	UObject* KeptObject = CreateObject(TEXT("DeletionKept"));
+	KeptObject->AddToRoot();
+
+	const FCommonRegistryHandle DeletedHandle = Registry.Register(*DeletedObject, 1);
+	const FCommonRegistryHandle KeptHandle = Registry.Register(*KeptObject, 2);
+
+	DeletedObject->MarkAsGarbage();
+	DeletedObject = nullptr;
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	// The entry stays until the next flush, but its object isn't handed out
+	TestEqual(TEXT("Entries before the flush"), Registry.Num(), 2);
+	TestNull(TEXT("Deleted object before the flush"), Registry.GetObject(0));
+	TestTrue(TEXT("Kept object before the flush"), Registry.GetObject(1) == KeptObject);
+
+	Registry.Flush();
+
+	TestEqual(TEXT("Entries after the flush"), Registry.Num(), 1);
+	TestFalse(TEXT("Deleted object's handle is registered"), Registry.IsRegistered(DeletedHandle));
+	TestTrue(TEXT("Kept object's handle is registered"), Registry.IsRegistered(KeptHandle));
+	TestTrue(TEXT("Kept object is moved into the deleted one's place"), Registry.GetObject(0) == KeptObject);
+	TestEqual(TEXT("Kept object's data"), *Registry.Find<0>(KeptHandle), 2);
+
+	KeptObject->RemoveFromRoot();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonRegistryResetTest, "CommonSubsystems.RegistryComponent.Reset",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonRegistryResetTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonRegistryComponentTests;
+
+	FTestRegistry Registry;
+
+	UObject* Object = CreateObject(TEXT("Reset"));
+	UObject* OtherObject = CreateObject(TEXT("ResetOther"));
+
+	const FCommonRegistryHandle Handle = Registry.Register(*Object, 1);
+	const FCommonRegistryHandle OtherHandle = Registry.Register(*OtherObject, 2);
+
+	Registry.Reset();
+
+	TestEqual(TEXT("Entries after the reset"), Registry.Num(), 0);
+	TestFalse(TEXT("Handle is registered after the reset"), Registry.IsRegistered(Handle));
+	TestFalse(TEXT("Object's handle after the reset"), Registry.FindHandle(*Object).IsValid());
+
+	// Slots are reused, but the outstanding handles don't refer to the new entries
+	const FCommonRegistryHandle NewHandle = Registry.Register(*Object, 3);
+	const FCommonRegistryHandle NewOtherHandle = Registry.Register(*OtherObject, 4);
+
+	TestTrue(TEXT("New handle differs from the old one"), NewHandle != Handle && NewHandle != OtherHandle);
+	TestTrue(TEXT("New handles differ from the old ones"), NewOtherHandle != Handle && NewOtherHandle != OtherHandle);
+	TestFalse(TEXT("Old handle is registered"), Registry.IsRegistered(Handle));
+	TestFalse(TEXT("Other old handle is registered"), Registry.IsRegistered(OtherHandle));
+	TestNull(TEXT("Data of the old handle"), Registry.Find<0>(Handle));
+	TestEqual(TEXT("Data of the new handle"), *Registry.Find<0>(NewHandle), 3);
+
+	return true;
+}
+
+#endif
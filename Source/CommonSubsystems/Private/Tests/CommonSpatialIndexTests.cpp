@@ -0,0 +1,254 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Math/RandomStream.h"
+#include "Subsystems/Components/CommonSpatialIndexComponent.h"
+
+namespace CommonSpatialIndexTests
+{
+	/** Edge length of the test grids' cells. */
+	constexpr double CellSize = 100.0;
+
+	/**
+	 * Fill a spatial index with entries spread over a few cells, leaving most of the cells in between empty.
+	 * @param	SpatialIndex index to fill.
+	 * @param	OutLocations output parameter. Locations of the entries, by ID.
+	 */
+	void FillIndex(FCommonSpatialIndexComponent& SpatialIndex, TMap<uint64, FVector>& OutLocations)
+	{
+		FRandomStream RandomStream(1337);
+
+		// Clusters of entries, across negative coordinates too
+		const TArray<FVector> ClusterCenters =
+		{
+			FVector(0.0, 0.0, 0.0),
+			FVector(-730.0, 420.0, 15.0),
+			FVector(1250.0, -1180.0, -300.0),
+			FVector(2400.0, 2400.0, 0.0),
+		};
+
+		uint64 Id = 0;
+		for (const FVector& ClusterCenter : ClusterCenters)
+		{
+			for (int32 Index = 0; Index < 64; Index++)
+			{
+				const FVector Offset = RandomStream.GetUnitVector() * (RandomStream.FRand() * 250.0);
+				const FVector Location = ClusterCenter + Offset;
+
+				SpatialIndex.Update(Id, Location);
+				OutLocations.Add(Id, Location);
+				Id++;
+			}
+		}
+
+		SpatialIndex.Commit();
+	}
+
+	/**
+	 * Get the locations to run the queries from: inside clusters, in between them, and outside the populated bounds.
+	 * @return	Query locations.
+	 */
+	TArray<FVector> GetQueryCenters()
+	{
+		const TArray<FVector> QueryCenters =
+		{
+			FVector(0.0, 0.0, 0.0),
+			FVector(49.9, -50.1, 99.9),
+			FVector(-730.0, 420.0, 15.0),
+			FVector(300.0, -400.0, 0.0),
+			FVector(1800.0, 600.0, -150.0),
+			FVector(-5000.0, 0.0, 0.0),
+			FVector(10000.0, 10000.0, 10000.0),
+			FVector(-1.0e7, 1.0e7, -1.0e7),
+		};
+
+		return QueryCenters;
+	}
+
+	/**
+	 * Sort IDs, so that sets found in no particular order can be compared.
+	 * @param	Ids IDs to sort.
+	 * @return	Sorted IDs.
+	 */
+	TArray<uint64> Sorted(TArray<uint64> Ids)
+	{
+		Ids.Sort();
+		return Ids;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSpatialIndexEmptyTest, "CommonSubsystems.SpatialIndex.Empty",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSpatialIndexEmptyTest::RunTest(const FString& Parameters)
+{
+	FCommonSpatialIndexComponent SpatialIndex(CommonSpatialIndexTests::CellSize);
+	TestFalse(TEXT("Commit without changes"), SpatialIndex.Commit());
+
+	TArray<uint64> Ids;
+	const FCommonSpatialIndexComponent::FSnapshotRef Snapshot = SpatialIndex.GetSnapshot();
+	Snapshot->QueryRadius(FVector::ZeroVector, 1000.0, Ids);
+	Snapshot->QueryBox(FBox(FVector(-1000.0), FVector(1000.0)), Ids);
+	Snapshot->QueryNearest(FVector::ZeroVector, 8, Ids);
+	TestEqual(TEXT("Entries found in an empty index"), Ids.Num(), 0);
+
+	// Removed entries aren't found by the next snapshot, but stay in the previous one
+	SpatialIndex.Update(1, FVector::ZeroVector);
+	SpatialIndex.Commit();
+	const FCommonSpatialIndexComponent::FSnapshotRef OldSnapshot = SpatialIndex.GetSnapshot();
+
+	SpatialIndex.Remove(1);
+	TestTrue(TEXT("Commit after a removal"), SpatialIndex.Commit());
+	SpatialIndex.GetSnapshot()->QueryNearest(FVector::ZeroVector, 8, Ids);
+	TestEqual(TEXT("Entries found after the removal"), Ids.Num(), 0);
+
+	OldSnapshot->QueryNearest(FVector::ZeroVector, 8, Ids);
+	TestEqual(TEXT("Entries found in the previous snapshot"), Ids.Num(), 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSpatialIndexRadiusTest, "CommonSubsystems.SpatialIndex.Radius",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSpatialIndexRadiusTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonSpatialIndexTests;
+
+	FCommonSpatialIndexComponent SpatialIndex(CellSize);
+	TMap<uint64, FVector> Locations;
+	FillIndex(SpatialIndex, Locations);
+
+	const FCommonSpatialIndexComponent::FSnapshotRef Snapshot = SpatialIndex.GetSnapshot();
+	TestEqual(TEXT("Entries"), Snapshot->Num(), Locations.Num());
+
+	const TArray<double> Radii = { 0.0, 30.0, 100.0, 275.0, 1000.0, 1.0e5 };
+	for (const FVector& Center : GetQueryCenters())
+	{
+		for (const double Radius : Radii)
+		{
+			TArray<uint64> ExpectedIds;
+			for (const TPair<uint64, FVector>& Pair : Locations)
+			{
+				if (FVector::DistSquared(Pair.Value, Center) <= FMath::Square(Radius))
+				{
+					ExpectedIds.Add(Pair.Key);
+				}
+			}
+
+			TArray<uint64> Ids;
+			Snapshot->QueryRadius(Center, Radius, Ids);
+
+			const FString What = FString::Printf(TEXT("Entries within %.1f of %s"), Radius, *Center.ToString());
+			TestTrue(*What, Sorted(Ids) == Sorted(ExpectedIds));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSpatialIndexBoxTest, "CommonSubsystems.SpatialIndex.Box",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSpatialIndexBoxTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonSpatialIndexTests;
+
+	FCommonSpatialIndexComponent SpatialIndex(CellSize);
+	TMap<uint64, FVector> Locations;
+	FillIndex(SpatialIndex, Locations);
+
+	const FCommonSpatialIndexComponent::FSnapshotRef Snapshot = SpatialIndex.GetSnapshot();
+
+	const TArray<FVector> Extents = { FVector(0.0), FVector(50.0, 120.0, 10.0), FVector(400.0), FVector(1.0e5) };
+	for (const FVector& Center : GetQueryCenters())
+	{
+		for (const FVector& Extent : Extents)
+		{
+			const FBox Box = FBox::BuildAABB(Center, Extent);
+
+			TArray<uint64> ExpectedIds;
+			for (const TPair<uint64, FVector>& Pair : Locations)
+			{
+				if (Box.IsInsideOrOn(Pair.Value))
+				{
+					ExpectedIds.Add(Pair.Key);
+				}
+			}
+
+			TArray<uint64> Ids;
+			Snapshot->QueryBox(Box, Ids);
+
+			const FString What = FString::Printf(TEXT("Entries within %s"), *Box.ToString());
+			TestTrue(*What, Sorted(Ids) == Sorted(ExpectedIds));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSpatialIndexNearestTest, "CommonSubsystems.SpatialIndex.Nearest",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSpatialIndexNearestTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonSpatialIndexTests;
+
+	FCommonSpatialIndexComponent SpatialIndex(CellSize);
+	TMap<uint64, FVector> Locations;
+	FillIndex(SpatialIndex, Locations);
+
+	const FCommonSpatialIndexComponent::FSnapshotRef Snapshot = SpatialIndex.GetSnapshot();
+
+	const TArray<int32> Counts = { 1, 5, 64, 1000 };
+	const TArray<double> MaxRadii = { 0.0, 150.0, 900.0, UE_BIG_NUMBER };
+	for (const FVector& Center : GetQueryCenters())
+	{
+		// Squared distances of all the entries, nearest first
+		TArray<double> AllDistancesSquared;
+		for (const TPair<uint64, FVector>& Pair : Locations)
+		{
+			AllDistancesSquared.Add(FVector::DistSquared(Pair.Value, Center));
+		}
+
+		AllDistancesSquared.Sort();
+
+		for (const int32 Count : Counts)
+		{
+			for (const double MaxRadius : MaxRadii)
+			{
+				TArray<double> ExpectedDistancesSquared;
+				for (const double DistanceSquared : AllDistancesSquared)
+				{
+					if (ExpectedDistancesSquared.Num() < Count && DistanceSquared <= FMath::Square(MaxRadius))
+					{
+						ExpectedDistancesSquared.Add(DistanceSquared);
+					}
+				}
+
+				TArray<uint64> Ids;
+				Snapshot->QueryNearest(Center, Count, Ids, MaxRadius);
+
+				// Equally distant entries may come in any order, so only the distances are compared
+				const FString What = FString::Printf(TEXT("%d nearest entries within %.1f of %s"), Count, MaxRadius,
+					*Center.ToString());
+
+				if (TestEqual(*What, Ids.Num(), ExpectedDistancesSquared.Num()))
+				{
+					for (int32 Index = 0; Index < Ids.Num(); Index++)
+					{
+						const double DistanceSquared = FVector::DistSquared(Locations[Ids[Index]], Center);
+						TestEqual(*What, DistanceSquared, ExpectedDistancesSquared[Index]);
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonSubsystemHandle.h"
+#include "Subsystems/CommonWorldSubsystem.h"
+#include "Subsystems/CommonWorldSubsystemManager.h"
+#include "UObject/Package.h"
+
+namespace CommonSubsystemCacheTests
+{
+	/**
+	 * Create an object to own test subsystems.
+	 * @param	Name name of the owner.
+	 * @return	New owner.
+	 */
+	UObject* CreateOwner(const TCHAR* Name)
+	{
+		UPackage* Owner = CreatePackage(*FString::Printf(TEXT("/Temp/CommonSubsystemCacheTests_%s"), Name));
+		return Owner;
+	}
+
+	/**
+	 * Create a subsystem, and register it in the cache. It's never initialized.
+	 * @param	Owner object that owns the subsystem.
+	 * @return	Registered subsystem.
+	 */
+	UCommonWorldSubsystemManager* CreateRegisteredSubsystem(UObject* Owner)
+	{
+		auto* Subsystem = NewObject<UCommonWorldSubsystemManager>(Owner, NAME_None, RF_Transient);
+
+		FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+		Cache.Register(*Subsystem, UWorldSubsystem::StaticClass());
+
+		return Subsystem;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSubsystemCacheLookupTest, "CommonSubsystems.SubsystemCache.Lookup",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSubsystemCacheLookupTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonSubsystemCacheTests;
+
+	FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+
+	UObject* Owner = CreateOwner(TEXT("Lookup"));
+	UObject* OtherOwner = CreateOwner(TEXT("LookupOther"));
+	UCommonWorldSubsystemManager* Subsystem = CreateRegisteredSubsystem(Owner);
+
+	const int32 Slot = Cache.GetClassSlot(UCommonWorldSubsystemManager::StaticClass());
+	const int32 OtherSlot = Cache.GetClassSlot(UCommonWorldSubsystem::StaticClass());
+
+	TestTrue(TEXT("Hit"), Cache.Find(Owner, Slot) == Subsystem);
+	TestTrue(TEXT("Typed hit"), Cache.Find<UCommonWorldSubsystemManager>(Owner) == Subsystem);
+	TestNull(TEXT("Miss on another owner"), Cache.Find(OtherOwner, Slot));
+	TestNull(TEXT("Miss on another class"), Cache.Find(Owner, OtherSlot));
+	TestTrue(TEXT("Open lifetime"), Cache.FindLifetime(*Subsystem).IsValid());
+
+	Cache.Unregister(*Subsystem);
+
+	TestNull(TEXT("Invalidated on unregister"), Cache.Find(Owner, Slot));
+	TestFalse(TEXT("Closed lifetime"), Cache.FindLifetime(*Subsystem).IsValid());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonSubsystemHandleReuseTest, "CommonSubsystems.SubsystemHandle.Reuse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonSubsystemHandleReuseTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonSubsystemCacheTests;
+
+	FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+
+	UCommonWorldSubsystemManager* Subsystem = CreateRegisteredSubsystem(CreateOwner(TEXT("Reuse")));
+	const TCommonSubsystemHandle<UCommonWorldSubsystemManager> Handle(Subsystem);
+	TestTrue(TEXT("Handle resolves"), Handle.GetPtr() == Subsystem);
+
+	Cache.Unregister(*Subsystem);
+	TestFalse(TEXT("Handle invalidated on unregister"), Handle.IsValid());
+
+	// The released table is the first to be reused, only with the next generation
+	UCommonWorldSubsystemManager* NewSubsystem = CreateRegisteredSubsystem(CreateOwner(TEXT("ReuseNew")));
+	const TCommonSubsystemHandle<UCommonWorldSubsystemManager> NewHandle(NewSubsystem);
+
+	TestFalse(TEXT("Stale handle stays invalid once its table is reused"), Handle.IsValid());
+	TestTrue(TEXT("New handle resolves"), NewHandle.GetPtr() == NewSubsystem);
+
+	Cache.Unregister(*NewSubsystem);
+	TestFalse(TEXT("New handle invalidated on unregister"), NewHandle.IsValid());
+
+	return true;
+}
+
+#endif
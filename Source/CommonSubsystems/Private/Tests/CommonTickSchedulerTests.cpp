@@ -0,0 +1,174 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HAL/IConsoleManager.h"
+#include "Subsystems/Components/CommonTickComponent.h"
+#include "Subsystems/Components/CommonTickScheduler.h"
+
+/**
+ * Ticks the scheduler directly, so that the tests don't depend on the core ticker.
+ */
+struct FCommonTickSchedulerTestAccess
+{
+	/**
+	 * Tick the scheduler. Has to be called with at least one component scheduled, so that the scheduler keeps its core
+	 * ticker entry.
+	 * @param	DeltaSeconds time to advance by.
+	 */
+	static void Tick(float DeltaSeconds)
+	{
+		FCommonTickScheduler& Scheduler = FCommonTickScheduler::Get();
+		check(Scheduler.GetNumScheduled() > 0);
+
+		Scheduler.Tick(DeltaSeconds);
+	}
+};
+
+namespace CommonTickSchedulerTests
+{
+	/**
+	 * Tick component logging its ticks.
+	 */
+	struct FTestTickComponent
+		: public FCommonTickComponent
+	{
+	public:
+		using FCommonTickComponent::AddTickPrerequisite;
+
+	public:
+		FTestTickComponent(const TCHAR* InName, TArray<FString>& InTickLog)
+			: Name(InName)
+			, TickLog(InTickLog)
+		{
+		}
+
+		/**
+		 * Start ticking every frame.
+		 * @param	Priority tick priority.
+		 * @param	bWithinFrameBudget if true, the tick can be postponed by the frame budget, false otherwise.
+		 */
+		void Start(int32 Priority, bool bWithinFrameBudget = false)
+		{
+			bStartWithTickEnabled = true;
+			TickPriority = Priority;
+			bTickWithinFrameBudget = bWithinFrameBudget;
+
+			Tick_Initialize(FTickSignature::CreateRaw(this, &FTestTickComponent::OnTick));
+		}
+
+		void OnTick(float DeltaSeconds)
+		{
+			TickLog.Add(Name);
+			LastDeltaSeconds = DeltaSeconds;
+
+			const double EndTime = FPlatformTime::Seconds() + SpinSeconds;
+			while (FPlatformTime::Seconds() < EndTime)
+			{
+				// Empty
+			}
+
+			SpinSeconds = 0.0;
+		}
+
+		virtual FString GetTickDebugName() const override
+		{
+			return Name;
+		}
+
+	public:
+		/** Name logged on tick. */
+		FString Name;
+
+		/** Ticks of all the test components, in order. */
+		TArray<FString>& TickLog;
+
+		/** Time to spend on the next tick in seconds. */
+		double SpinSeconds = 0.0;
+
+		/** Time received on the last tick in seconds. */
+		float LastDeltaSeconds = 0.f;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTickSchedulerOrderTest, "CommonSubsystems.TickScheduler.Order",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTickSchedulerOrderTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonTickSchedulerTests;
+
+	TArray<FString> TickLog;
+	FTestTickComponent Low(TEXT("Low"), TickLog);
+	FTestTickComponent High(TEXT("High"), TickLog);
+	FTestTickComponent AfterLow(TEXT("AfterLow"), TickLog);
+	FTestTickComponent AfterAfterLow(TEXT("AfterAfterLow"), TickLog);
+
+	// Prerequisites win over priorities
+	AfterLow.AddTickPrerequisite(Low);
+	AfterAfterLow.AddTickPrerequisite(AfterLow);
+
+	AfterAfterLow.Start(1000);
+	AfterLow.Start(100);
+	Low.Start(0);
+	High.Start(10);
+
+	FCommonTickSchedulerTestAccess::Tick(0.1f);
+
+	const TArray<FString> ExpectedTickLog = { TEXT("High"), TEXT("Low"), TEXT("AfterLow"), TEXT("AfterAfterLow") };
+	TestEqual(TEXT("Tick order"), TickLog, ExpectedTickLog);
+
+	TickLog.Reset();
+	FCommonTickSchedulerTestAccess::Tick(0.1f);
+	TestEqual(TEXT("Tick order on the next frame"), TickLog, ExpectedTickLog);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTickSchedulerBudgetTest, "CommonSubsystems.TickScheduler.Budget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTickSchedulerBudgetTest::RunTest(const FString& Parameters)
+{
+	using namespace CommonTickSchedulerTests;
+
+	IConsoleVariable* FrameBudgetMs = IConsoleManager::Get().FindConsoleVariable(
+		TEXT("CommonSubsystems.Tick.FrameBudgetMs"));
+	if (!TestNotNull(TEXT("Frame budget console variable"), FrameBudgetMs))
+	{
+		return false;
+	}
+
+	const FString PreviousFrameBudgetMs = FrameBudgetMs->GetString();
+
+	TArray<FString> TickLog;
+	FTestTickComponent Hog(TEXT("Hog"), TickLog);
+	FTestTickComponent Deferred(TEXT("Deferred"), TickLog);
+
+	Hog.Start(10);
+	Deferred.Start(0, true);
+
+	// The hog uses up the whole budget, so the other one has to wait
+	FrameBudgetMs->Set(TEXT("1"), ECVF_SetByCode);
+	Hog.SpinSeconds = 0.005;
+
+	FCommonTickSchedulerTestAccess::Tick(0.1f);
+	TestEqual(TEXT("Ticks over the budget"), TickLog, TArray<FString>({ TEXT("Hog") }));
+
+	FrameBudgetMs->Set(TEXT("0"), ECVF_SetByCode);
+
+	TickLog.Reset();
+	FCommonTickSchedulerTestAccess::Tick(0.1f);
+	TestEqual(TEXT("Ticks within the budget"), TickLog, TArray<FString>({ TEXT("Hog"), TEXT("Deferred") }));
+
+	// Postponed ticks receive all the time since their last tick
+	TestEqual(TEXT("Postponed tick delta time"), Deferred.LastDeltaSeconds, 0.2f, UE_KINDA_SMALL_NUMBER);
+
+	FrameBudgetMs->Set(*PreviousFrameBudgetMs, ECVF_SetByCode);
+
+	return true;
+}
+
+#endif
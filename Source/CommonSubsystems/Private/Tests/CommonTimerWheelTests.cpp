@@ -0,0 +1,171 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Subsystems/Components/CommonTimerWheel.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTimerWheelCascadeTest, "CommonSubsystems.TimerWheel.Cascade",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTimerWheelCascadeTest::RunTest(const FString& Parameters)
+{
+	// One second per wheel tick, so that the delays are exact
+	FCommonTimerWheel TimerWheel(1.f);
+
+	// Across the first level's boundary, and up to the third level
+	const TArray<int32> DelayTicks = { 1, 63, 64, 65, 100, 4095, 4096, 4103 };
+	for (const int32 Delay : DelayTicks)
+	{
+		TimerWheel.Add(static_cast<float>(Delay), Delay);
+	}
+
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+	for (int32 Tick = 1; Tick <= DelayTicks.Last(); Tick++)
+	{
+		ExpiredTimers.Reset();
+		TimerWheel.Advance(1.f, ExpiredTimers);
+
+		for (const FCommonExpiredTimer& ExpiredTimer : ExpiredTimers)
+		{
+			const FString What = FString::Printf(TEXT("Expiry tick of the timer of %llu ticks"), ExpiredTimer.Payload);
+			TestEqual(*What, static_cast<uint64>(Tick), ExpiredTimer.Payload);
+		}
+	}
+
+	TestEqual(TEXT("Active timers"), TimerWheel.Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTimerWheelSameTickOrderTest, "CommonSubsystems.TimerWheel.SameTickOrder",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTimerWheelSameTickOrderTest::RunTest(const FString& Parameters)
+{
+	FCommonTimerWheel TimerWheel(1.f);
+
+	// The first one is on the second level, and cascades behind the ones that are added directly to the first level
+	TimerWheel.Add(100.f, 1);
+
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+	TimerWheel.Advance(50.f, ExpiredTimers);
+
+	TimerWheel.Add(50.f, 2);
+	TimerWheel.Add(50.f, 3);
+	TimerWheel.Add(50.f, 4);
+
+	TimerWheel.Advance(50.f, ExpiredTimers);
+
+	if (TestEqual(TEXT("Expired timers"), ExpiredTimers.Num(), 4))
+	{
+		for (int32 Index = 0; Index < ExpiredTimers.Num(); Index++)
+		{
+			TestEqual(TEXT("Expiry order"), ExpiredTimers[Index].Payload, static_cast<uint64>(Index + 1));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTimerWheelRemoveTest, "CommonSubsystems.TimerWheel.Remove",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTimerWheelRemoveTest::RunTest(const FString& Parameters)
+{
+	FCommonTimerWheel TimerWheel(1.f);
+
+	// Same slot, and one that has to cascade
+	const FCommonTimerHandle Kept = TimerWheel.Add(5.f, 1);
+	const FCommonTimerHandle Removed = TimerWheel.Add(5.f, 2);
+	const FCommonTimerHandle RemovedFar = TimerWheel.Add(500.f, 3);
+
+	TestTrue(TEXT("Remove"), TimerWheel.Remove(Removed));
+	TestTrue(TEXT("Remove before cascading"), TimerWheel.Remove(RemovedFar));
+	TestFalse(TEXT("Remove twice"), TimerWheel.Remove(Removed));
+	TestFalse(TEXT("Removed timer is inactive"), TimerWheel.IsActive(Removed));
+	TestTrue(TEXT("Other timer in the slot is active"), TimerWheel.IsActive(Kept));
+	TestEqual(TEXT("Active timers"), TimerWheel.Num(), 1);
+
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+	TimerWheel.Advance(1000.f, ExpiredTimers);
+
+	if (TestEqual(TEXT("Expired timers"), ExpiredTimers.Num(), 1))
+	{
+		TestEqual(TEXT("Expired timer"), ExpiredTimers[0].Payload, static_cast<uint64>(1));
+		TestTrue(TEXT("Expired timer handle"), ExpiredTimers[0].Handle == Kept);
+	}
+
+	TestFalse(TEXT("Expired timer is inactive"), TimerWheel.IsActive(Kept));
+	TestFalse(TEXT("Remove expired timer"), TimerWheel.Remove(Kept));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTimerWheelParkedTest, "CommonSubsystems.TimerWheel.Parked",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTimerWheelParkedTest::RunTest(const FString& Parameters)
+{
+	FCommonTimerWheel TimerWheel(1.f);
+
+	// Further than the last level covers, so it's parked until it comes closer
+	constexpr float ParkedDelay = 4.f * 1024.f * 1024.f * 1024.f;
+	const FCommonTimerHandle Parked = TimerWheel.Add(ParkedDelay, 1);
+	const FCommonTimerHandle Near = TimerWheel.Add(10.f, 2);
+
+	TestTrue(TEXT("Parked timer is active"), TimerWheel.IsActive(Parked));
+	TestEqual(TEXT("Parked timer remaining time"), TimerWheel.GetRemainingSeconds(Parked), ParkedDelay);
+
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+	for (int32 Tick = 0; Tick < 100; Tick++)
+	{
+		TimerWheel.Advance(1.f, ExpiredTimers);
+	}
+
+	if (TestEqual(TEXT("Expired timers"), ExpiredTimers.Num(), 1))
+	{
+		TestTrue(TEXT("Near timer expires past the parked one"), ExpiredTimers[0].Handle == Near);
+	}
+
+	TestTrue(TEXT("Parked timer is still active"), TimerWheel.IsActive(Parked));
+	TestTrue(TEXT("Parked timer is still parked"), TimerWheel.GetRemainingSeconds(Parked) > 1024.f * 1024.f * 1024.f);
+
+	TestTrue(TEXT("Remove parked timer"), TimerWheel.Remove(Parked));
+	TestEqual(TEXT("Active timers"), TimerWheel.Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCommonTimerWheelHandleReuseTest, "CommonSubsystems.TimerWheel.HandleReuse",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCommonTimerWheelHandleReuseTest::RunTest(const FString& Parameters)
+{
+	FCommonTimerWheel TimerWheel(1.f);
+
+	const FCommonTimerHandle Stale = TimerWheel.Add(5.f, 1);
+	TimerWheel.Remove(Stale);
+
+	// Freed nodes are reused, with the next serial
+	const FCommonTimerHandle Reused = TimerWheel.Add(5.f, 2);
+
+	TestTrue(TEXT("Handles differ"), Stale != Reused);
+	TestFalse(TEXT("Stale handle is inactive"), TimerWheel.IsActive(Stale));
+	TestFalse(TEXT("Stale handle doesn't remove the new timer"), TimerWheel.Remove(Stale));
+	TestEqual(TEXT("Stale handle remaining time"), TimerWheel.GetRemainingSeconds(Stale), -1.f);
+	TestTrue(TEXT("New timer is active"), TimerWheel.IsActive(Reused));
+
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+	TimerWheel.Advance(5.f, ExpiredTimers);
+
+	if (TestEqual(TEXT("Expired timers"), ExpiredTimers.Num(), 1))
+	{
+		TestEqual(TEXT("Expired timer"), ExpiredTimers[0].Payload, static_cast<uint64>(2));
+	}
+
+	return true;
+}
+
+#endif
@@ -1,3 +1,56 @@
 // Author: Antonio Sidenko (Tonetfal), July 2023
 
 #pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * If true, per-subsystem tick profiler scopes, stats, CSV stats and hitch reports are compiled in. Only affects code,
+ * not the layout of the exported types, so modules may define it differently.
+ */
+#ifndef COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION
+#define COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION !UE_BUILD_SHIPPING
+#endif
+
+/** If true, world subsystem creation and initialization are profiled on map load. */
+#ifndef COMMON_SUBSYSTEMS_WITH_STARTUP_PROFILER
+#define COMMON_SUBSYSTEMS_WITH_STARTUP_PROFILER !UE_BUILD_SHIPPING
+#endif
+
+/** If true, the report of memory held by world and game instance subsystems is compiled in. */
+#ifndef COMMON_SUBSYSTEMS_WITH_MEMORY_REPORT
+#define COMMON_SUBSYSTEMS_WITH_MEMORY_REPORT !UE_BUILD_SHIPPING
+#endif
+
+/** If true, the build has client code, i.e. it isn't a dedicated server build. */
+#ifndef COMMON_SUBSYSTEMS_WITH_CLIENT_CODE
+#define COMMON_SUBSYSTEMS_WITH_CLIENT_CODE !UE_SERVER
+#endif
+
+/** If true, the build has server code, i.e. it isn't a client-only build. */
+#ifndef COMMON_SUBSYSTEMS_WITH_SERVER_CODE
+#define COMMON_SUBSYSTEMS_WITH_SERVER_CODE WITH_SERVER_CODE
+#endif
+
+/**
+ * Builds a subsystem is compiled for.
+ * @see		COMMON_SUBSYSTEMS_TARGETS()
+ */
+enum class ECommonSubsystemTargets : uint8
+{
+	None = 0,
+
+	/** Builds with client code: game and client builds. */
+	Client = 1 << 0,
+
+	/** Builds with server code: game and server builds. */
+	Server = 1 << 1,
+
+	All = Client | Server,
+};
+ENUM_CLASS_FLAGS(ECommonSubsystemTargets);
+
+/** Targets of the current build. */
+inline constexpr ECommonSubsystemTargets GCommonSubsystemCurrentTargets =
+	(COMMON_SUBSYSTEMS_WITH_CLIENT_CODE ? ECommonSubsystemTargets::Client : ECommonSubsystemTargets::None) |
+	(COMMON_SUBSYSTEMS_WITH_SERVER_CODE ? ECommonSubsystemTargets::Server : ECommonSubsystemTargets::None);
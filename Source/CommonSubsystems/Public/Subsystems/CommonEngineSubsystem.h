@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include "Engine/Engine.h"
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonSubsystemTraits.h"
 #include "Subsystems/EngineSubsystem.h"
 
 #include "CommonEngineSubsystem.generated.h"
@@ -10,39 +13,12 @@
 	public: \
 		static bool HasInstance(const UObject* ContextObject) \
 		{ \
-			/** \
-			 * We don't do anything with the given object, however we ask for it to keep the common interface, and to make it \
-			 * easy to change the nature of a subsystem without changing the getters. \
-			 */ \
-			 \
-			if (!IsValid(ContextObject)) \
-			{ \
-				return false; \
-			} \
-			\
-			const auto* ThisSubsystem = GEngine->GetEngineSubsystem<ThisClass>(); \
-			if (!IsValid(ThisSubsystem)) \
-			{ \
-				return false; \
-			} \
-			 \
-			return true; \
+			return TCommonEngineSubsystem<ThisClass>::HasInstance(ContextObject); \
 		} \
 		\
 		static ThisClass& Get(const UObject* ContextObject) \
 		{ \
-			/** \
-			 * We don't do anything with the given object, however we ask for it to keep the common interface, and to make it \
-			 * easy to change the nature of a subsystem without changing the getters. \
-			 */ \
-			 \
-			check(IsValid(ContextObject)); \
-			 \
-			auto* ThisSubsystem = GEngine->GetEngineSubsystem<ThisClass>(); \
-			check(IsValid(ThisSubsystem)); \
-			\
-			auto& ThisSubsystemRef = *ThisSubsystem; \
-			return ThisSubsystemRef; \
+			return TCommonEngineSubsystem<ThisClass>::Get(ContextObject); \
 		}
 
 /**
@@ -58,4 +34,86 @@ class COMMONSUBSYSTEMS_API UCommonEngineSubsystem
 	GENERATED_BODY()
 	// COMMON_SUBSYSTEMS_ENGINE_BODY()
 	// ^^^ Include this in your override of the subsystem ^^^
+
+public:
+	//~UEngineSubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End of UEngineSubsystem Interface
+
+protected:
+	/**
+	 * Close the lifetime worker threads borrow the subsystem through: new borrows fail, and the outstanding ones are
+	 * asked to cancel and waited for. Deinitialize() overrides have to call it before tearing down anything borrowers
+	 * might use, since Super::Deinitialize() only closes it afterwards.
+	 */
+	void CloseLifetime();
+};
+
+/**
+ * Lookups of a common engine subsystem class, behind the COMMON_SUBSYSTEMS_ENGINE_BODY() shorthands. Paths ruled out
+ * by the class' TCommonSubsystemTraits are compiled out.
+ *
+ * The context object isn't used, however it's asked for to keep the common interface, and to make it easy to change
+ * the nature of a subsystem without changing the getters.
+ */
+template<typename Derived>
+class TCommonEngineSubsystem
+{
+public:
+	using FTraits = TCommonSubsystemTraits<Derived>;
+
+	/**
+	 * Get dense index of the class, shared by every module. Assigned on first use.
+	 * @return	Index of the class' slot in the subsystem cache.
+	 */
+	static int32 GetTypeIndex()
+	{
+		return FCommonSubsystemCache::GetClassSlot<Derived>();
+	}
+
+	static bool HasInstance(const UObject* ContextObject)
+	{
+		if (!IsValid(ContextObject))
+		{
+			return false;
+		}
+
+		if (FCommonSubsystemCache::Get().Find<Derived>(GEngine))
+		{
+			return true;
+		}
+
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			const auto* ThisSubsystem = GEngine->GetEngineSubsystem<Derived>();
+			if (IsValid(ThisSubsystem))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static Derived& Get(const UObject* ContextObject)
+	{
+		check(IsValid(ContextObject));
+
+		if (auto* CachedSubsystem = FCommonSubsystemCache::Get().Find<Derived>(GEngine))
+		{
+			return *CachedSubsystem;
+		}
+
+		Derived* ThisSubsystem = nullptr;
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			ThisSubsystem = GEngine->GetEngineSubsystem<Derived>();
+		}
+
+		check(IsValid(ThisSubsystem));
+
+		auto& ThisSubsystemRef = *ThisSubsystem;
+		return ThisSubsystemRef;
+	}
 };
@@ -2,6 +2,11 @@
 
 #pragma once
 
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Subsystems/CommonGameInstanceSubsystemManager.h"
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonSubsystemTraits.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 
 #include "CommonGameInstanceSubsystem.generated.h"
@@ -10,44 +15,12 @@
 	public: \
 		static bool HasInstance(const UObject* ContextObject) \
 		{ \
-			check(IsValid(ContextObject)); \
-			 \
-			const UWorld* World = ContextObject->GetWorld(); \
-			if (!IsValid(World)) \
-			{ \
-				return false; \
-			} \
-			\
-			const UGameInstance* GameInstance = World->GetGameInstance(); \
-			if (!IsValid(GameInstance)) \
-			{ \
-				return false; \
-			} \
-			 \
-			const auto* ThisSubsystem = GameInstance->GetSubsystem<ThisClass>(); \
-			if (!IsValid(ThisSubsystem)) \
-			{ \
-				return false; \
-			} \
-			\
-			return true; \
+			return TCommonGameInstanceSubsystem<ThisClass>::HasInstance(ContextObject); \
 		} \
 		\
 		static ThisClass& Get(const UObject* ContextObject) \
 		{ \
-			check(IsValid(ContextObject)); \
-			\
-			const UWorld* World = ContextObject->GetWorld(); \
-			check(IsValid(World)); \
-			\
-			const UGameInstance* GameInstance = World->GetGameInstance(); \
-			check(IsValid(GameInstance)); \
-			\
-			auto* ThisSubsystem = GameInstance->GetSubsystem<ThisClass>(); \
-			check(IsValid(ThisSubsystem)); \
-			\
-			auto& ThisSubsystemRef = *ThisSubsystem; \
-			return ThisSubsystemRef; \
+			return TCommonGameInstanceSubsystem<ThisClass>::Get(ContextObject); \
 		}
 
 /**
@@ -60,4 +33,145 @@ class COMMONSUBSYSTEMS_API UCommonGameInstanceSubsystem
 	GENERATED_BODY()
 	// COMMON_SUBSYSTEMS_GAME_INSTANCE_BODY()
 	// ^^^ Include this in your override of the subsystem ^^^
+
+public:
+	//~UObject Interface
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	//~End of UObject Interface
+
+	//~UGameInstanceSubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	//~End of UGameInstanceSubsystem Interface
+
+	/**
+	 * Check whether this subsystem is created on its first use rather than along with its game instance.
+	 * @return	If true, subsystem is created on first use, false otherwise.
+	 */
+	bool IsCreatedOnFirstUse() const;
+
+protected:
+	/**
+	 * Close the lifetime worker threads borrow the subsystem through: new borrows fail, and the outstanding ones are
+	 * asked to cancel and waited for. Deinitialize() overrides have to call it before tearing down anything borrowers
+	 * might use, since Super::Deinitialize() only closes it afterwards.
+	 */
+	void CloseLifetime();
+
+	/**
+	 * Get size of the memory allocated by members that aren't properties, such as containers and caches. Reported by
+	 * GetResourceSizeEx() in every resource size mode; properties are only counted in the estimated total mode.
+	 * @return	Allocated size in bytes.
+	 */
+	virtual SIZE_T GetAllocatedSize() const;
+
+protected:
+	/**
+	 * If true, the subsystem is constructed and initialized on the first Get() rather than along with its game
+	 * instance, if ShouldCreateSubsystem() allows it when the game instance is created. Such subsystems are only
+	 * reachable through Get(), and mustn't call InitializeDependency().
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Initialization")
+	bool bCreateOnFirstUse = false;
+};
+
+/**
+ * Lookups of a common game instance subsystem class, behind the COMMON_SUBSYSTEMS_GAME_INSTANCE_BODY() shorthands.
+ * Paths ruled out by the class' TCommonSubsystemTraits are compiled out.
+ */
+template<typename Derived>
+class TCommonGameInstanceSubsystem
+{
+public:
+	using FTraits = TCommonSubsystemTraits<Derived>;
+
+	/**
+	 * Get dense index of the class, shared by every module. Assigned on first use.
+	 * @return	Index of the class' slot in the subsystem cache.
+	 */
+	static int32 GetTypeIndex()
+	{
+		return FCommonSubsystemCache::GetClassSlot<Derived>();
+	}
+
+	static bool HasInstance(const UObject* ContextObject)
+	{
+		check(IsValid(ContextObject));
+
+		const UWorld* World = ContextObject->GetWorld();
+		if (!IsValid(World))
+		{
+			return false;
+		}
+
+		const UGameInstance* GameInstance = World->GetGameInstance();
+		if (!IsValid(GameInstance))
+		{
+			return false;
+		}
+
+		if (FCommonSubsystemCache::Get().Find<Derived>(GameInstance))
+		{
+			return true;
+		}
+
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			const auto* ThisSubsystem = GameInstance->GetSubsystem<Derived>();
+			if (IsValid(ThisSubsystem))
+			{
+				return true;
+			}
+		}
+
+		if constexpr (FTraits::bCanBeCreatedOnFirstUse)
+		{
+			const auto* Manager = GameInstance->GetSubsystem<UCommonGameInstanceSubsystemManager>();
+			if (IsValid(Manager) && Manager->CanCreateLazySubsystem(Derived::StaticClass()))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static Derived& Get(const UObject* ContextObject)
+	{
+		check(IsValid(ContextObject));
+
+		const UWorld* World = ContextObject->GetWorld();
+		check(IsValid(World));
+
+		const UGameInstance* GameInstance = World->GetGameInstance();
+		check(IsValid(GameInstance));
+
+		if (auto* CachedSubsystem = FCommonSubsystemCache::Get().Find<Derived>(GameInstance))
+		{
+			return *CachedSubsystem;
+		}
+
+		Derived* ThisSubsystem = nullptr;
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			ThisSubsystem = GameInstance->GetSubsystem<Derived>();
+		}
+
+		if constexpr (FTraits::bCanBeCreatedOnFirstUse)
+		{
+			if (!IsValid(ThisSubsystem))
+			{
+				auto* Manager = GameInstance->GetSubsystem<UCommonGameInstanceSubsystemManager>();
+				check(IsValid(Manager));
+
+				ThisSubsystem = CastChecked<Derived>(Manager->FindOrCreateLazySubsystem(Derived::StaticClass()));
+			}
+		}
+
+		check(IsValid(ThisSubsystem));
+
+		auto& ThisSubsystemRef = *ThisSubsystem;
+		return ThisSubsystemRef;
+	}
 };
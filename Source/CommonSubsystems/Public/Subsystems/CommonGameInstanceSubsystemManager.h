@@ -0,0 +1,65 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Subsystems/CommonLazySubsystemSet.h"
+#include "Subsystems/Components/CommonEventBus.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+
+#include "CommonGameInstanceSubsystemManager.generated.h"
+
+class UCommonGameInstanceSubsystem;
+
+/**
+ * Owns the common game instance subsystems that are created on first use, and the game instance's event bus.
+ */
+UCLASS()
+class COMMONSUBSYSTEMS_API UCommonGameInstanceSubsystemManager
+	: public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Get the manager of a game instance.
+	 * @param	ContextObject object to get the game instance from.
+	 * @return	Game instance's manager if any, nullptr otherwise.
+	 */
+	static UCommonGameInstanceSubsystemManager* Get(const UObject* ContextObject);
+
+	//~UObject Interface
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+	//~End of UObject Interface
+
+	//~UGameInstanceSubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End of UGameInstanceSubsystem Interface
+
+	/**
+	 * Check whether a subsystem that is created on first use is available in this game instance.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @return	If true, subsystem is available, false otherwise.
+	 */
+	bool CanCreateLazySubsystem(const UClass* Class) const;
+
+	/**
+	 * Find a subsystem that is created on first use, or create it.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @return	Subsystem if available, nullptr otherwise.
+	 */
+	UCommonGameInstanceSubsystem* FindOrCreateLazySubsystem(const UClass* Class);
+
+	/**
+	 * Get the event bus shared by the game instance's subsystems.
+	 * @return	Event bus. nullptr once the manager has been deinitialized.
+	 */
+	FCommonEventBus* GetEventBus() const;
+
+private:
+	/** Subsystems that are created on first use. */
+	FCommonLazySubsystemSet LazySubsystems;
+
+	/** Event bus shared by the game instance's subsystems. */
+	TUniquePtr<FCommonEventBus> EventBus;
+};
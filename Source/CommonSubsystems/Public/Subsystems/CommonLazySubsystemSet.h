@@ -0,0 +1,79 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Subsystems/Subsystem.h"
+
+/**
+ * Subsystems of a single owner that are created on first use rather than along with their owner.
+ *
+ * Whether a subsystem class should be created is evaluated up front, when the owner's subsystems are initialized.
+ * Eligible classes are constructed and initialized only once they're asked for. Such subsystems aren't part of the
+ * engine's subsystem collection, so they're only reachable through the common subsystems' Get() shorthands, and
+ * mustn't call InitializeDependency() during their initialization.
+ *
+ * Game thread only.
+ */
+class COMMONSUBSYSTEMS_API FCommonLazySubsystemSet
+{
+public:
+	/**
+	 * Check whether subsystem classes are being evaluated for lazy creation. Lazily created subsystems report they
+	 * shouldn't be created outside of this, so that the engine doesn't create them along with their owner.
+	 * @return	If true, classes are being evaluated, false otherwise.
+	 */
+	static bool IsEvaluating();
+
+	/**
+	 * Evaluate which subsystem classes may be lazily created.
+	 * @param	InOwner object that owns the subsystems.
+	 * @param	InCollection owner's subsystem collection. Passed to the lazily created subsystems' Initialize().
+	 * @param	BaseClass base class of the subsystems to evaluate.
+	 * @param	IsCreatedOnFirstUse predicate telling whether a subsystem class default object opts in to lazy
+	 * creation.
+	 */
+	void Initialize(UObject& InOwner, FSubsystemCollectionBase& InCollection, const UClass* BaseClass,
+		TFunctionRef<bool(const USubsystem& DefaultObject)> IsCreatedOnFirstUse);
+
+	/**
+	 * Deinitialize all the lazily created subsystems, last created first.
+	 */
+	void Deinitialize();
+
+	/**
+	 * Check whether a subsystem of a given class can be lazily created, or has already been.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @return	If true, subsystem is available, false otherwise.
+	 */
+	bool CanCreate(const UClass* Class) const;
+
+	/**
+	 * Find a lazily created subsystem, or create and initialize it.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @param	bOutWasCreated output parameter. If true, the subsystem has been created by this call.
+	 * @return	Subsystem if available, nullptr otherwise.
+	 */
+	USubsystem* FindOrCreate(const UClass* Class, bool& bOutWasCreated);
+
+	/**
+	 * Report referenced objects to the garbage collector.
+	 * @param	Collector garbage collector's reference collector.
+	 */
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	/** Object that owns the subsystems. */
+	UObject* Owner = nullptr;
+
+	/** Owner's subsystem collection. */
+	FSubsystemCollectionBase* Collection = nullptr;
+
+	/** Classes that may be lazily created, and haven't been yet. */
+	TArray<TObjectPtr<UClass>> PendingClasses;
+
+	/** Lazily created subsystems, in creation order. */
+	TArray<TObjectPtr<USubsystem>> Subsystems;
+
+	/** If true, the set has been initialized, and hasn't been deinitialized yet. */
+	bool bIsInitialized = false;
+};
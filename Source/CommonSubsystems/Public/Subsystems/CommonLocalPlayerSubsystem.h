@@ -2,109 +2,61 @@
 
 #pragma once
 
+#include "Engine/GameInstance.h"
 #include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonSubsystemTraits.h"
 #include "Subsystems/LocalPlayerSubsystem.h"
 
 #include "CommonLocalPlayerSubsystem.generated.h"
 
+namespace CommonLocalPlayerSubsystem
+{
+	struct FAllInstancesTicker;
+}
+
 #define COMMON_SUBSYSTEMS_LOCAL_PLAYER_BODY() \
 	public: \
 		static bool HasInstance(const UObject* ContextObject, int32 LocalPlayerNum = 0) \
 		{ \
-			if (!IsValid(ContextObject)) \
-			{ \
-				return false; \
-			} \
-			\
-			const UWorld* World = ContextObject->GetWorld(); \
-			if (!IsValid(World)) \
-			{ \
-				return false; \
-			} \
-			\
-			const UGameInstance* GameInstance = World->GetGameInstance(); \
-			if (!IsValid(GameInstance)) \
-			{ \
-				return false; \
-			} \
-			\
-			const TArray<ULocalPlayer*>& LocalPlayers = GameInstance->GetLocalPlayers(); \
-			if (!LocalPlayers.IsValidIndex(LocalPlayerNum)) \
-			{ \
-				return false; \
-			} \
-			\
-			const ULocalPlayer* LocalPlayer = LocalPlayers[LocalPlayerNum]; \
-			const bool bHasInstance = HasInstance(LocalPlayer); \
-			return bHasInstance; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::HasInstance(ContextObject, LocalPlayerNum); \
 		} \
 		\
 		static bool HasInstance(const ULocalPlayer* LocalPlayer) \
 		{ \
-			if (!IsValid(LocalPlayer)) \
-			{ \
-				return false; \
-			} \
-			\
-			const auto* ThisSubsystem = LocalPlayer->GetSubsystem<ThisClass>(); \
-			if (!IsValid(ThisSubsystem)) \
-			{ \
-				return false; \
-			} \
-			\
-			return true; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::HasInstance(LocalPlayer); \
 		} \
 		\
 		static bool HasInstance(const ULocalPlayerSubsystem* LocalPlayerSubsystem) \
 		{ \
-			if (!IsValid(LocalPlayerSubsystem)) \
-			{ \
-				return false; \
-			} \
-			\
-			const auto* LocalPlayer = LocalPlayerSubsystem->GetLocalPlayer<ULocalPlayer>(); \
-			const bool bHasInstance = HasInstance(LocalPlayer); \
-			return bHasInstance; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::HasInstance(LocalPlayerSubsystem); \
 		} \
 		\
 		static ThisClass& Get(const UObject* ContextObject, int32 LocalPlayerNum = 0) \
 		{ \
-			check(IsValid(ContextObject)); \
-			\
-			const UWorld* World = ContextObject->GetWorld(); \
-			check(IsValid(World)); \
-			\
-			const UGameInstance* GameInstance = World->GetGameInstance(); \
-			check(IsValid(GameInstance)); \
-			\
-			const TArray<ULocalPlayer*>& LocalPlayers = GameInstance->GetLocalPlayers(); \
-			check(LocalPlayers.IsValidIndex(LocalPlayerNum)); \
-			\
-			const ULocalPlayer* LocalPlayer = LocalPlayers[LocalPlayerNum]; \
-			check(IsValid(LocalPlayer)); \
-			\
-			auto& ThisSubsystemRef = Get(LocalPlayer); \
-			return ThisSubsystemRef; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::Get(ContextObject, LocalPlayerNum); \
 		} \
 		\
 		static ThisClass& Get(const ULocalPlayer* LocalPlayer) \
 		{ \
-			check(IsValid(LocalPlayer)); \
-			\
-			auto* ThisSubsystem = LocalPlayer->GetSubsystem<ThisClass>(); \
-			check(IsValid(ThisSubsystem)); \
-			\
-			auto& ThisSubsystemRef = *ThisSubsystem; \
-			return ThisSubsystemRef; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::Get(LocalPlayer); \
 		} \
 		\
 		static ThisClass& Get(const ULocalPlayerSubsystem* LocalPlayerSubsystem) \
 		{ \
-			check(IsValid(LocalPlayerSubsystem)); \
-			\
-			const auto* LocalPlayer = LocalPlayerSubsystem->GetLocalPlayer<ULocalPlayer>(); \
-			auto& ThisSubsystemRef = Get(LocalPlayer); \
-			return ThisSubsystemRef; \
+			return TCommonLocalPlayerSubsystem<ThisClass>::Get(LocalPlayerSubsystem); \
+		} \
+		\
+		static TConstArrayView<UCommonLocalPlayerSubsystem*> GetInstances(const UObject* ContextObject) \
+		{ \
+			return TCommonLocalPlayerSubsystem<ThisClass>::GetInstances(ContextObject); \
+		} \
+		\
+		template<typename FuncType> \
+		static void ForEachInstance(const UObject* ContextObject, FuncType&& Func) \
+		{ \
+			TCommonLocalPlayerSubsystem<ThisClass>::ForEachInstance(ContextObject, Forward<FuncType>(Func)); \
 		}
 
 /**
@@ -118,10 +70,219 @@ class COMMONSUBSYSTEMS_API UCommonLocalPlayerSubsystem
 	// COMMON_SUBSYSTEMS_LOCAL_PLAYER_BODY()
 	// ^^^ Include this in your override of the subsystem ^^^
 
+	friend CommonLocalPlayerSubsystem::FAllInstancesTicker;
+
 public:
+	//~ULocalPlayerSubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End of ULocalPlayerSubsystem Interface
+
 	/**
 	 * Get index associated with local player the subsystem is created on.
 	 * @return	Local player index.
 	 */
 	int32 GetLocalPlayerIndex() const;
+
+	/**
+	 * Get all the live instances of a subsystem class across a game instance's local players. Prefer the
+	 * GetInstances() and ForEachInstance() shorthands. The list is invalidated when local players are added or
+	 * removed, so it mustn't be held on to. Game thread only.
+	 * @param	GameInstance game instance the local players belong to.
+	 * @param	Class class of the subsystems, or one of their super classes.
+	 * @return	Instances ordered by local player index.
+	 */
+	static TConstArrayView<UCommonLocalPlayerSubsystem*> GetInstancesOfClass(const UGameInstance* GameInstance,
+		const UClass* Class);
+
+protected:
+	/**
+	 * Close the lifetime worker threads borrow the subsystem through: new borrows fail, and the outstanding ones are
+	 * asked to cancel and waited for. Deinitialize() overrides have to call it before tearing down anything borrowers
+	 * might use, since Super::Deinitialize() only closes it afterwards.
+	 */
+	void CloseLifetime();
+
+	/**
+	 * Called each tick interval with all the instances of this class when bTickAllInstancesTogether is set. Called on
+	 * the instance of the lowest local player index.
+	 * @param	DeltaSeconds time in seconds since last tick.
+	 * @param	Instances all the instances of this class, ordered by local player index.
+	 */
+	virtual void TickAllInstances(float DeltaSeconds, TConstArrayView<UCommonLocalPlayerSubsystem*> Instances);
+
+protected:
+	/**
+	 * If true, the instances of this class across all the local players tick together through a single
+	 * TickAllInstances() call, false otherwise.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Tick")
+	bool bTickAllInstancesTogether = false;
+
+	/** Time between ticks of all the instances. 0 means every frame. */
+	UPROPERTY(EditDefaultsOnly, Category="Tick", meta=(EditCondition="bTickAllInstancesTogether", ClampMin="0"))
+	float AllInstancesTickInterval = 0.f;
+
+private:
+	/** Game instance the subsystem has been registered in the instance lists of. */
+	const UGameInstance* RegisteredGameInstance = nullptr;
+};
+
+/**
+ * Lookups of a common local player subsystem class, behind the COMMON_SUBSYSTEMS_LOCAL_PLAYER_BODY() shorthands.
+ * Paths ruled out by the class' TCommonSubsystemTraits are compiled out.
+ */
+template<typename Derived>
+class TCommonLocalPlayerSubsystem
+{
+public:
+	using FTraits = TCommonSubsystemTraits<Derived>;
+
+	/**
+	 * Get dense index of the class, shared by every module. Assigned on first use.
+	 * @return	Index of the class' slot in the subsystem cache.
+	 */
+	static int32 GetTypeIndex()
+	{
+		return FCommonSubsystemCache::GetClassSlot<Derived>();
+	}
+
+	static bool HasInstance(const UObject* ContextObject, int32 LocalPlayerNum = 0)
+	{
+		if (!IsValid(ContextObject))
+		{
+			return false;
+		}
+
+		const UWorld* World = ContextObject->GetWorld();
+		if (!IsValid(World))
+		{
+			return false;
+		}
+
+		const UGameInstance* GameInstance = World->GetGameInstance();
+		if (!IsValid(GameInstance))
+		{
+			return false;
+		}
+
+		const TArray<ULocalPlayer*>& LocalPlayers = GameInstance->GetLocalPlayers();
+		if (!LocalPlayers.IsValidIndex(LocalPlayerNum))
+		{
+			return false;
+		}
+
+		const ULocalPlayer* LocalPlayer = LocalPlayers[LocalPlayerNum];
+		const bool bHasInstance = HasInstance(LocalPlayer);
+		return bHasInstance;
+	}
+
+	static bool HasInstance(const ULocalPlayer* LocalPlayer)
+	{
+		if (!IsValid(LocalPlayer))
+		{
+			return false;
+		}
+
+		if (FCommonSubsystemCache::Get().Find<Derived>(LocalPlayer))
+		{
+			return true;
+		}
+
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			const auto* ThisSubsystem = LocalPlayer->GetSubsystem<Derived>();
+			if (IsValid(ThisSubsystem))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static bool HasInstance(const ULocalPlayerSubsystem* LocalPlayerSubsystem)
+	{
+		if (!IsValid(LocalPlayerSubsystem))
+		{
+			return false;
+		}
+
+		const auto* LocalPlayer = LocalPlayerSubsystem->GetLocalPlayer<ULocalPlayer>();
+		const bool bHasInstance = HasInstance(LocalPlayer);
+		return bHasInstance;
+	}
+
+	static Derived& Get(const UObject* ContextObject, int32 LocalPlayerNum = 0)
+	{
+		check(IsValid(ContextObject));
+
+		const UWorld* World = ContextObject->GetWorld();
+		check(IsValid(World));
+
+		const UGameInstance* GameInstance = World->GetGameInstance();
+		check(IsValid(GameInstance));
+
+		const TArray<ULocalPlayer*>& LocalPlayers = GameInstance->GetLocalPlayers();
+		check(LocalPlayers.IsValidIndex(LocalPlayerNum));
+
+		const ULocalPlayer* LocalPlayer = LocalPlayers[LocalPlayerNum];
+		check(IsValid(LocalPlayer));
+
+		auto& ThisSubsystemRef = Get(LocalPlayer);
+		return ThisSubsystemRef;
+	}
+
+	static Derived& Get(const ULocalPlayer* LocalPlayer)
+	{
+		check(IsValid(LocalPlayer));
+
+		if (auto* CachedSubsystem = FCommonSubsystemCache::Get().Find<Derived>(LocalPlayer))
+		{
+			return *CachedSubsystem;
+		}
+
+		Derived* ThisSubsystem = nullptr;
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			ThisSubsystem = LocalPlayer->GetSubsystem<Derived>();
+		}
+
+		check(IsValid(ThisSubsystem));
+
+		auto& ThisSubsystemRef = *ThisSubsystem;
+		return ThisSubsystemRef;
+	}
+
+	static Derived& Get(const ULocalPlayerSubsystem* LocalPlayerSubsystem)
+	{
+		check(IsValid(LocalPlayerSubsystem));
+
+		const auto* LocalPlayer = LocalPlayerSubsystem->GetLocalPlayer<ULocalPlayer>();
+		auto& ThisSubsystemRef = Get(LocalPlayer);
+		return ThisSubsystemRef;
+	}
+
+	static TConstArrayView<UCommonLocalPlayerSubsystem*> GetInstances(const UObject* ContextObject)
+	{
+		check(IsValid(ContextObject));
+
+		const UWorld* World = ContextObject->GetWorld();
+		check(IsValid(World));
+
+		const UGameInstance* GameInstance = World->GetGameInstance();
+		check(IsValid(GameInstance));
+
+		const auto Instances = UCommonLocalPlayerSubsystem::GetInstancesOfClass(GameInstance, Derived::StaticClass());
+		return Instances;
+	}
+
+	template<typename FuncType>
+	static void ForEachInstance(const UObject* ContextObject, FuncType&& Func)
+	{
+		for (UCommonLocalPlayerSubsystem* Instance : GetInstances(ContextObject))
+		{
+			Func(*static_cast<Derived*>(Instance));
+		}
+	}
 };
@@ -0,0 +1,245 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Subsystems/Subsystem.h"
+#include "UObject/UObjectArray.h"
+
+class FCommonSubsystemLifetime;
+
+/**
+ * Flat lookup tables of common subsystems, used by the Get() and HasInstance() shorthands.
+ *
+ * Each subsystem class gets a dense slot index, and each subsystem owner (world, game instance, local player or engine)
+ * gets a table of registered subsystems indexed by those slots. Owner tables are found through a small direct-mapped
+ * bucket array, so a lookup boils down to a couple of indexed loads and compares instead of a class keyed map lookup.
+ *
+ * Subsystems register themselves on Initialize, and unregister on Deinitialize. A table is released once its last
+ * subsystem is gone, which bumps its generation. Tables also remember their owner's object serial number, so that an
+ * owner destroyed without unregistering its subsystems isn't mistaken for a new one allocated at the same address.
+ * Each registered subsystem also gets a thread-safe lifetime, which is closed at the start of its deinitialization.
+ *
+ * Game thread only.
+ */
+class COMMONSUBSYSTEMS_API FCommonSubsystemCache
+{
+public:
+	FCommonSubsystemCache();
+
+	/**
+	 * Get the cache instance.
+	 * @return	Cache instance.
+	 */
+	static FCommonSubsystemCache& Get()
+	{
+		return Instance;
+	}
+
+	/**
+	 * Get slot index associated with a class. Assigned on first use.
+	 * @return	Slot index.
+	 */
+	template<typename T>
+	static int32 GetClassSlot()
+	{
+		static const int32 Slot = Get().GetClassSlot(T::StaticClass());
+		return Slot;
+	}
+
+	/**
+	 * Get slot index associated with a class. Assigned on first use.
+	 * @param	Class class to get the slot of.
+	 * @return	Slot index.
+	 */
+	int32 GetClassSlot(const UClass* Class);
+
+	/**
+	 * Register a subsystem in its owner's table, under its class and all its super classes up to a given one.
+	 * @param	Subsystem subsystem to register. Its outer is the owner.
+	 * @param	StopClass class to stop at. It's not registered.
+	 */
+	void Register(USubsystem& Subsystem, const UClass* StopClass);
+
+	/**
+	 * Unregister a subsystem from its owner's table.
+	 * @param	Subsystem subsystem to unregister.
+	 */
+	void Unregister(USubsystem& Subsystem);
+
+	/**
+	 * Close the lifetime of a registered subsystem, waiting for its borrowers to return it.
+	 * @param	Subsystem subsystem whose lifetime to close.
+	 */
+	void CloseLifetime(USubsystem& Subsystem);
+
+	/**
+	 * Find the lifetime of a registered subsystem.
+	 * @param	Subsystem registered subsystem.
+	 * @return	Subsystem's lifetime if it's still open, nullptr otherwise.
+	 */
+	TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe> FindLifetime(const USubsystem& Subsystem) const;
+
+	/**
+	 * Find a registered subsystem.
+	 * @param	Owner object that owns the subsystem.
+	 * @return	Subsystem if registered, nullptr otherwise.
+	 */
+	template<typename T>
+	T* Find(const UObject* Owner) const
+	{
+		USubsystem* Subsystem = Find(Owner, GetClassSlot<T>());
+		return static_cast<T*>(Subsystem);
+	}
+
+	/**
+	 * Find a registered subsystem.
+	 * @param	Owner object that owns the subsystem.
+	 * @param	Slot slot index of the subsystem class.
+	 * @return	Subsystem if registered, nullptr otherwise.
+	 */
+	FORCEINLINE USubsystem* Find(const UObject* Owner, int32 Slot) const
+	{
+		checkSlow(Owner);
+
+		const int32 TableIndex = Buckets[GetBucketIndex(Owner)];
+		if (TableIndex != INDEX_NONE)
+		{
+			const FOwnerTable& Table = Tables[TableIndex];
+			if (Table.Owner == Owner && Table.OwnerSerialNumber == GetSerialNumber(Owner))
+			{
+				USubsystem* Subsystem = Table.Subsystems.IsValidIndex(Slot) ? Table.Subsystems[Slot] : nullptr;
+				return Subsystem;
+			}
+		}
+
+		USubsystem* Subsystem = FindSlow(Owner, Slot);
+		return Subsystem;
+	}
+
+	/**
+	 * Find a registered subsystem by a previously retrieved table location.
+	 * @param	TableIndex index of the owner's table.
+	 * @param	Generation generation of the owner's table.
+	 * @param	Slot slot index of the subsystem class.
+	 * @return	Subsystem if still registered, nullptr otherwise.
+	 */
+	FORCEINLINE USubsystem* Find(int32 TableIndex, uint32 Generation, int32 Slot) const
+	{
+		if (!Tables.IsValidIndex(TableIndex))
+		{
+			return nullptr;
+		}
+
+		const FOwnerTable& Table = Tables[TableIndex];
+		if (Table.Generation != Generation)
+		{
+			return nullptr;
+		}
+
+		USubsystem* Subsystem = Table.Subsystems.IsValidIndex(Slot) ? Table.Subsystems[Slot] : nullptr;
+		return Subsystem;
+	}
+
+	/**
+	 * Get location of the table a subsystem is registered in.
+	 * @param	Subsystem registered subsystem.
+	 * @param	OutTableIndex output parameter. Index of the owner's table.
+	 * @param	OutGeneration output parameter. Generation of the owner's table.
+	 * @return	If true, subsystem's owner has a table, false otherwise.
+	 */
+	bool GetTableLocation(const USubsystem& Subsystem, int32& OutTableIndex, uint32& OutGeneration) const;
+
+private:
+	/**
+	 * Find a registered subsystem whose owner is not in the bucket array.
+	 * @param	Owner object that owns the subsystem.
+	 * @param	Slot slot index of the subsystem class.
+	 * @return	Subsystem if registered, nullptr otherwise.
+	 */
+	USubsystem* FindSlow(const UObject* Owner, int32 Slot) const;
+
+	/**
+	 * Find the table of an owner.
+	 * @param	Owner object to find the table of.
+	 * @return	Table index if the owner has one, INDEX_NONE otherwise.
+	 */
+	int32 FindTableIndex(const UObject* Owner) const;
+
+	/**
+	 * Find the table of an owner, or create one.
+	 * @param	Owner object to find the table of.
+	 * @return	Table index.
+	 */
+	int32 FindOrAddTableIndex(const UObject* Owner);
+
+	/**
+	 * Release the table of an owner that has no subsystems left.
+	 * @param	TableIndex index of the table to release.
+	 */
+	void ReleaseTable(int32 TableIndex);
+
+	/**
+	 * Get the object serial number of an owner. Zero if it has never been assigned one.
+	 * @param	Owner object to get the serial number of.
+	 * @return	Serial number.
+	 */
+	static FORCEINLINE int32 GetSerialNumber(const UObject* Owner)
+	{
+		const int32 SerialNumber = GUObjectArray.GetSerialNumber(Owner->GetUniqueID());
+		return SerialNumber;
+	}
+
+	/**
+	 * Get bucket an owner maps to.
+	 * @param	Owner object to get the bucket of.
+	 * @return	Bucket index.
+	 */
+	static FORCEINLINE int32 GetBucketIndex(const UObject* Owner)
+	{
+		const int32 BucketIndex = static_cast<int32>(Owner->GetUniqueID() & (NumBuckets - 1));
+		return BucketIndex;
+	}
+
+private:
+	struct FOwnerTable
+	{
+		/** Object that owns the subsystems. nullptr if the table is free. */
+		const UObject* Owner = nullptr;
+
+		/** Incremented each time the table is released. Compared by the lookups of subsystem handles. */
+		uint32 Generation = 0;
+
+		/** Object serial number of the owner, compared by the lookups by owner. */
+		int32 OwnerSerialNumber = 0;
+
+		/** Number of subsystems registered in the table. */
+		int32 NumRegistered = 0;
+
+		/** Registered subsystems indexed by class slot. */
+		TArray<USubsystem*> Subsystems;
+	};
+
+	/** Number of buckets. Must be a power of two. */
+	static constexpr int32 NumBuckets = 256;
+
+	/** Cache instance. */
+	static FCommonSubsystemCache Instance;
+
+	/** Table indices indexed by owner unique ID. INDEX_NONE if empty. */
+	int32 Buckets[NumBuckets];
+
+	/** All owner tables, including the free ones. */
+	TArray<FOwnerTable> Tables;
+
+	/** Indices of free tables. */
+	TArray<int32> FreeTableIndices;
+
+	/** Table indices of all owners, including the ones that didn't fit in the bucket array. */
+	TMap<const UObject*, int32> OwnerTableIndices;
+
+	/** Slot indices of classes. */
+	TMap<const UClass*, int32> ClassSlots;
+
+	/** Open lifetimes of registered subsystems. */
+	TMap<const USubsystem*, TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe>> Lifetimes;
+};
@@ -0,0 +1,124 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Subsystems/CommonSubsystemCache.h"
+
+/**
+ * Cheap handle to a common subsystem, meant to be resolved once and dereferenced on hot paths.
+ *
+ * Dereferencing doesn't go through the world, game instance or local player; it's a table generation compare and a
+ * slot load. The handle becomes invalid once the subsystem is deinitialized, e.g. on world teardown or seamless travel.
+ *
+ * Works with any subsystem that uses one of the COMMON_SUBSYSTEMS_*_BODY() macros. Game thread only.
+ *
+ * Example:
+ *	// BeginPlay
+ *	MySubsystemHandle = TCommonSubsystemHandle<UMyWorldSubsystem>::Resolve(this);
+ *
+ *	// Tick
+ *	if (UMyWorldSubsystem* MySubsystem = MySubsystemHandle.GetPtr())
+ *	{
+ *		MySubsystem->Foo();
+ *	}
+ */
+template<typename T>
+class TCommonSubsystemHandle
+{
+public:
+	TCommonSubsystemHandle() = default;
+
+	/**
+	 * Make a handle to a given subsystem.
+	 * @param	Subsystem subsystem to make the handle to. If not registered, the handle is invalid.
+	 */
+	explicit TCommonSubsystemHandle(const T* Subsystem)
+	{
+		if (!::IsValid(Subsystem))
+		{
+			return;
+		}
+
+		const FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+		if (Cache.GetTableLocation(*Subsystem, TableIndex, Generation))
+		{
+			Slot = FCommonSubsystemCache::GetClassSlot<T>();
+		}
+	}
+
+	/**
+	 * Resolve a handle the same way as T::Get() does.
+	 * @param	Args arguments of T::HasInstance() and T::Get().
+	 * @return	Handle to the subsystem. Invalid if there's no instance.
+	 */
+	template<typename... ArgTypes>
+	static TCommonSubsystemHandle Resolve(const ArgTypes&... Args)
+	{
+		if (!T::HasInstance(Args...))
+		{
+			return TCommonSubsystemHandle();
+		}
+
+		const T& Subsystem = T::Get(Args...);
+		return TCommonSubsystemHandle(&Subsystem);
+	}
+
+	/**
+	 * Get the subsystem.
+	 * @return	Subsystem if still alive, nullptr otherwise.
+	 */
+	FORCEINLINE T* GetPtr() const
+	{
+		const FCommonSubsystemCache& Cache = FCommonSubsystemCache::Get();
+		USubsystem* Subsystem = Cache.Find(TableIndex, Generation, Slot);
+		return static_cast<T*>(Subsystem);
+	}
+
+	/**
+	 * Check whether the subsystem is still alive.
+	 * @return	If true, subsystem is alive, false otherwise.
+	 */
+	FORCEINLINE bool IsValid() const
+	{
+		return GetPtr() != nullptr;
+	}
+
+	/**
+	 * Invalidate the handle.
+	 */
+	void Reset()
+	{
+		TableIndex = INDEX_NONE;
+		Generation = 0;
+		Slot = INDEX_NONE;
+	}
+
+	FORCEINLINE explicit operator bool() const
+	{
+		return IsValid();
+	}
+
+	FORCEINLINE T& operator*() const
+	{
+		T* Subsystem = GetPtr();
+		check(Subsystem);
+		return *Subsystem;
+	}
+
+	FORCEINLINE T* operator->() const
+	{
+		T* Subsystem = GetPtr();
+		check(Subsystem);
+		return Subsystem;
+	}
+
+private:
+	/** Index of the owner's table in the cache. */
+	int32 TableIndex = INDEX_NONE;
+
+	/** Generation of the owner's table at the moment the handle has been made. */
+	uint32 Generation = 0;
+
+	/** Slot index of the subsystem class. */
+	int32 Slot = INDEX_NONE;
+};
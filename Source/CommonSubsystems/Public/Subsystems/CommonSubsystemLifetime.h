@@ -0,0 +1,284 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "HAL/Event.h"
+#include "Subsystems/CommonSubsystemCache.h"
+
+#include <atomic>
+
+/**
+ * Thread-safe lifetime of a common subsystem.
+ *
+ * Worker threads borrow the subsystem for the duration of their work. Once the subsystem starts deinitializing, the
+ * lifetime is closed: new borrows fail, outstanding borrowers are asked to cancel, and the deinitialization waits
+ * until all of them have returned the subsystem, or until CommonSubsystems.Lifetime.TimeoutSeconds has passed. Past
+ * the timeout, the subsystem deinitializes under the remaining borrowers, and its object is only kept from garbage
+ * collection until they return it. Borrows are plain atomic operations, so they're safe on any thread.
+ *
+ * @see		TCommonSubsystemToken
+ */
+class COMMONSUBSYSTEMS_API FCommonSubsystemLifetime
+{
+public:
+	/**
+	 * @param	InSubsystem subsystem the lifetime belongs to.
+	 */
+	explicit FCommonSubsystemLifetime(USubsystem& InSubsystem);
+	~FCommonSubsystemLifetime();
+
+	UE_NONCOPYABLE(FCommonSubsystemLifetime);
+
+	/**
+	 * Borrow the subsystem. Has to be paired with Release(). Thread-safe.
+	 * @return	Subsystem if the lifetime is still open, nullptr otherwise.
+	 */
+	USubsystem* TryBorrow();
+
+	/**
+	 * Return a borrowed subsystem. Thread-safe.
+	 */
+	void Release();
+
+	/**
+	 * Check whether the subsystem has started deinitializing. Thread-safe.
+	 * @return	If true, no more borrows are allowed, false otherwise.
+	 */
+	bool IsClosed() const;
+
+	/**
+	 * Check whether borrowers are asked to cancel their work. Long running work should check it periodically, and
+	 * return the subsystem as soon as possible. Thread-safe.
+	 * @return	If true, cancellation has been requested, false otherwise.
+	 */
+	bool IsCancellationRequested() const;
+
+	/**
+	 * Get number of outstanding borrows. Thread-safe.
+	 * @return	Number of outstanding borrows.
+	 */
+	int32 GetNumBorrows() const;
+
+	/**
+	 * Forbid new borrows, ask the outstanding borrowers to cancel, and wait until they have returned the subsystem,
+	 * for CommonSubsystems.Lifetime.TimeoutSeconds at most. Borrowers must not wait on the game thread while holding a
+	 * borrow. Called by the subsystem on deinitialization. Game thread only.
+	 * @return	If true, all the borrowers have returned the subsystem, false if the wait has timed out, and the
+	 *			subsystem is kept from garbage collection until they do.
+	 */
+	bool Close();
+
+private:
+	/** Set in the state once the lifetime is closed. The rest of the state is the number of outstanding borrows. */
+	static constexpr uint32 ClosedFlag = 1u << 31;
+
+	/** Subsystem the lifetime belongs to. */
+	USubsystem* Subsystem = nullptr;
+
+	/** Closed flag and number of outstanding borrows. */
+	std::atomic<uint32> State = 0;
+
+	/** If true, borrowers are asked to cancel, false otherwise. */
+	std::atomic<bool> bIsCancellationRequested = false;
+
+	/** If true, Close() has timed out, and the subsystem is rooted until the last borrower returns it. */
+	std::atomic<bool> bIsKeptAlive = false;
+
+	/** Triggered by the last borrower to return the subsystem after the lifetime has been closed. */
+	FEventRef AllReleasedEvent { EEventMode::ManualReset };
+};
+
+using FCommonSubsystemLifetimePtr = TSharedPtr<FCommonSubsystemLifetime, ESPMode::ThreadSafe>;
+
+/**
+ * Scoped borrow of a common subsystem. The subsystem won't finish deinitializing while it's borrowed.
+ */
+template<typename T>
+class TCommonSubsystemBorrow
+{
+	template<typename>
+	friend class TCommonSubsystemToken;
+
+public:
+	TCommonSubsystemBorrow() = default;
+
+	TCommonSubsystemBorrow(TCommonSubsystemBorrow&& Other)
+		: Lifetime(MoveTemp(Other.Lifetime))
+		, Subsystem(Other.Subsystem)
+	{
+		Other.Subsystem = nullptr;
+	}
+
+	TCommonSubsystemBorrow& operator=(TCommonSubsystemBorrow&& Other)
+	{
+		if (this != &Other)
+		{
+			Reset();
+
+			Lifetime = MoveTemp(Other.Lifetime);
+			Subsystem = Other.Subsystem;
+			Other.Subsystem = nullptr;
+		}
+
+		return *this;
+	}
+
+	UE_NONCOPYABLE(TCommonSubsystemBorrow);
+
+	~TCommonSubsystemBorrow()
+	{
+		Reset();
+	}
+
+	/**
+	 * Get the borrowed subsystem.
+	 * @return	Subsystem if borrowed, nullptr otherwise.
+	 */
+	FORCEINLINE T* Get() const
+	{
+		return Subsystem;
+	}
+
+	/**
+	 * Check whether the subsystem wants its borrowers to cancel their work, and return it.
+	 * @return	If true, cancellation has been requested, false otherwise.
+	 */
+	bool IsCancellationRequested() const
+	{
+		return !Subsystem || Lifetime->IsCancellationRequested();
+	}
+
+	/**
+	 * Return the subsystem before the borrow goes out of scope.
+	 */
+	void Reset()
+	{
+		if (Subsystem)
+		{
+			Subsystem = nullptr;
+			Lifetime->Release();
+		}
+
+		Lifetime.Reset();
+	}
+
+	FORCEINLINE explicit operator bool() const
+	{
+		return Subsystem != nullptr;
+	}
+
+	FORCEINLINE T* operator->() const
+	{
+		check(Subsystem);
+		return Subsystem;
+	}
+
+	FORCEINLINE T& operator*() const
+	{
+		check(Subsystem);
+		return *Subsystem;
+	}
+
+private:
+	/** Lifetime the subsystem has been borrowed from. */
+	FCommonSubsystemLifetimePtr Lifetime;
+
+	/** Borrowed subsystem. nullptr if not borrowed. */
+	T* Subsystem = nullptr;
+};
+
+/**
+ * Ref-counted token to a common subsystem that worker threads can borrow the subsystem through.
+ *
+ * The token is acquired on the game thread, and can then be copied to and used from any thread. Borrowing fails once
+ * the subsystem has started deinitializing, and the deinitialization waits until all the borrows have been returned.
+ *
+ * Works with any subsystem that uses one of the COMMON_SUBSYSTEMS_*_BODY() macros.
+ *
+ * Example:
+ *	// Game thread
+ *	const auto Token = TCommonSubsystemToken<UMyWorldSubsystem>::Resolve(this);
+ *
+ *	UE::Tasks::Launch(UE_SOURCE_LOCATION, [Token]
+ *	{
+ *		if (const TCommonSubsystemBorrow<UMyWorldSubsystem> MySubsystem = Token.Borrow())
+ *		{
+ *			MySubsystem->DoThreadSafeWork();
+ *		}
+ *	});
+ */
+template<typename T>
+class TCommonSubsystemToken
+{
+public:
+	TCommonSubsystemToken() = default;
+
+	/**
+	 * Make a token to a given subsystem. Game thread only.
+	 * @param	Subsystem subsystem to make the token to. If not registered, the token is invalid.
+	 */
+	explicit TCommonSubsystemToken(const T* Subsystem)
+	{
+		if (::IsValid(Subsystem))
+		{
+			Lifetime = FCommonSubsystemCache::Get().FindLifetime(*Subsystem);
+		}
+	}
+
+	/**
+	 * Resolve a token the same way as T::Get() does. Game thread only.
+	 * @param	Args arguments of T::HasInstance() and T::Get().
+	 * @return	Token to the subsystem. Invalid if there's no instance.
+	 */
+	template<typename... ArgTypes>
+	static TCommonSubsystemToken Resolve(const ArgTypes&... Args)
+	{
+		if (!T::HasInstance(Args...))
+		{
+			return TCommonSubsystemToken();
+		}
+
+		const T& Subsystem = T::Get(Args...);
+		return TCommonSubsystemToken(&Subsystem);
+	}
+
+	/**
+	 * Borrow the subsystem. Thread-safe.
+	 * @return	Borrow of the subsystem. Empty if the subsystem has started deinitializing.
+	 */
+	TCommonSubsystemBorrow<T> Borrow() const
+	{
+		TCommonSubsystemBorrow<T> Result;
+		if (Lifetime.IsValid())
+		{
+			if (USubsystem* Subsystem = Lifetime->TryBorrow())
+			{
+				Result.Lifetime = Lifetime;
+				Result.Subsystem = static_cast<T*>(Subsystem);
+			}
+		}
+
+		return Result;
+	}
+
+	/**
+	 * Check whether the subsystem can still be borrowed. Thread-safe.
+	 * @return	If true, subsystem hasn't started deinitializing, false otherwise.
+	 */
+	bool IsAlive() const
+	{
+		return Lifetime.IsValid() && !Lifetime->IsClosed();
+	}
+
+	/**
+	 * Invalidate the token.
+	 */
+	void Reset()
+	{
+		Lifetime.Reset();
+	}
+
+private:
+	/** Lifetime of the subsystem. */
+	FCommonSubsystemLifetimePtr Lifetime;
+};
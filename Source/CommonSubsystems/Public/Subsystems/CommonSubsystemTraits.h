@@ -0,0 +1,43 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Default compile-time traits of a common subsystem class.
+ * @see		TCommonSubsystemTraits
+ */
+struct FCommonSubsystemTraitsBase
+{
+	/**
+	 * If true, the subsystem may be created on first use, so lookups that miss fall back to asking the manager of its
+	 * world or game instance, false otherwise.
+	 */
+	static constexpr bool bCanBeCreatedOnFirstUse = true;
+
+	/**
+	 * If true, lookups that miss the cache fall back to the engine's subsystem lookup, false otherwise. Subsystems
+	 * register in the cache right away on Initialize, so the fallback only matters to lookups made before that.
+	 */
+	static constexpr bool bUseEngineLookup = true;
+};
+
+/**
+ * Compile-time traits of a common subsystem class. The Get() and HasInstance() shorthands compile out the lookup paths
+ * the traits rule out, so there's nothing to check for them at runtime.
+ *
+ * Example:
+ *	template<>
+ *	struct TCommonSubsystemTraits<UMyWorldSubsystem>
+ *		: public FCommonSubsystemTraitsBase
+ *	{
+ *		static constexpr bool bCanBeCreatedOnFirstUse = false;
+ *		static constexpr bool bUseEngineLookup = false;
+ *	};
+ */
+template<typename T>
+struct TCommonSubsystemTraits
+	: public FCommonSubsystemTraitsBase
+{
+};
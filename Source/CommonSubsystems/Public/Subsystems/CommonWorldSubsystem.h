@@ -2,47 +2,51 @@
 
 #pragma once
 
+#include "CommonSubsystems.h"
+#include "Engine/World.h"
+#include "Subsystems/CommonSubsystemCache.h"
+#include "Subsystems/CommonSubsystemTraits.h"
+#include "Subsystems/CommonWorldSubsystemManager.h"
 #include "Subsystems/Components/CommonTickComponent.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
 
 #include "CommonWorldSubsystem.generated.h"
 
+/**
+ * Declare the builds a subsystem is compiled for, next to COMMON_SUBSYSTEMS_WORLD_BODY(). In the other builds, the
+ * subsystem is never created, HasInstance() is false without any lookup, and code under
+ * COMMON_SUBSYSTEMS_WITH_CLIENT_CODE or COMMON_SUBSYSTEMS_WITH_SERVER_CODE can be compiled out. Reflected members have
+ * to stay, since the header tool doesn't support custom preprocessor conditions.
+ *
+ * Example:
+ *	COMMON_SUBSYSTEMS_WORLD_BODY()
+ *	COMMON_SUBSYSTEMS_TARGETS(ECommonSubsystemTargets::Client)
+ */
+#define COMMON_SUBSYSTEMS_TARGETS(Targets) \
+	public: \
+		static constexpr bool bIsCompiledForTarget = EnumHasAnyFlags(Targets, GCommonSubsystemCurrentTargets); \
+		\
+		virtual bool IsCompiledForTarget() const override \
+		{ \
+			return bIsCompiledForTarget; \
+		}
+
 #define COMMON_SUBSYSTEMS_WORLD_BODY() \
 	public: \
 		static bool HasInstance(const UObject* ContextObject) \
 		{ \
-			if (!IsValid(ContextObject)) \
-			{ \
-				return false; \
-			} \
-			\
-			const UWorld* World = ContextObject->GetWorld(); \
-			if (!IsValid(World)) \
-			{ \
-				return false; \
-			} \
-			\
-			const auto* ThisSubsystem = World->GetSubsystem<ThisClass>(); \
-			if (!IsValid(ThisSubsystem)) \
-			{ \
-				return false; \
-			} \
-		\
-			return true; \
+			return TCommonWorldSubsystem<ThisClass>::HasInstance(ContextObject); \
 		} \
 		\
 		static ThisClass& Get(const UObject* ContextObject) \
 		{ \
-			check(IsValid(ContextObject)); \
-			\
-			const UWorld* World = ContextObject->GetWorld(); \
-			check(IsValid(World)); \
-			\
-			auto* ThisSubsystem = World->GetSubsystem<ThisClass>(); \
-			check(IsValid(ThisSubsystem)); \
-			\
-			auto& ThisSubsystemRef = *ThisSubsystem; \
-			return ThisSubsystemRef; \
+			return TCommonWorldSubsystem<ThisClass>::Get(ContextObject); \
+		} \
+		\
+		static bool HasReadyInstance(const UObject* ContextObject) \
+		{ \
+			return TCommonWorldSubsystem<ThisClass>::HasReadyInstance(ContextObject); \
 		}
 
 /**
@@ -81,16 +85,38 @@ class COMMONSUBSYSTEMS_API UCommonWorldSubsystem
 	// COMMON_SUBSYSTEMS_WORLD_BODY()
 	// ^^^ Include this in your override of the subsystem ^^^
 
+	friend UCommonWorldSubsystemManager;
+
+public:
+	/** Whether the subsystem is compiled for the current build. Overridden by COMMON_SUBSYSTEMS_TARGETS(). */
+	static constexpr bool bIsCompiledForTarget = true;
+
 public:
 	UCommonWorldSubsystem();
 
+	//~UObject Interface
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	//~End of UObject Interface
+
 	//~UWorldSubsystem Interface
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void PostInitialize() override;
 	virtual void Deinitialize() override;
 	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
 	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
 	//~End of UWorldSubsystem Interface
 
+	/**
+	 * Check whether the subsystem is compiled for the current build. Overridden by COMMON_SUBSYSTEMS_TARGETS().
+	 * @return	If true, subsystem can be created, false otherwise.
+	 */
+	virtual bool IsCompiledForTarget() const;
+
+	//~FCommonTickComponent Interface
+	virtual FString GetTickDebugName() const override;
+	virtual float GetTickLoad() const override;
+	//~End of FCommonTickComponent Interface
+
 protected:
 	/**
 	 * Called each tick interval.
@@ -98,6 +124,44 @@ protected:
 	 */
 	virtual void Tick(float DeltaSeconds);
 
+	/**
+	 * Called each tick interval. Long running work can check the budget, and yield to resume on the next frame.
+	 * By default, calls the regular Tick.
+	 * @param	DeltaSeconds time in seconds since last tick.
+	 * @param	Budget time budget this tick is allowed to spend.
+	 */
+	virtual void TickWithBudget(float DeltaSeconds, FCommonTickBudget& Budget);
+
+	/**
+	 * Called each tick with all the fixed steps accumulated since the last one when bTickFixedStep is set, before the
+	 * tick. Steps are passed at once, so that they can be simulated in a single pass.
+	 * @param	StepSeconds length of a step in seconds.
+	 * @param	NumSteps number of steps to simulate.
+	 */
+	virtual void TickFixed(float StepSeconds, int32 NumSteps);
+
+	/**
+	 * Called each tick some timers added with Timer_Add() have expired on, before the tick.
+	 * @param	ExpiredTimers timers that have expired, earliest first, and in the order they've been added if they've
+	 * expired on the same tick.
+	 */
+	virtual void OnTimersExpired(TConstArrayView<FCommonExpiredTimer> ExpiredTimers);
+
+	/**
+	 * Close the lifetime worker threads borrow the subsystem through: new borrows fail, and the outstanding ones are
+	 * asked to cancel and waited for. Done by the world's manager once the world begins tearing down or is cleaned
+	 * up, before any subsystem deinitializes. Otherwise, Deinitialize() overrides have to call it before tearing down
+	 * anything borrowers might use, since Super::Deinitialize() only closes it afterwards.
+	 */
+	void CloseLifetime();
+
+	/**
+	 * Get size of the memory allocated by members that aren't properties, such as containers and caches. Reported by
+	 * GetResourceSizeEx() in every resource size mode; properties are only counted in the estimated total mode.
+	 * @return	Allocated size in bytes.
+	 */
+	virtual SIZE_T GetAllocatedSize() const;
+
 public:
 	/**
 	 * Check whether a given net mode is supported.
@@ -121,12 +185,40 @@ public:
 	 */
 	FTimerManager& GetTimerManager() const;
 
+	/**
+	 * Check whether the asynchronous initialization has completed, along with the one of its prerequisites.
+	 * Thread-safe.
+	 * @return	If true, subsystem is fully initialized, false otherwise.
+	 */
+	bool IsAsyncInitComplete() const;
+
+	/**
+	 * Check whether this subsystem is created on its first use rather than along with its world.
+	 * @return	If true, subsystem is created on first use, false otherwise.
+	 */
+	bool IsCreatedOnFirstUse() const;
+
 protected:
 	/**
 	 * Called on world initialization
 	 */
 	virtual void OnWorldInitialized();
 
+	/**
+	 * Called on world initialization, after OnWorldInitialized(). Heavy initialization work can be launched here as a
+	 * task, so that it doesn't block the game thread. The task must not touch anything that isn't owned by this
+	 * subsystem. The world's manager waits for it once the world begins tearing down or is cleaned up, before any
+	 * subsystem deinitializes.
+	 *
+	 * Example:
+	 *	return UE::Tasks::Launch(UE_SOURCE_LOCATION, [this] { BuildLookupTables(); }, Prerequisites);
+	 *
+	 * @param	Prerequisites events triggered once the subsystems in AsyncInitPrerequisiteSubsystems have completed
+	 *			their asynchronous initialization. Work depending on them has to be launched with them.
+	 * @return	Asynchronous initialization work. Empty if none.
+	 */
+	virtual UE::Tasks::FTask OnWorldInitializedAsync(TConstArrayView<UE::Tasks::FTaskEvent> Prerequisites);
+
 	/**
 	 * Add given net mode in supported list.
 	 * @param	NetMode net mode to add.
@@ -159,12 +251,36 @@ protected:
 	bool CheckLevelName(const UWorld* World) const;
 
 private:
+	/**
+	 * Check whether this subsystem has to be created.
+	 * @param	Outer world the subsystem would be created for.
+	 * @return	If true, subsystem has to be created, false otherwise.
+	 */
+	bool ShouldCreateSubsystemInternal(UObject* Outer) const;
+
 	/**
 	 * Called on post world initialization.
 	 * @param	NewWorld initialized world.
 	 */
 	void PostInitWorldInternal(UWorld* NewWorld);
 
+	/**
+	 * Get subsystems whose asynchronous initialization has to complete before this one's can start.
+	 * @return	Existing asynchronous initialization prerequisites.
+	 */
+	TArray<UCommonWorldSubsystem*> GetAsyncInitPrerequisites() const;
+
+	/**
+	 * Start the asynchronous initialization. Called by the world's manager once all the subsystems have handled the
+	 * world initialization, after the prerequisites have started theirs.
+	 */
+	void StartAsyncInit();
+
+	/**
+	 * Wait for the asynchronous initialization work to finish, if there's any.
+	 */
+	void WaitForAsyncInit();
+
 #if WITH_EDITOR
 	/**
 	 * Called on post PIE world initialization.
@@ -199,6 +315,28 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Initialization", AdvancedDisplay)
 	bool bEnableInTransitionLevel = false;
 
+	/**
+	 * If true, the subsystem is constructed and initialized on the first Get() rather than along with its world, if
+	 * ShouldCreateSubsystem() allows it when the world is created. Such subsystems are only reachable through Get(),
+	 * and mustn't call InitializeDependency().
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Initialization")
+	bool bCreateOnFirstUse = false;
+
+	/**
+	 * Subsystems that have to finish their tick before this one ticks, if they tick in the same frame. Subsystems that
+	 * don't exist in the world are ignored.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Tick")
+	TArray<TSubclassOf<UCommonWorldSubsystem>> TickPrerequisiteSubsystems;
+
+	/**
+	 * Subsystems whose asynchronous initialization has to complete before this one's can start. Subsystems that don't
+	 * exist in the world are ignored. Must not form cycles.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Initialization")
+	TArray<TSubclassOf<UCommonWorldSubsystem>> AsyncInitPrerequisiteSubsystems;
+
 private:
 	/** Delegate associated with UCommonWorldSubsystem::PostInitWorldInternal(). */
 	FDelegateHandle PostInitWorldDelegateHandle;
@@ -206,8 +344,154 @@ private:
 	/** If true, we've already called UCommonWorldSubsystem::PostInitWorldInternal(), false otherwise. */
 	bool bHasPostWorldInitialized = false;
 
+	/** Triggered once the asynchronous initialization of this subsystem and its prerequisites has completed. */
+	UE::Tasks::FTaskEvent AsyncInitEvent { UE_SOURCE_LOCATION };
+
+	/** Asynchronous initialization work returned by OnWorldInitializedAsync(). */
+	UE::Tasks::FTask AsyncInitTask;
+
+	/** If true, the asynchronous initialization has been started, false otherwise. */
+	bool bHasStartedAsyncInit = false;
+
 #if WITH_EDITOR
 	/** Delegate associated with UCommonWorldSubsystem::PostInitPieWorldInternal(). */
 	FDelegateHandle PostInitPieWorldDelegateHandle;
 #endif
 };
+
+/**
+ * Lookups of a common world subsystem class, behind the COMMON_SUBSYSTEMS_WORLD_BODY() shorthands. Paths ruled out by
+ * the class' TCommonSubsystemTraits, or by COMMON_SUBSYSTEMS_TARGETS(), are compiled out.
+ */
+template<typename Derived>
+class TCommonWorldSubsystem
+{
+public:
+	using FTraits = TCommonSubsystemTraits<Derived>;
+
+	/**
+	 * Get dense index of the class, shared by every module. Assigned on first use.
+	 * @return	Index of the class' slot in the subsystem cache.
+	 */
+	static int32 GetTypeIndex()
+	{
+		return FCommonSubsystemCache::GetClassSlot<Derived>();
+	}
+
+	static bool HasInstance(const UObject* ContextObject)
+	{
+		if constexpr (!Derived::bIsCompiledForTarget)
+		{
+			return false;
+		}
+		else
+		{
+			if (!IsValid(ContextObject))
+			{
+				return false;
+			}
+
+			const UWorld* World = ContextObject->GetWorld();
+			if (!IsValid(World))
+			{
+				return false;
+			}
+
+			if (FCommonSubsystemCache::Get().Find<Derived>(World))
+			{
+				return true;
+			}
+
+			if constexpr (FTraits::bUseEngineLookup)
+			{
+				const auto* ThisSubsystem = World->GetSubsystem<Derived>();
+				if (IsValid(ThisSubsystem))
+				{
+					return true;
+				}
+			}
+
+			if constexpr (FTraits::bCanBeCreatedOnFirstUse)
+			{
+				const auto* Manager = World->GetSubsystem<UCommonWorldSubsystemManager>();
+				if (IsValid(Manager) && Manager->CanCreateLazySubsystem(Derived::StaticClass()))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+
+	static Derived& Get(const UObject* ContextObject)
+	{
+		checkf(Derived::bIsCompiledForTarget, TEXT("Subsystem [%s] is not compiled for this build."),
+			*Derived::StaticClass()->GetName());
+		check(IsValid(ContextObject));
+
+		const UWorld* World = ContextObject->GetWorld();
+		check(IsValid(World));
+
+		if (auto* CachedSubsystem = FCommonSubsystemCache::Get().Find<Derived>(World))
+		{
+			return *CachedSubsystem;
+		}
+
+		Derived* ThisSubsystem = nullptr;
+		if constexpr (FTraits::bUseEngineLookup)
+		{
+			ThisSubsystem = World->GetSubsystem<Derived>();
+		}
+
+		if constexpr (FTraits::bCanBeCreatedOnFirstUse)
+		{
+			if (!IsValid(ThisSubsystem))
+			{
+				auto* Manager = World->GetSubsystem<UCommonWorldSubsystemManager>();
+				check(IsValid(Manager));
+
+				ThisSubsystem = CastChecked<Derived>(Manager->FindOrCreateLazySubsystem(Derived::StaticClass()));
+			}
+		}
+
+		check(IsValid(ThisSubsystem));
+
+		auto& ThisSubsystemRef = *ThisSubsystem;
+		return ThisSubsystemRef;
+	}
+
+	static bool HasReadyInstance(const UObject* ContextObject)
+	{
+		if constexpr (!Derived::bIsCompiledForTarget)
+		{
+			return false;
+		}
+		else
+		{
+			if (!IsValid(ContextObject))
+			{
+				return false;
+			}
+
+			const UWorld* World = ContextObject->GetWorld();
+			if (!IsValid(World))
+			{
+				return false;
+			}
+
+			// Lazily created subsystems are in the cache once created, and asking about them mustn't create them
+			const Derived* ThisSubsystem = FCommonSubsystemCache::Get().Find<Derived>(World);
+			if constexpr (FTraits::bUseEngineLookup)
+			{
+				if (!ThisSubsystem)
+				{
+					ThisSubsystem = World->GetSubsystem<Derived>();
+				}
+			}
+
+			const bool bIsReady = IsValid(ThisSubsystem) && ThisSubsystem->IsAsyncInitComplete();
+			return bIsReady;
+		}
+	}
+};
@@ -0,0 +1,215 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Containers/Ticker.h"
+#include "Subsystems/CommonLazySubsystemSet.h"
+#include "Subsystems/Components/CommonEventBus.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+
+#include "CommonWorldSubsystemManager.generated.h"
+
+class UCommonWorldSubsystem;
+
+/**
+ * Tracks the common world subsystems of a world as a whole.
+ *
+ * Once every common world subsystem has handled the world initialization, their asynchronous initialization is
+ * started in dependency order. Once all of it has completed, the world's subsystems are considered ready.
+ *
+ * It also owns the subsystems that are created on first use, and the world's event bus.
+ */
+UCLASS()
+class COMMONSUBSYSTEMS_API UCommonWorldSubsystemManager
+	: public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	friend UCommonWorldSubsystem;
+
+public:
+	DECLARE_MULTICAST_DELEGATE(FOnSubsystemsReady);
+
+public:
+	/**
+	 * Get the manager of a world.
+	 * @param	ContextObject object to get the world from.
+	 * @return	World's manager if any, nullptr otherwise.
+	 */
+	static UCommonWorldSubsystemManager* Get(const UObject* ContextObject);
+
+	//~UObject Interface
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+	//~End of UObject Interface
+
+	//~UWorldSubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	//~End of UWorldSubsystem Interface
+
+	/**
+	 * Run the world initialization of the subsystems now. Needed by worlds that aren't loaded as a map, such as the
+	 * ones made with UWorld::CreateWorld(), to ever get their subsystems ready. Does nothing if it has already run.
+	 */
+	void InitializeWorld();
+
+	/**
+	 * Check whether a subsystem that is created on first use is available in this world.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @return	If true, subsystem is available, false otherwise.
+	 */
+	bool CanCreateLazySubsystem(const UClass* Class) const;
+
+	/**
+	 * Find a subsystem that is created on first use, or create it.
+	 * @param	Class class of the subsystem, or one of its super classes.
+	 * @return	Subsystem if available, nullptr otherwise.
+	 */
+	UCommonWorldSubsystem* FindOrCreateLazySubsystem(const UClass* Class);
+
+	/**
+	 * Check whether all the common world subsystems have completed their initialization, including the asynchronous
+	 * one.
+	 * @return	If true, subsystems are ready, false otherwise.
+	 */
+	bool AreSubsystemsReady() const;
+
+	/**
+	 * Call a delegate once all the common world subsystems are ready, or right away if they already are. Called on
+	 * the game thread.
+	 * @param	Delegate delegate to call.
+	 * @return	Handle to unregister the delegate with. Invalid if the delegate has been called right away.
+	 */
+	FDelegateHandle CallOrRegister_OnSubsystemsReady(FOnSubsystemsReady::FDelegate&& Delegate);
+
+	/**
+	 * Unregister a delegate registered with CallOrRegister_OnSubsystemsReady().
+	 * @param	Handle handle of the delegate to unregister.
+	 */
+	void Unregister_OnSubsystemsReady(FDelegateHandle Handle);
+
+	/**
+	 * Get the event bus shared by the world's subsystems.
+	 * @return	Event bus. nullptr once the manager has been deinitialized.
+	 */
+	FCommonEventBus* GetEventBus() const;
+
+private:
+	/**
+	 * Start tracking an initialized subsystem.
+	 * @param	Subsystem subsystem to track.
+	 */
+	void AddSubsystem(UCommonWorldSubsystem& Subsystem);
+
+	/**
+	 * Stop tracking a deinitialized subsystem.
+	 * @param	Subsystem subsystem to stop tracking.
+	 */
+	void RemoveSubsystem(UCommonWorldSubsystem& Subsystem);
+
+	/**
+	 * Notify that a subsystem has handled the world initialization.
+	 * @param	Subsystem subsystem that has handled the world initialization.
+	 */
+	void NotifyWorldInitialized(UCommonWorldSubsystem& Subsystem);
+
+	/**
+	 * Start asynchronous initialization of all the subsystems, prerequisites first.
+	 */
+	void StartAsyncInit();
+
+	/**
+	 * Add a subsystem to a list after its prerequisites.
+	 * @param	Subsystem subsystem to add.
+	 * @param	OutSortedSubsystems output parameter. Subsystems in dependency order.
+	 * @param	VisitingSubsystems subsystems whose prerequisites are being added. Used to detect cycles.
+	 */
+	static void AddSortedSubsystem(UCommonWorldSubsystem& Subsystem,
+		TArray<UCommonWorldSubsystem*>& OutSortedSubsystems, TArray<UCommonWorldSubsystem*>& VisitingSubsystems);
+
+	/**
+	 * Called once a world begins tearing down. Closes the lifetimes of the subsystems, and waits for their asynchronous
+	 * initialization, so that their worker threads are done before any of them starts deinitializing.
+	 * @param	TearingDownWorld world that begins tearing down.
+	 */
+	void OnWorldBeginTearDown(UWorld* TearingDownWorld);
+
+	/**
+	 * Called once a world is being cleaned up. Worlds that aren't torn down, e.g. destroyed right away, only go
+	 * through the cleanup before their subsystems deinitialize.
+	 * @param	CleanedUpWorld world being cleaned up.
+	 * @param	bSessionEnded true if the game session has ended, false otherwise.
+	 * @param	bCleanupResources true if the world's resources are released, false otherwise.
+	 */
+	void OnWorldCleanup(UWorld* CleanedUpWorld, bool bSessionEnded, bool bCleanupResources);
+
+	/**
+	 * Called once the world has been initialized. Forwards the world initialization to the lazily created subsystems
+	 * that haven't received it.
+	 * @param	NewWorld initialized world.
+	 */
+	void PostInitWorldInternal(UWorld* NewWorld);
+
+#if WITH_EDITOR
+	/**
+	 * Called on post PIE world initialization.
+	 * @param	bSimulating true if world is simulating, false otherwise.
+	 */
+	void PostInitPieWorldInternal(bool bSimulating);
+#endif
+
+	/**
+	 * Core ticker callback. Waits for the asynchronous initialization to complete.
+	 * @param	DeltaSeconds time since last core ticker tick.
+	 * @return	If true, has to keep waiting, false otherwise.
+	 */
+	bool PollSubsystemsReady(float DeltaSeconds);
+
+private:
+	/** Triggered once all the subsystems have completed their initialization. */
+	UE::Tasks::FTaskEvent ReadyEvent { UE_SOURCE_LOCATION };
+
+	/** Tracked subsystems. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCommonWorldSubsystem>> Subsystems;
+
+	/** Number of tracked subsystems that haven't handled the world initialization yet. */
+	int32 NumPendingSubsystems = 0;
+
+	/** If true, asynchronous initialization has been started, false otherwise. */
+	bool bHasStartedAsyncInit = false;
+
+	/** If true, the ready event has been broadcast, false otherwise. */
+	bool bHasBroadcastReady = false;
+
+	/** Fired on the game thread once all the subsystems are ready. */
+	FOnSubsystemsReady OnSubsystemsReady;
+
+	/** Delegate handle for the core ticker entry waiting for the subsystems to be ready. */
+	FTSTicker::FDelegateHandle PollTickerHandle;
+
+	/** Subsystems that are created on first use. */
+	FCommonLazySubsystemSet LazySubsystems;
+
+	/** Event bus shared by the world's subsystems. */
+	TUniquePtr<FCommonEventBus> EventBus;
+
+	/** If true, the world has been initialized, false otherwise. */
+	bool bHasWorldInitialized = false;
+
+	/** Delegate associated with UCommonWorldSubsystemManager::PostInitWorldInternal(). */
+	FDelegateHandle PostInitWorldDelegateHandle;
+
+	/** Delegate associated with UCommonWorldSubsystemManager::OnWorldBeginTearDown(). */
+	FDelegateHandle WorldBeginTearDownDelegateHandle;
+
+	/** Delegate associated with UCommonWorldSubsystemManager::OnWorldCleanup(). */
+	FDelegateHandle WorldCleanupDelegateHandle;
+
+#if WITH_EDITOR
+	/** Delegate associated with UCommonWorldSubsystemManager::PostInitPieWorldInternal(). */
+	FDelegateHandle PostInitPieWorldDelegateHandle;
+#endif
+};
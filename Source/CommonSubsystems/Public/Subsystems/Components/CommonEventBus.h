@@ -0,0 +1,236 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/MpscQueue.h"
+
+#include <atomic>
+
+class UScriptStruct;
+
+/**
+ * Typed message bus between subsystems.
+ *
+ * Events are USTRUCTs. They can be posted from any thread into a lock-free queue per event type, and are delivered
+ * on the game thread in batches, at the start of the tick components' dispatch: each subscriber receives all the
+ * events of its type posted since the last delivery as a single contiguous span, in the order they have been posted.
+ * Event types are delivered one after another, in no particular order.
+ *
+ * Example:
+ *	Bus.Post(FMyDamageEvent { Target, Damage });
+ *	Bus.Subscribe<FMyDamageEvent>(
+ *		FCommonEventBus::TOnEvents<FMyDamageEvent>::FDelegate::CreateUObject(this, &ThisClass::OnDamage));
+ *
+ * Subscription and delivery are game thread only. Threads posting events must stop doing so before the bus is
+ * destroyed. Subscribers may destroy the bus; the rest of the delivery is dropped then.
+ */
+class COMMONSUBSYSTEMS_API FCommonEventBus
+{
+public:
+	template<typename EventType>
+	using TOnEvents = TMulticastDelegate<void(TConstArrayView<EventType>)>;
+
+public:
+	FCommonEventBus();
+	~FCommonEventBus();
+
+	UE_NONCOPYABLE(FCommonEventBus);
+
+	/**
+	 * Post an event. Thread-safe and lock-free once an event of the type has been posted to this bus.
+	 * @param	Event event to post.
+	 */
+	template<typename EventType>
+	void Post(EventType&& Event)
+	{
+		using FEventType = std::decay_t<EventType>;
+
+		TChannel<FEventType>& Channel = FindOrAddChannel<FEventType>();
+		Channel.Queue.Enqueue(Forward<EventType>(Event));
+		Channel.NumQueued.fetch_add(1, std::memory_order_release);
+	}
+
+	/**
+	 * Subscribe to the events of a type.
+	 * @param	Delegate delegate receiving the events posted since the last delivery.
+	 * @return	Handle to unsubscribe with.
+	 */
+	template<typename EventType>
+	FDelegateHandle Subscribe(typename TOnEvents<EventType>::FDelegate&& Delegate)
+	{
+		check(IsInGameThread());
+
+		const FDelegateHandle Handle = FindOrAddChannel<EventType>().OnEvents.Add(MoveTemp(Delegate));
+		return Handle;
+	}
+
+	/**
+	 * Unsubscribe from the events of a type.
+	 * @param	Handle handle returned by Subscribe().
+	 */
+	template<typename EventType>
+	void Unsubscribe(FDelegateHandle Handle)
+	{
+		check(IsInGameThread());
+
+		FindOrAddChannel<EventType>().OnEvents.Remove(Handle);
+	}
+
+	/**
+	 * Unsubscribe an object from the events of all types.
+	 * @param	Subscriber object to unsubscribe.
+	 */
+	void UnsubscribeAll(const void* Subscriber);
+
+	/**
+	 * Deliver the events posted so far to their subscribers. Events posted during the delivery are delivered next
+	 * time. Called by the tick scheduler; game thread only. The bus mustn't be used anymore once a subscriber has
+	 * destroyed it during the delivery.
+	 * @return	Number of delivered events.
+	 */
+	int32 Deliver();
+
+	/**
+	 * Get number of events waiting to be delivered.
+	 * @return	Number of queued events of all types.
+	 */
+	int32 GetNumQueued() const;
+
+private:
+	/**
+	 * Events of a single type.
+	 */
+	struct FChannelBase
+	{
+		virtual ~FChannelBase() = default;
+
+		/**
+		 * Deliver queued events to the subscribers.
+		 * @return	Number of delivered events.
+		 */
+		virtual int32 Deliver() = 0;
+
+		/**
+		 * Unsubscribe an object.
+		 * @param	Subscriber object to unsubscribe.
+		 */
+		virtual void UnsubscribeAll(const void* Subscriber) = 0;
+
+		/** Number of events that have been posted, and haven't been delivered yet. */
+		std::atomic<int32> NumQueued = 0;
+	};
+
+	template<typename EventType>
+	struct TChannel
+		: public FChannelBase
+	{
+		//~FChannelBase Interface
+		virtual int32 Deliver() override
+		{
+			// Events posted from within the subscribers wait for the next delivery
+			const int32 NumToDeliver = NumQueued.load(std::memory_order_acquire);
+
+			Batch.Reset();
+			while (Batch.Num() < NumToDeliver)
+			{
+				TOptional<EventType> Event = Queue.Dequeue();
+				if (!Event.IsSet())
+				{
+					// A producer hasn't finished linking its event yet
+					break;
+				}
+
+				Batch.Add(MoveTemp(Event.GetValue()));
+			}
+
+			NumQueued.fetch_sub(Batch.Num(), std::memory_order_release);
+
+			if (!Batch.IsEmpty())
+			{
+				OnEvents.Broadcast(Batch);
+			}
+
+			return Batch.Num();
+		}
+
+		virtual void UnsubscribeAll(const void* Subscriber) override
+		{
+			OnEvents.RemoveAll(Subscriber);
+		}
+		//~End of FChannelBase Interface
+
+		/** Posted events. */
+		TMpscQueue<EventType> Queue;
+
+		/** Events being delivered. Reused between deliveries. */
+		TArray<EventType> Batch;
+
+		/** Subscribers. */
+		TOnEvents<EventType> OnEvents;
+	};
+
+	/**
+	 * Get the identifier of an event type shared by all the modules.
+	 * @param	EventStruct struct of the event type.
+	 * @return	Identifier of the event type.
+	 */
+	static int32 GetEventTypeId(const UScriptStruct* EventStruct);
+
+	/**
+	 * Get number of event types that have been given an identifier.
+	 * @return	Number of known event types.
+	 */
+	static int32 GetNumEventTypes();
+
+	/**
+	 * Get the channel of an event type, or add it if it doesn't exist yet.
+	 * @return	Channel of the event type.
+	 */
+	template<typename EventType>
+	TChannel<EventType>& FindOrAddChannel()
+	{
+		static const int32 EventTypeId = GetEventTypeId(EventType::StaticStruct());
+
+		FChannelBase* Channel = Channels[EventTypeId].load(std::memory_order_acquire);
+		if (!Channel)
+		{
+			Channel = AddChannel(EventTypeId, new TChannel<EventType>());
+		}
+
+		auto& TypedChannel = static_cast<TChannel<EventType>&>(*Channel);
+		return TypedChannel;
+	}
+
+	/**
+	 * State of an ongoing delivery. Lives on the stack of Deliver(), so that it outlives the bus if a subscriber
+	 * destroys it.
+	 */
+	struct FDelivery
+	{
+		/** If true, the bus is still alive, false if it has been destroyed by a subscriber. */
+		bool bIsBusAlive = true;
+
+		/** Channel being delivered. Left for the delivery to delete if the bus is destroyed. */
+		FChannelBase* Channel = nullptr;
+	};
+
+	/**
+	 * Add a channel, unless another thread has just added it.
+	 * @param	EventTypeId identifier of the event type.
+	 * @param	NewChannel channel to add. Deleted if another one has been added in the meantime.
+	 * @return	Channel of the event type.
+	 */
+	FChannelBase* AddChannel(int32 EventTypeId, FChannelBase* NewChannel);
+
+public:
+	/** Max number of event types. */
+	static constexpr int32 MaxEventTypes = 1024;
+
+private:
+	/** Channels by event type identifier. */
+	std::atomic<FChannelBase*> Channels[MaxEventTypes];
+
+	/** Ongoing delivery. nullptr if not delivering. */
+	FDelivery* Delivery = nullptr;
+};
@@ -0,0 +1,258 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CommonSubsystems.h"
+#include "Containers/ContainerAllocationPolicies.h"
+
+/**
+ * Linear allocator for temporary allocations made during a single tick.
+ *
+ * Allocations only bump an offset in a fixed size block, and are all released at once on Reset(). Allocations that
+ * don't fit in the block fall back to the heap, and are freed on Reset() as well. The block is allocated on first use.
+ *
+ * Tick components with a FrameArenaSize get an arena of their own, made current for the duration of their tick, and
+ * reset right after it. Since a component ticks on a single thread at a time, this holds for parallel ticks as well.
+ * Containers using FCommonFrameArenaAllocator allocate from the current arena, and mustn't outlive the tick.
+ *
+ * Example:
+ *	TArray<FVector, FCommonFrameArenaAllocator> Locations;
+ *	TMap<int32, float, FCommonFrameArenaSetAllocator> Weights;
+ */
+class COMMONSUBSYSTEMS_API FCommonFrameArena
+	: public FNoncopyable
+{
+public:
+	/**
+	 * Makes an arena current on this thread for its lifetime, and resets it afterwards.
+	 */
+	struct COMMONSUBSYSTEMS_API FScope
+	{
+	public:
+		/**
+		 * @param	InArena arena to make current. If nullptr, there's no current arena in the scope.
+		 */
+		explicit FScope(FCommonFrameArena* InArena);
+		~FScope();
+
+	private:
+		/** Arena made current. */
+		FCommonFrameArena* Arena = nullptr;
+
+		/** Arena that was current before the scope. */
+		FCommonFrameArena* PreviousArena = nullptr;
+	};
+
+public:
+	/**
+	 * @param	InCapacity size of the block in bytes.
+	 */
+	explicit FCommonFrameArena(SIZE_T InCapacity);
+	~FCommonFrameArena();
+
+	/**
+	 * Get arena current on this thread.
+	 * @return	Current arena. nullptr if there's none.
+	 */
+	static FCommonFrameArena* GetCurrent();
+
+	/**
+	 * Allocate memory released on the next Reset().
+	 * @param	Size number of bytes to allocate.
+	 * @param	Alignment alignment of the allocation. DEFAULT_ALIGNMENT means 16 bytes.
+	 * @return	Allocated memory.
+	 */
+	void* Allocate(SIZE_T Size, uint32 Alignment = DEFAULT_ALIGNMENT);
+
+	/**
+	 * Release all the allocations at once. Memory allocated before mustn't be used anymore.
+	 */
+	void Reset();
+
+	/**
+	 * Get size of the block in bytes.
+	 * @return	Block capacity.
+	 */
+	SIZE_T GetCapacity() const;
+
+	/**
+	 * Get most memory allocated between two resets in bytes, heap fallback included.
+	 * @return	High-water mark.
+	 */
+	SIZE_T GetHighWaterBytes() const;
+
+	/**
+	 * Get number of allocations that haven't fit in the block and have fallen back to the heap.
+	 * @return	Number of overflows since the arena has been created.
+	 */
+	int32 GetNumOverflows() const;
+
+private:
+	/** Block allocations are bumped from. nullptr until first used. */
+	uint8* Memory = nullptr;
+
+	/** Size of the block in bytes. */
+	SIZE_T Capacity = 0;
+
+	/** Offset of the first free byte in the block. */
+	SIZE_T Offset = 0;
+
+	/** Allocations that have fallen back to the heap since the last reset. */
+	TArray<void*> OverflowAllocations;
+
+	/** Bytes allocated from the heap since the last reset. */
+	SIZE_T OverflowBytes = 0;
+
+	/** Most memory allocated between two resets in bytes. */
+	SIZE_T HighWaterBytes = 0;
+
+	/** Number of allocations that have fallen back to the heap. */
+	int32 NumOverflows = 0;
+};
+
+/**
+ * Container allocator allocating from the frame arena current when the container grows. Without a current arena, it
+ * allocates from the heap instead, and frees it like the default allocator would. Elements are relocated with a
+ * memcpy, so it only suits the element types UE containers can relocate.
+ * @see		FCommonFrameArena
+ */
+template<uint32 Alignment = DEFAULT_ALIGNMENT>
+class TCommonFrameArenaAllocator
+{
+public:
+	using SizeType = int32;
+
+	enum { NeedsElementType = false };
+	enum { RequireRangeCheck = true };
+
+	class ForAnyElementType
+	{
+	public:
+		ForAnyElementType() = default;
+		ForAnyElementType(const ForAnyElementType&) = delete;
+		ForAnyElementType& operator=(const ForAnyElementType&) = delete;
+
+		~ForAnyElementType()
+		{
+			if (bIsHeapAllocation)
+			{
+				FMemory::Free(Data);
+			}
+		}
+
+		void MoveToEmpty(ForAnyElementType& Other)
+		{
+			checkSlow(this != &Other);
+
+			if (bIsHeapAllocation)
+			{
+				FMemory::Free(Data);
+			}
+
+			Data = Other.Data;
+			bIsHeapAllocation = Other.bIsHeapAllocation;
+
+			Other.Data = nullptr;
+			Other.bIsHeapAllocation = false;
+		}
+
+		FScriptContainerElement* GetAllocation() const
+		{
+			return Data;
+		}
+
+		void ResizeAllocation(SizeType PreviousNumElements, SizeType NumElements, SIZE_T NumBytesPerElement)
+		{
+			FScriptContainerElement* OldData = Data;
+			const bool bWasHeapAllocation = bIsHeapAllocation;
+
+			Data = nullptr;
+			bIsHeapAllocation = false;
+
+			if (NumElements > 0)
+			{
+				const SIZE_T NumBytes = NumElements * NumBytesPerElement;
+				if (FCommonFrameArena* Arena = FCommonFrameArena::GetCurrent())
+				{
+					Data = static_cast<FScriptContainerElement*>(Arena->Allocate(NumBytes, Alignment));
+				}
+				else
+				{
+					Data = static_cast<FScriptContainerElement*>(FMemory::Malloc(NumBytes, Alignment));
+					bIsHeapAllocation = true;
+				}
+
+				if (OldData && PreviousNumElements > 0)
+				{
+					const SIZE_T NumCopiedElements = FMath::Min(NumElements, PreviousNumElements);
+					FMemory::Memcpy(Data, OldData, NumCopiedElements * NumBytesPerElement);
+				}
+			}
+
+			// Arena memory is released along with the arena
+			if (bWasHeapAllocation)
+			{
+				FMemory::Free(OldData);
+			}
+		}
+
+		SizeType CalculateSlackReserve(SizeType NumElements, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackReserve(NumElements, NumBytesPerElement, false, Alignment);
+		}
+
+		SizeType CalculateSlackShrink(SizeType NumElements, SizeType NumAllocatedElements,
+			SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackShrink(NumElements, NumAllocatedElements, NumBytesPerElement, false,
+				Alignment);
+		}
+
+		SizeType CalculateSlackGrow(SizeType NumElements, SizeType NumAllocatedElements,
+			SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackGrow(NumElements, NumAllocatedElements, NumBytesPerElement, false,
+				Alignment);
+		}
+
+		SIZE_T GetAllocatedSize(SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const
+		{
+			return NumAllocatedElements * NumBytesPerElement;
+		}
+
+		bool HasAllocation() const
+		{
+			return Data != nullptr;
+		}
+
+		SizeType GetInitialCapacity() const
+		{
+			return 0;
+		}
+
+	private:
+		/** Elements. */
+		FScriptContainerElement* Data = nullptr;
+
+		/** If true, the elements have been allocated from the heap, and have to be freed, false otherwise. */
+		bool bIsHeapAllocation = false;
+	};
+
+	template<typename ElementType>
+	class ForElementType
+		: public ForAnyElementType
+	{
+	public:
+		ElementType* GetAllocation() const
+		{
+			return reinterpret_cast<ElementType*>(ForAnyElementType::GetAllocation());
+		}
+	};
+};
+
+/** Frame arena allocator for arrays. */
+using FCommonFrameArenaAllocator = TCommonFrameArenaAllocator<>;
+
+/** Frame arena allocator for sets and maps. */
+using FCommonFrameArenaSetAllocator = TSetAllocator<
+	TSparseArrayAllocator<FCommonFrameArenaAllocator, FCommonFrameArenaAllocator>, FCommonFrameArenaAllocator>;
@@ -0,0 +1,357 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include <atomic>
+
+class AActor;
+class FCommonRegistryDeleteListener;
+
+/**
+ * Generational handle to an entry of a registry component. Stays valid while the entry is moved around the dense
+ * storage, and stops referring to anything once the entry is unregistered.
+ */
+struct COMMONSUBSYSTEMS_API FCommonRegistryHandle
+{
+	friend class FCommonRegistryComponentBase;
+
+public:
+	/**
+	 * Check whether the handle has ever referred to an entry. It doesn't mean the entry is still registered.
+	 * @return	If true, handle is set, false otherwise.
+	 */
+	bool IsValid() const;
+
+	/**
+	 * Make the handle not refer to any entry.
+	 */
+	void Invalidate();
+
+	bool operator==(const FCommonRegistryHandle& Other) const;
+	bool operator!=(const FCommonRegistryHandle& Other) const;
+
+private:
+	/** Index of the entry's sparse slot. */
+	uint32 Index = MAX_uint32;
+
+	/** Generation of the slot at the moment the entry has been registered. */
+	uint32 Generation = 0;
+};
+
+/**
+ * Type independent part of a registry component. Keeps the sparse set of handles, the dense list of registered
+ * objects, and removes the entries of destroyed objects.
+ *
+ * @see		TCommonRegistryComponent
+ */
+class COMMONSUBSYSTEMS_API FCommonRegistryComponentBase
+{
+	friend class FCommonRegistryDeleteListener;
+
+public:
+	FCommonRegistryComponentBase();
+	virtual ~FCommonRegistryComponentBase();
+
+	UE_NONCOPYABLE(FCommonRegistryComponentBase);
+
+	/**
+	 * Unregister an entry. The last entry is moved into its place.
+	 * @param	Handle handle to the entry to unregister.
+	 * @return	If true, entry has been unregistered, false if it wasn't registered.
+	 */
+	bool Unregister(FCommonRegistryHandle Handle);
+
+	/**
+	 * Unregister the entry of an object.
+	 * @param	Object object to unregister.
+	 * @return	If true, entry has been unregistered, false if it wasn't registered.
+	 */
+	bool Unregister(const UObject& Object);
+
+	/**
+	 * Check whether a handle refers to a registered entry.
+	 * @param	Handle handle to check.
+	 * @return	If true, entry is registered, false otherwise.
+	 */
+	bool IsRegistered(FCommonRegistryHandle Handle) const;
+
+	/**
+	 * Find the handle of an object's entry.
+	 * @param	Object object to look for.
+	 * @return	Handle to the entry if registered, invalid handle otherwise.
+	 */
+	FCommonRegistryHandle FindHandle(const UObject& Object) const;
+
+	/**
+	 * Get the current position of an entry in the dense storage. It changes as other entries are unregistered.
+	 * @param	Handle handle to the entry.
+	 * @return	Dense index if registered, INDEX_NONE otherwise.
+	 */
+	int32 GetDenseIndex(FCommonRegistryHandle Handle) const;
+
+	/**
+	 * Get number of registered entries.
+	 * @return	Number of registered entries.
+	 */
+	int32 Num() const;
+
+	/**
+	 * Remove the entries of objects that have been deleted since the last flush. Done automatically on registration,
+	 * unregistration and iteration.
+	 */
+	void Flush();
+
+	/**
+	 * Unregister all the entries.
+	 */
+	void Reset();
+
+	/**
+	 * Iterate the dense storage in chunks of contiguous entries. Entries must not be registered or unregistered while
+	 * iterating.
+	 *
+	 * Example:
+	 *	Registry.ForEachChunk(256, [&](int32 StartIndex, int32 EndIndex)
+	 *	{
+	 *		for (int32 Index = StartIndex; Index < EndIndex; Index++) { Velocities[Index] += Accelerations[Index]; }
+	 *	}, true);
+	 *
+	 * @param	ChunkSize max number of entries per chunk.
+	 * @param	Callback function receiving a chunk's first dense index, and the one after its last.
+	 * @param	bParallel if true, chunks are processed in parallel on the task graph. Callback has to be thread-safe.
+	 */
+	void ForEachChunk(int32 ChunkSize, TFunctionRef<void(int32 StartIndex, int32 EndIndex)> Callback,
+		bool bParallel = false);
+
+protected:
+	/**
+	 * Add an entry for an object, or find the existing one.
+	 * @param	Object object to register.
+	 * @param	bOutWasAdded output parameter. If true, a new entry has been added at the end of the dense storage.
+	 * @return	Handle to the entry.
+	 */
+	FCommonRegistryHandle AddEntry(UObject& Object, bool& bOutWasAdded);
+
+	/**
+	 * Get an entry's object. Thread-safe as long as entries aren't registered or unregistered meanwhile.
+	 * @param	DenseIndex dense index of the entry.
+	 * @return	Registered object. nullptr if it has been deleted since the last flush.
+	 */
+	UObject* GetObjectAt(int32 DenseIndex) const;
+
+	/**
+	 * Add a default constructed element at the end of each data column.
+	 */
+	virtual void AddDataDefaulted() = 0;
+
+	/**
+	 * Remove an element of each data column, and move the last element into its place.
+	 * @param	DenseIndex index of the element to remove.
+	 */
+	virtual void RemoveDataAtSwap(int32 DenseIndex) = 0;
+
+	/**
+	 * Remove all the elements of each data column.
+	 */
+	virtual void ResetData() = 0;
+
+private:
+	/**
+	 * Called by the shared delete listener when an object is deleted. May be called from any thread.
+	 * @param	ObjectIndex UObject array index of the deleted object.
+	 */
+	void OnObjectDeleted(int32 ObjectIndex);
+
+	/**
+	 * Find the sparse slot a handle refers to.
+	 * @param	Handle handle to the entry.
+	 * @return	Slot index if registered, INDEX_NONE otherwise.
+	 */
+	int32 FindSlot(FCommonRegistryHandle Handle) const;
+
+	/**
+	 * Remove an entry from the dense storage, and free its sparse slot.
+	 * @param	SlotIndex index of the entry's slot.
+	 */
+	void RemoveEntry(int32 SlotIndex);
+
+	/**
+	 * Make sure the entries of a world's destroyed actors are removed as soon as they're destroyed.
+	 * @param	Actor registered actor.
+	 */
+	void WatchActorDestruction(const AActor& Actor);
+
+	/**
+	 * Called when an actor of the watched world is destroyed.
+	 * @param	Actor destroyed actor.
+	 */
+	void OnActorDestroyed(AActor* Actor);
+
+	/**
+	 * Stop watching the world's actors' destruction.
+	 */
+	void UnwatchActorDestruction();
+
+private:
+	struct FSlot
+	{
+		/** Index of the entry in the dense storage. INDEX_NONE if free. */
+		int32 DenseIndex = INDEX_NONE;
+
+		/** Incremented each time the slot is freed. */
+		uint32 Generation = 0;
+	};
+
+	/** Sparse slots, both used and free. */
+	TArray<FSlot> Slots;
+
+	/** Free sparse slots. */
+	TArray<int32> FreeSlots;
+
+	/** Registered objects, in dense order. Objects deleted since the last flush are dangling until then. */
+	TArray<UObject*> DenseObjects;
+
+	/** Sparse slots of the entries, in dense order. */
+	TArray<int32> DenseSlots;
+
+	/** Handles to the entries of registered objects by their UObject array index. Guarded by CriticalSection. */
+	TMap<int32, FCommonRegistryHandle> ObjectHandles;
+
+	/** Handles to the entries of objects that have been deleted since the last flush. Guarded by CriticalSection. */
+	TArray<FCommonRegistryHandle> DeletedEntries;
+
+	/** Guards the state that the garbage collector touches from any thread. */
+	mutable FCriticalSection CriticalSection;
+
+	/** If true, there are deleted entries to flush, false otherwise. */
+	std::atomic<bool> bHasDeletedEntries = false;
+
+	/** World whose actors' destruction is watched. */
+	TWeakObjectPtr<UWorld> WatchedWorld;
+
+	/** Delegate associated with FCommonRegistryComponentBase::OnActorDestroyed(). */
+	FDelegateHandle ActorDestroyedDelegateHandle;
+};
+
+/**
+ * Registry component. Sparse set of objects owned by a subsystem, replacing arrays of weak pointers walked every tick.
+ *
+ * Each registered object gets a generational handle, and a row of per-entry data kept column by column in contiguous
+ * arrays, so that ticks iterate plain memory without resolving weak pointers, and can be split into chunks processed
+ * in parallel. Unregistering moves the last entry into the freed place, so the dense storage never has holes. Entries
+ * of destroyed objects are removed automatically: actors' as soon as they're destroyed, other objects' once the
+ * garbage collector deletes them.
+ *
+ * Example:
+ *	TCommonRegistryComponent<AActor, FVector, float> Projectiles;
+ *	const FCommonRegistryHandle Handle = Projectiles.Register(*Projectile, Velocity, Lifetime);
+ *	TArrayView<FVector> Velocities = Projectiles.GetColumn<0>();
+ *
+ * Game thread only, except for the chunk callbacks.
+ *
+ * @param	ObjectType type of the registered objects.
+ * @param	ColumnTypes types of the per-entry data columns.
+ */
+template<typename ObjectType, typename... ColumnTypes>
+class TCommonRegistryComponent
+	: public FCommonRegistryComponentBase
+{
+	static_assert(TIsDerivedFrom<ObjectType, UObject>::Value, "Only objects can be registered.");
+
+public:
+	template<uint32 Column>
+	using TColumnType = typename TTupleElement<Column, TTuple<ColumnTypes...>>::Type;
+
+	using FCommonRegistryComponentBase::Unregister;
+
+	/**
+	 * Register an object, or overwrite the data of the existing entry.
+	 * @param	Object object to register.
+	 * @param	Values per-entry data, one value per column.
+	 * @return	Handle to the entry.
+	 */
+	FCommonRegistryHandle Register(ObjectType& Object, ColumnTypes... Values)
+	{
+		bool bWasAdded = false;
+		const FCommonRegistryHandle Handle = AddEntry(Object, OUT bWasAdded);
+		SetData(GetDenseIndex(Handle), TMakeIntegerSequence<uint32, sizeof...(ColumnTypes)>(), MoveTemp(Values)...);
+		return Handle;
+	}
+
+	/**
+	 * Get an entry's object. Thread-safe as long as entries aren't registered or unregistered meanwhile.
+	 * @param	DenseIndex dense index of the entry.
+	 * @return	Registered object. nullptr if it has been deleted since the last flush.
+	 */
+	ObjectType* GetObject(int32 DenseIndex) const
+	{
+		auto* Object = static_cast<ObjectType*>(GetObjectAt(DenseIndex));
+		return Object;
+	}
+
+	/**
+	 * Get a data column in dense order. Invalidated by registration and unregistration.
+	 * @return	Data column.
+	 */
+	template<uint32 Column>
+	TArrayView<TColumnType<Column>> GetColumn()
+	{
+		Flush();
+
+		TArrayView<TColumnType<Column>> ColumnView = Columns.template Get<Column>();
+		return ColumnView;
+	}
+
+	/**
+	 * Find an entry's data.
+	 * @param	Handle handle to the entry.
+	 * @return	Data of the given column if registered, nullptr otherwise.
+	 */
+	template<uint32 Column>
+	TColumnType<Column>* Find(FCommonRegistryHandle Handle)
+	{
+		const int32 DenseIndex = GetDenseIndex(Handle);
+		if (DenseIndex == INDEX_NONE)
+		{
+			return nullptr;
+		}
+
+		auto& Value = Columns.template Get<Column>()[DenseIndex];
+		return &Value;
+	}
+
+protected:
+	//~FCommonRegistryComponentBase Interface
+	virtual void AddDataDefaulted() override
+	{
+		VisitTupleElements([](auto& ColumnArray) { ColumnArray.AddDefaulted(); }, Columns);
+	}
+
+	virtual void RemoveDataAtSwap(int32 DenseIndex) override
+	{
+		VisitTupleElements([DenseIndex](auto& ColumnArray)
+		{
+			ColumnArray.RemoveAtSwap(DenseIndex, 1, /*bAllowShrinking*/ false);
+		}, Columns);
+	}
+
+	virtual void ResetData() override
+	{
+		VisitTupleElements([](auto& ColumnArray) { ColumnArray.Reset(); }, Columns);
+	}
+	//~End of FCommonRegistryComponentBase Interface
+
+private:
+	template<uint32... Indices>
+	void SetData(int32 DenseIndex, TIntegerSequence<uint32, Indices...>, ColumnTypes&&... Values)
+	{
+		((Columns.template Get<Indices>()[DenseIndex] = MoveTemp(Values)), ...);
+	}
+
+private:
+	/** Per-entry data, column by column, in dense order. */
+	TTuple<TArray<ColumnTypes>...> Columns;
+};
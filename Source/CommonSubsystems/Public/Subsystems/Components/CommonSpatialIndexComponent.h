@@ -0,0 +1,171 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Immutable state of a spatial index at the moment it's been committed.
+ *
+ * Entries are bucketed in a uniform grid of cubic cells, and stored cell by cell in contiguous arrays. Since a snapshot
+ * never changes, it can be queried from any number of threads without locking.
+ */
+class COMMONSUBSYSTEMS_API FCommonSpatialSnapshot
+{
+	friend class FCommonSpatialIndexComponent;
+
+public:
+	/**
+	 * Get number of entries.
+	 * @return	Number of entries.
+	 */
+	int32 Num() const;
+
+	/**
+	 * Find the entries within a sphere.
+	 * @param	Center center of the sphere.
+	 * @param	Radius radius of the sphere.
+	 * @param	OutIds output parameter. IDs of the found entries are appended to it, in no particular order.
+	 */
+	void QueryRadius(const FVector& Center, double Radius, TArray<uint64>& OutIds) const;
+
+	/**
+	 * Find the entries within a box.
+	 * @param	Box box to look in.
+	 * @param	OutIds output parameter. IDs of the found entries are appended to it, in no particular order.
+	 */
+	void QueryBox(const FBox& Box, TArray<uint64>& OutIds) const;
+
+	/**
+	 * Find the entries nearest to a location.
+	 * @param	Center location to measure the distance from.
+	 * @param	MaxCount max number of entries to find.
+	 * @param	OutIds output parameter. IDs of the found entries are appended to it, nearest first.
+	 * @param	MaxRadius entries further than this are ignored.
+	 */
+	void QueryNearest(const FVector& Center, int32 MaxCount, TArray<uint64>& OutIds,
+		double MaxRadius = UE_BIG_NUMBER) const;
+
+private:
+	/**
+	 * Get the cell a location falls into.
+	 * @param	Location location to get the cell of.
+	 * @return	Cell coordinates.
+	 */
+	FIntVector GetCell(const FVector& Location) const;
+
+	/**
+	 * Call a function for each entry of a cell, if the cell isn't empty.
+	 * @param	Cell cell coordinates.
+	 * @param	Callback function receiving the entry's index.
+	 */
+	void ForEachEntryInCell(const FIntVector& Cell, TFunctionRef<void(int32 EntryIndex)> Callback) const;
+
+private:
+	struct FCellRange
+	{
+		/** Index of the cell's first entry. */
+		int32 Start = 0;
+
+		/** Number of entries in the cell. */
+		int32 Num = 0;
+	};
+
+	/** Edge length of a cell. */
+	double CellSize = 1000.0;
+
+	/** Inverse of the cell size. */
+	double InvCellSize = 0.001;
+
+	/** Entries' locations, cell by cell. */
+	TArray<FVector> Locations;
+
+	/** Entries' IDs, cell by cell. */
+	TArray<uint64> Ids;
+
+	/** Ranges of entries of the non-empty cells. */
+	TMap<FIntVector, FCellRange> Cells;
+
+	/** Lowest coordinates of the non-empty cells. */
+	FIntVector MinCell = FIntVector::ZeroValue;
+
+	/** Highest coordinates of the non-empty cells. */
+	FIntVector MaxCell = FIntVector::ZeroValue;
+};
+
+/**
+ * Spatial index component. Answers "which entries are near X" queries for a subsystem tracking a large number of
+ * moving things, replacing linear scans over them.
+ *
+ * Location changes are staged, and published in bulk once per tick by Commit() as a new immutable snapshot. The game
+ * thread can query the latest snapshot directly, and worker threads can be handed a snapshot to query lock-free while
+ * the next changes are being staged. The grid's cell size is chosen per index, and should be about the radius of the
+ * most frequent queries.
+ *
+ * Example:
+ *	SpatialIndex.Update(reinterpret_cast<uint64>(Unit), Unit->GetActorLocation());
+ *	SpatialIndex.Commit();
+ *	SpatialIndex.GetSnapshot()->QueryRadius(Location, 500.0, OUT NearbyUnitIds);
+ *
+ * Staging and committing aren't thread-safe.
+ */
+class COMMONSUBSYSTEMS_API FCommonSpatialIndexComponent
+{
+public:
+	using FSnapshotRef = TSharedRef<const FCommonSpatialSnapshot, ESPMode::ThreadSafe>;
+
+public:
+	/**
+	 * @param	InCellSize edge length of a grid cell.
+	 */
+	explicit FCommonSpatialIndexComponent(double InCellSize = 1000.0);
+
+	/**
+	 * Stage an entry's location. Adds the entry if it doesn't exist yet.
+	 * @param	Id unique identifier of the entry, e.g. index or address of what it represents.
+	 * @param	Location new location of the entry.
+	 */
+	void Update(uint64 Id, const FVector& Location);
+
+	/**
+	 * Stage an entry's removal.
+	 * @param	Id identifier of the entry to remove.
+	 */
+	void Remove(uint64 Id);
+
+	/**
+	 * Stage the removal of all the entries.
+	 */
+	void Reset();
+
+	/**
+	 * Get number of staged entries.
+	 * @return	Number of entries the next snapshot will have.
+	 */
+	int32 Num() const;
+
+	/**
+	 * Publish the staged changes as a new snapshot. Does nothing if nothing has changed.
+	 * @return	If true, new snapshot has been published, false otherwise.
+	 */
+	bool Commit();
+
+	/**
+	 * Get the latest snapshot. The snapshot stays valid and unchanged for as long as it's referenced.
+	 * @return	Latest committed snapshot.
+	 */
+	FSnapshotRef GetSnapshot() const;
+
+private:
+	/** Edge length of a grid cell. */
+	double CellSize = 1000.0;
+
+	/** Staged locations of the entries. */
+	TMap<uint64, FVector> StagedLocations;
+
+	/** If true, staged locations differ from the latest snapshot, false otherwise. */
+	bool bIsDirty = false;
+
+	/** Latest committed snapshot. */
+	FSnapshotRef Snapshot;
+};
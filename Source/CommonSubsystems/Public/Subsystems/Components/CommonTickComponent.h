@@ -2,18 +2,110 @@
 
 #pragma once
 
-#include "Containers/Ticker.h"
+#include "CommonSubsystems.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/Components/CommonFrameArena.h"
+#include "Subsystems/Components/CommonTimerWheel.h"
+
+class FCommonTickScheduler;
+struct FCommonTickShard;
+struct FCommonWorldTickFunction;
+
+/**
+ * What drives the ticking of a tick component.
+ */
+enum class ECommonTickBackend : uint8
+{
+	/** Core ticker, through the shared scheduler. Ticks regardless of the world state, with real time. */
+	Scheduler,
+
+	/**
+	 * World tick function in the given tick group. Doesn't tick while the world is paused or not ticking, and receives
+	 * dilated time. Tick budget yielding, prerequisites and thread-safe parallel ticking don't apply.
+	 */
+	World,
+};
+
+/**
+ * Time a single tick is allowed to spend.
+ *
+ * Long running ticks can check it periodically, and yield to continue the work on the next frame.
+ */
+struct COMMONSUBSYSTEMS_API FCommonTickBudget
+{
+public:
+	FCommonTickBudget() = default;
+	FCommonTickBudget(double InStartTime, double InEndTime);
+
+	/**
+	 * Check whether the budget has been used up.
+	 * @return	If true, there's no time left, false otherwise.
+	 */
+	bool IsExhausted() const;
+
+	/**
+	 * Get remaining time in seconds.
+	 * @return	Time left before the budget is used up. Never negative.
+	 */
+	double GetRemainingSeconds() const;
+
+	/**
+	 * Get time spent since the tick has started in seconds.
+	 * @return	Time spent since the tick has started.
+	 */
+	double GetElapsedSeconds() const;
+
+	/**
+	 * Ask to be ticked again on the next frame regardless of the tick interval, to resume the unfinished work.
+	 */
+	void Yield();
+
+	/**
+	 * Check whether the tick has asked to be resumed on the next frame.
+	 * @return	If true, tick has yielded, false otherwise.
+	 */
+	bool HasYielded() const;
+
+private:
+	/** Platform time the tick has started at. */
+	double StartTime = 0.0;
+
+	/** Platform time the budget is used up at. */
+	double EndTime = TNumericLimits<double>::Max();
+
+	/** If true, tick has asked to be resumed on the next frame, false otherwise. */
+	bool bHasYielded = false;
+};
 
 /**
  * Tick component.
+ *
+ * All tick components share a single core ticker entry owned by FCommonTickScheduler.
  */
 struct COMMONSUBSYSTEMS_API FCommonTickComponent
 {
+	friend FCommonTickScheduler;
+	friend FCommonWorldTickFunction;
+
 public:
 	DECLARE_DELEGATE_OneParam(
 		FTickSignature,
 		float DeltaSeconds);
 
+	DECLARE_DELEGATE_TwoParams(
+		FBudgetedTickSignature,
+		float DeltaSeconds,
+		FCommonTickBudget& Budget);
+
+	DECLARE_DELEGATE_TwoParams(
+		FFixedTickSignature,
+		float StepSeconds,
+		int32 NumSteps);
+
+	DECLARE_DELEGATE_OneParam(
+		FTimersExpiredSignature,
+		TConstArrayView<FCommonExpiredTimer> ExpiredTimers);
+
 public:
 	virtual ~FCommonTickComponent();
 
@@ -21,8 +113,16 @@ protected:
 	/**
 	 * Custom initilization function.
 	 * @param	Callback callback to execute each tick.
+	 * @param	TickWorld world to tick with. Required by the world tick backend only.
 	 */
-	void Tick_Initialize(const FTickSignature& Callback);
+	void Tick_Initialize(const FTickSignature& Callback, UWorld* TickWorld = nullptr);
+
+	/**
+	 * Custom initilization function.
+	 * @param	Callback callback to execute each tick. Receives the time budget it's allowed to spend.
+	 * @param	TickWorld world to tick with. Required by the world tick backend only.
+	 */
+	void Tick_Initialize(const FBudgetedTickSignature& Callback, UWorld* TickWorld = nullptr);
 
 	/**
 	 * Custom deinitilization function.
@@ -41,6 +141,23 @@ protected:
 	 */
 	void SetTickIntervalTime(float InTickInterval);
 
+	/**
+	 * Make this component tick only after a given one has ticked, if both are ticking in the same frame.
+	 * @param	Prerequisite component that has to tick first.
+	 */
+	void AddTickPrerequisite(FCommonTickComponent& Prerequisite);
+
+	/**
+	 * Remove a tick dependency added with AddTickPrerequisite().
+	 * @param	Prerequisite component to not depend on anymore.
+	 */
+	void RemoveTickPrerequisite(FCommonTickComponent& Prerequisite);
+
+	/**
+	 * Remove all tick dependencies from and to this component.
+	 */
+	void ClearTickPrerequisites();
+
 	/**
 	 * Check whether this subsystem is ticking.
 	 * @return	True if subsystem is ticking, false otherwise.
@@ -53,12 +170,114 @@ protected:
 	 */
 	float GetTickIntervalTime() const;
 
+	/**
+	 * Get tick interval time in seconds the component currently ticks at. Differs from GetTickIntervalTime() when the
+	 * adaptive tick interval has stretched it.
+	 * @return	Interval between ticks. 0 means one frame of interval.
+	 */
+	float GetEffectiveTickIntervalTime() const;
+
+	/**
+	 * Get how relevant the ticking currently is. Used by the adaptive tick interval: irrelevant components tick at
+	 * MaxTickInterval, fully relevant ones tick at their tick interval unless the load stretches it.
+	 * @return	Relevance between 0 and 1.
+	 */
+	virtual float GetTickRelevance() const;
+
+	/**
+	 * Get load of whatever the component ticks for, e.g. its world. Used by the adaptive tick interval along with the
+	 * frame time pressure, whichever is higher.
+	 * @return	Load between 0 and 1.
+	 */
+	virtual float GetTickLoad() const;
+
+	/**
+	 * Set the callback receiving fixed steps when bTickFixedStep is set. Steps are accumulated with the tick, and all
+	 * the whole steps are passed at once, before the tick callback.
+	 * @param	Callback callback to execute with the step length and the number of steps to simulate.
+	 */
+	void FixedTick_Initialize(const FFixedTickSignature& Callback);
+
+	/**
+	 * Get how far the accumulated time is into the next fixed step. Used to interpolate between the last two
+	 * simulated states for presentation.
+	 * @return	Alpha between 0 and 1.
+	 */
+	float GetFixedTickAlpha() const;
+
+	/**
+	 * Get number of fixed steps that have been dropped due to MaxFixedTickSubsteps since the ticking has started.
+	 * @return	Number of dropped steps.
+	 */
+	int32 GetNumDroppedFixedTicks() const;
+
+	/**
+	 * Get frame arena current during the tick. Everything allocated from it is released right after the tick.
+	 * @return	Frame arena. nullptr if FrameArenaSize is 0.
+	 */
+	FCommonFrameArena* GetFrameArena() const;
+
+	/**
+	 * Set the callback receiving expired timers. Timers advance with the tick, before the tick callback, so they're
+	 * processed at the tick interval and only while the tick is enabled.
+	 * @param	Callback callback to execute with all the timers that have expired since the last tick.
+	 */
+	void Timer_Initialize(const FTimersExpiredSignature& Callback);
+
+	/**
+	 * Add a timer.
+	 * @param	DelaySeconds time until the timer expires. Rounded up to TimerResolution.
+	 * @param	Payload user data to receive back on expiry.
+	 * @return	Handle to the new timer.
+	 */
+	FCommonTimerHandle Timer_Add(float DelaySeconds, uint64 Payload = 0);
+
+	/**
+	 * Remove a timer before it expires.
+	 * @param	Handle handle to the timer to remove. Invalidated.
+	 * @return	If true, timer has been removed, false if it wasn't active.
+	 */
+	bool Timer_Remove(FCommonTimerHandle& Handle);
+
+	/**
+	 * Check whether a timer is still waiting to expire.
+	 * @param	Handle handle to the timer to check.
+	 * @return	If true, timer is active, false otherwise.
+	 */
+	bool Timer_IsActive(FCommonTimerHandle Handle) const;
+
+	/**
+	 * Get time left until a timer expires.
+	 * @param	Handle handle to the timer.
+	 * @return	Time left in seconds. -1 if the timer isn't active.
+	 */
+	float Timer_GetRemainingTime(FCommonTimerHandle Handle) const;
+
+	/**
+	 * Get name the ticking is reported under in profiler scopes, stats and logs.
+	 * @return	Tick debug name.
+	 */
+	virtual FString GetTickDebugName() const;
+
+	/**
+	 * Get size of the memory allocated by the tick component, such as its timers and prerequisite lists.
+	 * @return	Allocated size in bytes.
+	 */
+	SIZE_T Tick_GetAllocatedSize() const;
+
 private:
+	/**
+	 * Common part of the initialization functions.
+	 * @param	TickWorld world to tick with. Required by the world tick backend only.
+	 */
+	void InitializeTicking(UWorld* TickWorld);
+
 	/**
 	 * Wrapper of Tick function.
 	 * @param	DeltaSeconds time since last tick.
+	 * @param	Budget time budget the tick is allowed to spend.
 	 */
-	bool Tick_Implementation(float DeltaSeconds);
+	void Tick_Implementation(float DeltaSeconds, FCommonTickBudget& Budget);
 
 	/**
 	 * Start ticking.
@@ -74,6 +293,15 @@ private:
 	/** Fired each tick. */
 	FTickSignature TickDelegate;
 
+	/** Fired each tick. Used instead of TickDelegate if bound. */
+	FBudgetedTickSignature BudgetedTickDelegate;
+
+	/** Fired each tick at least one fixed step has been accumulated on. */
+	FFixedTickSignature FixedTickDelegate;
+
+	/** Fired each tick some timers have expired on. */
+	FTimersExpiredSignature TimersExpiredDelegate;
+
 protected:
 	/** If true, component will start with tick enabled, false otherwise. */
 	bool bStartWithTickEnabled = false;
@@ -81,13 +309,160 @@ protected:
 	/** Initial time between ticks. 0 means one frame of interval. */
 	float TickInterval = 0.f;
 
+	/** What drives the ticking. Can't be changed after initialization. */
+	ECommonTickBackend TickBackend = ECommonTickBackend::Scheduler;
+
+	/** Tick group to tick in. Used by the world tick backend only. */
+	TEnumAsByte<ETickingGroup> TickGroup = TG_PrePhysics;
+
+	/** If true, keeps ticking while the world is paused, false otherwise. Used by the world tick backend only. */
+	bool bTickEvenWhenPaused = false;
+
+	/** Components with higher priority tick first, and are the last to be skipped when over the frame budget. */
+	int32 TickPriority = 0;
+
+	/** Maximum time in milliseconds a single tick should spend. 0 means no limit. */
+	float MaxTickTimeMs = 0.f;
+
+	/**
+	 * If true, the tick may be postponed to the next frame when the frame tick budget has been used up, false
+	 * otherwise. Postponed ticks receive all the time accumulated since the last tick.
+	 * @see		CommonSubsystems.Tick.FrameBudgetMs
+	 */
+	bool bTickWithinFrameBudget = false;
+
+	/**
+	 * If true, the tick only touches data owned by this component, and may run on a worker thread in parallel with
+	 * other thread-safe components, false otherwise. Thread-safe ticks must not change any tick settings, and are not
+	 * subject to the frame budget.
+	 * @see		CommonSubsystems.Tick.AllowParallel
+	 */
+	bool bIsTickThreadSafe = false;
+
+	/**
+	 * If true, the tick interval is stretched up to MaxTickInterval under load, or when the ticking is not relevant,
+	 * and comes back once it is again, false otherwise. Used by the scheduler tick backend only.
+	 * @see		GetTickRelevance(), GetTickLoad(), CommonSubsystems.Tick.Adaptive.TargetFrameMs
+	 */
+	bool bAdaptiveTickInterval = false;
+
+	/** Longest time between ticks the adaptive tick interval can stretch to. */
+	float MaxTickInterval = 1.f;
+
+	/**
+	 * If true, ticks in the same frames as the other aligned components of the same tick interval, false otherwise.
+	 * By default, components sharing a tick interval are given different phases, so that they don't all tick in the
+	 * same frame. Used by the scheduler tick backend only.
+	 */
+	bool bAlignTickInterval = false;
+
+	/** If true, the tick accumulates time, and passes it as fixed steps to the fixed step callback, false otherwise. */
+	bool bTickFixedStep = false;
+
+	/** Length of a fixed step in seconds. */
+	float FixedTickStep = 1.f / 30.f;
+
+	/**
+	 * Maximum number of fixed steps passed on a single tick. Time past that is dropped, so that a slow simulation
+	 * doesn't fall further behind each frame. 0 means no limit.
+	 */
+	int32 MaxFixedTickSubsteps = 8;
+
+	/** Resolution of the timers in seconds. Can't be changed once a timer has been added. */
+	float TimerResolution = 0.01f;
+
+	/**
+	 * Size in bytes of the frame arena temporary containers of the tick are allocated from. Allocations past it fall
+	 * back to the heap. 0 means no arena, so they're all allocated from the heap.
+	 * @see		FCommonFrameArenaAllocator
+	 */
+	int32 FrameArenaSize = 0;
+
 private:
-	/** Delegate handle for custom tick function. */
-	FTSTicker::FDelegateHandle TickHandle;
+	/** Timers. Created on first use. */
+	TUniquePtr<FCommonTimerWheel> TimerWheel;
+
+	/** Time accumulated towards the next fixed step. */
+	double FixedTickAccumulator = 0.0;
+
+	/** Number of fixed steps dropped due to MaxFixedTickSubsteps. */
+	int32 NumDroppedFixedTicks = 0;
+
+	/** Frame arena current during the tick. Shared with the tick, as the component might be destroyed during it. */
+	TSharedPtr<FCommonFrameArena> FrameArena;
+
+	/** Timers that have expired on the current tick. */
+	TArray<FCommonExpiredTimer> ExpiredTimers;
+
+	/** Cleared once ticking is deinitialized. Shared with the tick, as the component might be destroyed during it. */
+	TSharedPtr<bool> TickAliveFlag;
+
+	/** Tick function used by the world tick backend. */
+	TUniquePtr<FCommonWorldTickFunction> WorldTickFunction;
+
+	/** Index in the scheduler's heap. INDEX_NONE if not scheduled. */
+	int32 ScheduleIndex = INDEX_NONE;
+
+	/** Index in the scheduler's list of components being dispatched this frame. INDEX_NONE if not being dispatched. */
+	int32 DispatchIndex = INDEX_NONE;
+
+	/** Scheduler time of the last tick, or of the moment the ticking has started. */
+	double LastTickTime = 0.0;
+
+	/** Number of frames in a row the tick has been postponed due to the frame tick budget. */
+	int32 SkippedFrames = 0;
+
+	/** Components that have to tick before this one. */
+	TArray<FCommonTickComponent*> TickPrerequisites;
+
+	/** Components that have to tick after this one. */
+	TArray<FCommonTickComponent*> TickDependents;
+
+	/** Depth in the tick dependency graph. Components tick in waves of increasing depth. */
+	int32 TickLevel = 0;
+
+	/** Scheduler's graph generation TickLevel has been computed for. */
+	uint32 TickLevelGeneration = 0;
+
+	/** World the component ticks for. Groups components by world. Reset once the world is cleaned up. */
+	TWeakObjectPtr<const UWorld> TickShardWorld;
+
+	/** Shard of the world the component ticks for. Set while scheduled. */
+	FCommonTickShard* TickShard = nullptr;
+
+	/**
+	 * If true, the component can tick on its world's shard, i.e. it's thread-safe, and so are all of its prerequisites
+	 * of the same world. Computed along with TickLevel.
+	 */
+	bool bCanTickInShard = false;
+
+	/** If true, the last tick has been ticked in parallel and has asked to be resumed on the next frame. */
+	bool bHasTickYielded = false;
+
+	// Instrumentation members are there even when COMMON_SUBSYSTEMS_WITH_TICK_INSTRUMENTATION is off, so that the
+	// layout doesn't depend on what each module including this header has defined it to
+
+	/** Name used by profiler scopes and logs. Cached on initialization when instrumented. */
+	FString TickDebugName;
+
+	/** Name used by CSV stats. Cached on initialization when instrumented. */
+	FName TickCsvStatName;
+
+	/** Name used by the effective tick interval CSV stat. Cached on initialization when instrumented. */
+	FName TickIntervalCsvStatName;
+
+	/** Per-class tick cycle stat. Cached on initialization when instrumented with stats. */
+	TStatId TickStatId;
+
+	/** Name the tick's LLM tag is made from. Cached on initialization when LLM is compiled in. */
+	FName TickLlmName;
 
 	/** If true, subsystem is ticking, false otherwise. */
 	bool bIsTickEnabled = false;
 
 	/** Time between ticks. 0 means one frame of interval. */
 	float InternalTickInterval = 0.f;
+
+	/** Time between ticks the component currently ticks at. Stretched by the adaptive tick interval. */
+	float EffectiveTickInterval = 0.f;
 };
@@ -0,0 +1,215 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact handle to a timer of a FCommonTimerWheel.
+ */
+struct COMMONSUBSYSTEMS_API FCommonTimerHandle
+{
+	friend class FCommonTimerWheel;
+
+public:
+	/**
+	 * Check whether the handle has ever referred to a timer. It doesn't mean the timer is still active.
+	 * @return	If true, handle is set, false otherwise.
+	 */
+	bool IsValid() const;
+
+	/**
+	 * Make the handle not refer to any timer.
+	 */
+	void Invalidate();
+
+	bool operator==(const FCommonTimerHandle& Other) const;
+	bool operator!=(const FCommonTimerHandle& Other) const;
+
+private:
+	/** Index of the timer's slot in the pool. */
+	uint32 Index = MAX_uint32;
+
+	/** Serial number of the slot at the moment the timer has been added. */
+	uint32 Serial = 0;
+};
+
+/**
+ * Timer that has expired.
+ */
+struct FCommonExpiredTimer
+{
+	/** Handle of the expired timer. It's not active anymore. */
+	FCommonTimerHandle Handle;
+
+	/** User data the timer has been added with. */
+	uint64 Payload = 0;
+};
+
+/**
+ * Hierarchical timing wheel.
+ *
+ * Time is split into ticks of a fixed resolution. Timers are kept in intrusive lists, one per wheel slot, in a pool of
+ * contiguous nodes that are reused once free, so adding and removing a timer is O(1) and doesn't allocate once the
+ * pool is warm. The first level covers the nearest ticks one slot per tick, and each next level covers a range of
+ * ticks per slot; timers move to lower levels as their time comes closer.
+ *
+ * Expired timers are returned in bulk, so that they can be processed in a single loop.
+ *
+ * Not thread-safe.
+ */
+class COMMONSUBSYSTEMS_API FCommonTimerWheel
+{
+public:
+	/**
+	 * @param	InResolution duration of a single wheel tick in seconds. Timers expire on tick boundaries.
+	 */
+	explicit FCommonTimerWheel(float InResolution = 0.01f);
+
+	/**
+	 * Add a timer.
+	 * @param	DelaySeconds time until the timer expires. Rounded up to the resolution, at least one tick.
+	 * @param	Payload user data to receive back on expiry.
+	 * @return	Handle to the new timer.
+	 */
+	FCommonTimerHandle Add(float DelaySeconds, uint64 Payload = 0);
+
+	/**
+	 * Remove a timer before it expires.
+	 * @param	Handle handle to the timer to remove.
+	 * @return	If true, timer has been removed, false if it wasn't active.
+	 */
+	bool Remove(FCommonTimerHandle Handle);
+
+	/**
+	 * Check whether a timer is still waiting to expire.
+	 * @param	Handle handle to the timer to check.
+	 * @return	If true, timer is active, false otherwise.
+	 */
+	bool IsActive(FCommonTimerHandle Handle) const;
+
+	/**
+	 * Get time left until a timer expires.
+	 * @param	Handle handle to the timer.
+	 * @return	Time left in seconds. -1 if the timer isn't active.
+	 */
+	float GetRemainingSeconds(FCommonTimerHandle Handle) const;
+
+	/**
+	 * Get number of active timers.
+	 * @return	Number of active timers.
+	 */
+	int32 Num() const;
+
+	/**
+	 * Get size of the memory allocated by the timer nodes.
+	 * @return	Allocated size in bytes.
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+	/**
+	 * Advance time, and collect the timers that have expired.
+	 * @param	DeltaSeconds time to advance by.
+	 * @param	OutExpiredTimers output parameter. Expired timers are appended to it, earliest first. Timers that
+	 * expire on the same wheel tick are in the order they've been added.
+	 */
+	void Advance(float DeltaSeconds, TArray<FCommonExpiredTimer>& OutExpiredTimers);
+
+	/**
+	 * Remove all the timers.
+	 */
+	void Reset();
+
+private:
+	/**
+	 * Link a node at the end of the slot its expiry tick falls into.
+	 * @param	NodeIndex index of the node to link.
+	 */
+	void LinkNode(int32 NodeIndex);
+
+	/**
+	 * Unlink a node from its slot.
+	 * @param	NodeIndex index of the node to unlink.
+	 */
+	void UnlinkNode(int32 NodeIndex);
+
+	/**
+	 * Return a node to the pool.
+	 * @param	NodeIndex index of the node to free.
+	 */
+	void FreeNode(int32 NodeIndex);
+
+	/**
+	 * Move the timers of a higher level slot down to the lower levels.
+	 * @param	Level level of the slot to cascade.
+	 */
+	void Cascade(int32 Level);
+
+	/**
+	 * Find the node a handle refers to.
+	 * @param	Handle handle to the timer.
+	 * @return	Node index if the timer is active, INDEX_NONE otherwise.
+	 */
+	int32 FindNode(FCommonTimerHandle Handle) const;
+
+private:
+	struct FNode
+	{
+		/** Wheel tick the timer expires at. */
+		int64 ExpiryTick = 0;
+
+		/** User data. */
+		uint64 Payload = 0;
+
+		/** Order the timer has been added in. Keeps the timers that expire on the same tick in order. */
+		uint64 Sequence = 0;
+
+		/** Previous node in the slot. INDEX_NONE if first. */
+		int32 Prev = INDEX_NONE;
+
+		/** Next node in the slot, or in the free list. INDEX_NONE if last. */
+		int32 Next = INDEX_NONE;
+
+		/** Slot the node is linked in. INDEX_NONE if free. */
+		int32 Slot = INDEX_NONE;
+
+		/** Incremented each time the node is freed. */
+		uint32 Serial = 0;
+	};
+
+	/** Number of bits of a tick each level covers. */
+	static constexpr int32 SlotBits = 6;
+
+	/** Number of slots per level. */
+	static constexpr int32 SlotsPerLevel = 1 << SlotBits;
+
+	/** Number of levels. Timers further than the last level can cover are parked in its furthest slot. */
+	static constexpr int32 NumLevels = 5;
+
+	/** Duration of a single wheel tick in seconds. */
+	float Resolution = 0.01f;
+
+	/** Time accumulated towards the next wheel tick in seconds. */
+	float Accumulator = 0.f;
+
+	/** Current wheel tick. */
+	int64 CurrentTick = 0;
+
+	/** Sequence of the next added timer. */
+	uint64 NextSequence = 0;
+
+	/** Timer nodes, both active and free. */
+	TArray<FNode> Nodes;
+
+	/** First free node. INDEX_NONE if there are none. */
+	int32 FreeHead = INDEX_NONE;
+
+	/** Number of active timers. */
+	int32 NumActive = 0;
+
+	/** First node of each slot, level by level. INDEX_NONE if empty. */
+	int32 SlotHeads[NumLevels * SlotsPerLevel];
+
+	/** Last node of each slot, level by level. INDEX_NONE if empty. */
+	int32 SlotTails[NumLevels * SlotsPerLevel];
+};
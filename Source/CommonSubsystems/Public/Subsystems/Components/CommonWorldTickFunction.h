@@ -0,0 +1,30 @@
+// Author: Antonio Sidenko (Tonetfal), July 2023
+
+#pragma once
+
+#include "Engine/EngineBaseTypes.h"
+
+struct FCommonTickComponent;
+
+/**
+ * World tick function used by tick components that tick with their world.
+ *
+ * Unlike the scheduler, it's placed in a world tick group, doesn't tick while the world is paused or not ticking, and
+ * receives dilated time.
+ */
+struct COMMONSUBSYSTEMS_API FCommonWorldTickFunction
+	: public FTickFunction
+{
+public:
+	explicit FCommonWorldTickFunction(FCommonTickComponent& InComponent);
+
+	//~FTickFunction Interface
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	//~End of FTickFunction Interface
+
+private:
+	/** Component to tick. */
+	FCommonTickComponent& Component;
+};